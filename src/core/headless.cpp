@@ -0,0 +1,257 @@
+#include "../maths/utils.hpp"
+#include "../physics/main.hpp"
+#include "../physics/scheduler.hpp"
+#include "../training/main.hpp"
+#include "../training/recorder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <glm/glm.hpp>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace std;
+
+
+
+
+// Même scène que firstPhysicsScene, sans fenêtre ni contexte OpenGL
+double headlessPhysicsScene(unsigned int nbrSteps, double deltaTime, IntegratorType integratorType) {
+	Planet planet(9.81, 1.0 / 240, 8, integratorType);
+	cout << "Integrator: " << planet.getIntegrator().getName() << endl;
+
+	Transform stick1;
+	Transform stick2;
+	stick1.translate(-3, -6.01, 1);
+
+	vector<Mass> masses = {Mass(1, glm::vec3(-0.5, 0.5, 0)), Mass(1, glm::vec3(0.5, 0.5, 0)), Mass(1, glm::vec3(0, -0.5, 0))};
+	Solid        solid1(masses);
+	Solid        solid2(masses);
+
+	WorldObject worldObject1({}, solid1, stick1);
+	WorldObject worldObject2({}, solid2, stick2);
+
+	BallJoint joint(&worldObject1, glm::vec3(0, 3, 0), &worldObject2, glm::vec3(0, -3, 0));
+
+	Skeleton skeleton({&worldObject1, &worldObject2}, {&joint});
+	planet.add(&skeleton);
+
+	// Boucle de simulation
+	auto start = chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < nbrSteps; i++) {
+		worldObject1.applyForce(Force(glm::vec3(0, -3, 0), glm::vec3(-3, 0, 1)));
+		worldObject2.applyForce(Force(glm::vec3(0, 3, 0), glm::vec3(3, 0, -1)));
+
+		planet.step(deltaTime);
+	}
+	auto end = chrono::high_resolution_clock::now();
+
+	glm::vec3 position = stick1.getTranslation();
+	cout << "Final position of the first stick: (" << position.x << " ; " << position.y << " ; " << position.z << ")" << endl;
+
+	double duration = chrono::duration<double>(end - start).count();
+	return nbrSteps / duration;
+}
+
+
+
+// Les mêmes bâtons dupliqués dans nbrEnvironments environnements avancés en parallèle
+double vecPhysicsScene(unsigned int nbrSteps, double deltaTime, unsigned int nbrEnvironments, unsigned int nbrThreads) {
+	VecPlanet vecPlanet(nbrEnvironments, [](unsigned int) { return new SticksEnvironment(); }, deltaTime, 1, nbrThreads);
+	cout << "Environments: " << vecPlanet.getNbrEnvironments() << ", threads: " << nbrThreads << endl;
+
+	vector<float> actions(nbrEnvironments * vecPlanet.getActionSize());
+	for (unsigned int i = 0; i < nbrEnvironments; i++) {
+		float action[6] = {-3, 0, 1, 3, 0, -1};
+		copy(action, action + 6, &actions[i * 6]);
+	}
+
+	vecPlanet.reset();
+	auto start = chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < nbrSteps; i++) {
+		vecPlanet.step(actions.data());
+	}
+	auto end = chrono::high_resolution_clock::now();
+
+	double duration = chrono::duration<double>(end - start).count();
+	return (double)nbrSteps * nbrEnvironments / duration;
+}
+
+
+
+// nbrIslands chaînes de 8 sphères suspendues à un point fixe, qui se balancent sans se toucher :
+// autant d'îles indépendantes, résolues par un seul Planet sur nbrThreads threads
+double islandPhysicsScene(unsigned int nbrSteps, double deltaTime, unsigned int nbrIslands, unsigned int nbrThreads, uint64_t& hash) {
+	const unsigned int nbrLinks = 8;
+	Planet             planet(9.81, 1.0 / 240, 8);
+	ThreadPool         threadPool(nbrThreads);
+	planet.setThreadPool(&threadPool);
+	planet.getIslands().setEnabled(false);  // on mesure la résolution, pas le sommeil
+
+	vector<Transform*>   transforms;
+	vector<Solid*>       solids;
+	vector<WorldObject*> worldObjects;
+	vector<Joint*>       joints;
+	vector<Skeleton*>    skeletons;
+	SphereBoundingBox    sphere(glm::vec3(0), 0.2);
+	for (unsigned int i = 0; i < nbrIslands; i++) {
+		vector<WorldObject*> chain;
+		vector<Joint*>       chainJoints;
+		for (unsigned int j = 0; j <= nbrLinks; j++) {
+			transforms.push_back(new Transform());
+			transforms.back()->translate(3.0f * i, -1.0f * j, 0);
+			if (j == 0) {
+				solids.push_back(new Solid({Mass(1, glm::vec3(0))}, true));
+			} else {
+				solids.push_back(new Solid({Mass(1, glm::vec3(-0.1, 0, 0)), Mass(1, glm::vec3(0.1, 0, 0)), Mass(1, glm::vec3(0, 0, 0.1))}));
+			}
+			worldObjects.push_back(new WorldObject({&sphere}, *solids.back(), *transforms.back()));
+			chain.push_back(worldObjects.back());
+			if (j > 0) {
+				joints.push_back(new BallJoint(chain[j - 1], glm::vec3(0, -0.5, 0), chain[j], glm::vec3(0, 0.5, 0)));
+				chainJoints.push_back(joints.back());
+			}
+		}
+		skeletons.push_back(new Skeleton(chain, chainJoints));
+		planet.add(skeletons.back());
+		chain.back()->setSpeedVector(glm::vec3(0, 0, 2.0f + i % 5));
+	}
+
+	auto start = chrono::high_resolution_clock::now();
+	for (unsigned int s = 0; s < nbrSteps; s++) {
+		for (WorldObject* worldObject : worldObjects) {
+			Solid& solid = worldObject->getSolid();
+			worldObject->applyForce(Force(solid.getInertiaCenter(), glm::vec3(0, -9.81 * solid.getTotalMass(), 0)));
+		}
+		planet.step(deltaTime);
+	}
+	auto end = chrono::high_resolution_clock::now();
+	hash = planet.hashState();
+
+	for (Skeleton* skeleton : skeletons) {
+		planet.remove(skeleton);
+		delete skeleton;
+	}
+	for (Joint* joint : joints) {
+		delete joint;
+	}
+	for (unsigned int i = 0; i < worldObjects.size(); i++) {
+		delete worldObjects[i];
+		delete solids[i];
+		delete transforms[i];
+	}
+
+	double duration = chrono::duration<double>(end - start).count();
+	return nbrSteps / duration;
+}
+
+// Même scène de 1 à maxThreads threads (puissances de 2) : accélération par rapport à un thread,
+// et empreinte des poses finales, qui doit être identique
+void islandScaling(unsigned int nbrSteps, double deltaTime, unsigned int nbrIslands, unsigned int maxThreads) {
+	vector<unsigned int> threadCounts;
+	for (unsigned int nbrThreads = 1; nbrThreads < maxThreads; nbrThreads *= 2) {
+		threadCounts.push_back(nbrThreads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	cout << "Islands: " << nbrIslands << endl;
+	double   reference = 0;
+	uint64_t referenceHash = 0;
+	for (unsigned int nbrThreads : threadCounts) {
+		uint64_t hash;
+		double   stepsPerSecond = islandPhysicsScene(nbrSteps, deltaTime, nbrIslands, nbrThreads, hash);
+		if (nbrThreads == 1) {
+			reference = stepsPerSecond;
+			referenceHash = hash;
+		}
+		cout << "Threads: " << nbrThreads << ", steps per second: " << stepsPerSecond << ", speedup: " << stepsPerSecond / reference << "x"
+		     << (hash == referenceHash ? ", deterministic" : ", MISMATCH") << endl;
+	}
+}
+
+
+
+// Épisode de SticksEnvironment aux actions tirées par le générateur du Planet, enregistré dans path
+void recordEpisode(string const& path, unsigned int nbrSteps, uint64_t seed) {
+	SticksEnvironment environment;
+	Recorder          recorder(path, environment, seed);
+	if (!recorder.isOpen()) {
+		return;
+	}
+
+	float action[6];
+	for (unsigned int i = 0; i < nbrSteps; i++) {
+		for (unsigned int j = 0; j < 6; j++) {
+			action[j] = environment.getPlanet().getRandom().uniform(-5, 5);
+		}
+		recorder.step(action);
+	}
+	cout << "Recorded " << recorder.getNbrSteps() << " steps (seed " << seed << ") in " << path << endl;
+}
+
+int replayEpisode(string const& path) {
+	SticksEnvironment environment;
+	Replayer          replayer(path);
+	int               divergence = replayer.replay(environment);
+	if (divergence == REPLAY_IDENTICAL) {
+		cout << "Replay of " << path << " is bitwise identical" << endl;
+	}
+	return divergence == REPLAY_IDENTICAL ? 0 : -1;
+}
+
+
+
+// Utilisation : ./headless [nombre de pas] [pas de temps en secondes] [nombre d'environnements] [nombre de threads] [intégrateur] [îles]
+// ou ./headless record <fichier> [nombre de pas] [graine], ./headless replay <fichier>
+int main(int argc, char** argv) {
+	string mode = argc > 1 ? argv[1] : "";
+	if (mode == "record" && argc > 2) {
+		recordEpisode(argv[2], argc > 3 ? atoi(argv[3]) : 1000, argc > 4 ? strtoull(argv[4], nullptr, 10) : 0);
+		return 0;
+	} else if (mode == "replay" && argc > 2) {
+		return replayEpisode(argv[2]);
+	}
+
+	unsigned int   nbrSteps = argc > 1 ? atoi(argv[1]) : 1000000;
+	double         deltaTime = argc > 2 ? atof(argv[2]) : 1.0 / 1000;
+	unsigned int   nbrEnvironments = argc > 3 ? atoi(argv[3]) : 0;
+	unsigned int   nbrThreads = argc > 4 ? atoi(argv[4]) : thread::hardware_concurrency();
+	string         integratorName = argc > 5 ? argv[5] : "euler";
+	unsigned int   nbrIslands = argc > 6 ? atoi(argv[6]) : 0;
+	IntegratorType integratorType = SemiImplicitEuler;
+
+	if (integratorName == "verlet") {
+		integratorType = VelocityVerlet;
+	} else if (integratorName == "rk4") {
+		integratorType = RungeKutta4;
+	} else if (integratorName != "euler") {
+		nbrSteps = 0;
+	}
+
+	if (nbrSteps == 0 || deltaTime <= 0) {
+		cerr << "Usage: " << argv[0] << " [steps] [deltaTime] [environments] [threads] [euler|verlet|rk4] [islands]" << endl;
+		cerr << "       " << argv[0] << " record <file> [steps] [seed]" << endl;
+		cerr << "       " << argv[0] << " replay <file>" << endl;
+		return -1;
+	}
+
+	if (nbrIslands > 0) {
+		islandScaling(nbrSteps, deltaTime, nbrIslands, max(nbrThreads, 1u));
+		return 0;
+	}
+
+	double stepsPerSecond;
+	if (nbrEnvironments > 0) {
+		stepsPerSecond = vecPhysicsScene(nbrSteps, deltaTime, nbrEnvironments, nbrThreads);
+	} else {
+		stepsPerSecond = headlessPhysicsScene(nbrSteps, deltaTime, integratorType);
+	}
+	cout << "Steps per second: " << stepsPerSecond << endl;
+	cout << "Real time factor: " << stepsPerSecond * deltaTime << "x" << endl;
+	return 0;
+}
@@ -83,7 +83,7 @@ double firstPhysicsScene(GLFWwindow* window) {
 	camera.lookAt(0, 0, 0);
 
 	Planet planet;
-	Scene& scene = planet.getScene();
+	Scene  scene;
 
 	Renderer renderer(camera, scene);
 
@@ -105,6 +105,8 @@ double firstPhysicsScene(GLFWwindow* window) {
 
 	Skeleton skeleton({&worldObject1, &worldObject2}, {&joint});
 	planet.add(&skeleton);
+	scene.add(&stick1);
+	scene.add(&stick2);
 
 	// Lumières
 	PointLight pointLight1(glm::vec3(2, 1, 1), 2);
@@ -127,7 +129,7 @@ double firstPhysicsScene(GLFWwindow* window) {
 		worldObject2.applyForce(Force(glm::vec3(0, 3, 0), glm::vec3(3, 0, -1)));
 
 		planet.update();
-		renderer.render();
+		renderer.render(planet.getAlpha());
 		glfwSwapBuffers(window);
 
 		auto now = chrono::high_resolution_clock::now();
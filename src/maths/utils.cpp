@@ -6,6 +6,7 @@
 #include <glm/gtx/quaternion.hpp>
 #include <cmath>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 
 using namespace std;
@@ -251,6 +252,397 @@ UnitQuaternion::~UnitQuaternion() {}
 
 
 
+/* --- TRANSFORM --- */
+
+
+
+Transform::Transform()
+    : m_rotation(UnitQuaternion()),
+      m_translation(glm::vec3(0, 0, 0)),
+      m_scale(1.0f),
+      m_previousRotation(UnitQuaternion()),
+      m_previousTranslation(glm::vec3(0, 0, 0)),
+      m_hasPrevious(false) {}
+
+UnitQuaternion& Transform::getRotation() { return m_rotation; }
+UnitQuaternion  Transform::getRotation() const { return m_rotation; }
+glm::vec3&      Transform::getTranslation() { return m_translation; }
+glm::vec3       Transform::getTranslation() const { return m_translation; }
+glm::vec3&      Transform::getScale() { return m_scale; }
+
+Transform& Transform::setRotation(UnitQuaternion const& rotation) {
+	m_rotation = rotation;
+	return *this;
+}
+
+Transform& Transform::setTranslation(glm::vec3 const& translation) {
+	m_translation = translation;
+	return *this;
+}
+
+Transform& Transform::translate(glm::vec3 translation) {
+	m_translation += translation;
+	return *this;
+}
+
+Transform& Transform::translate(float dx, float dy, float dz) {
+	this->translate(glm::vec3(dx, dy, dz));
+	return *this;
+}
+
+Transform& Transform::rotateSelf(UnitQuaternion rotation, glm::vec3 point) {
+	m_rotation *= rotation;
+	m_translation += rotation.rotate(point) - point;
+	return *this;
+}
+
+Transform& Transform::rotateSelf(float angle, glm::vec3(axis), glm::vec3 point) {
+	this->rotateSelf(UnitQuaternion(angle, axis), point);
+	return *this;
+}
+
+Transform& Transform::rotateScene(UnitQuaternion rotation, glm::vec3 point) {
+	if (rotation.squaredLength() > 0.9) {
+		m_rotation = rotation * m_rotation;
+		m_translation += rotation.rotate(point) - point;
+	}
+	return *this;
+}
+
+Transform& Transform::rotateScene(float angle, glm::vec3(axis), glm::vec3 point) {
+	this->rotateScene(UnitQuaternion(angle, axis), point);
+	return *this;
+}
+
+glm::vec3 Transform::transform(glm::vec3 point) const {
+	glm::vec3 newPoint = (m_rotation * point * m_rotation.getConjugate()).getVector() + m_translation;
+	return newPoint;
+}
+
+glm::vec3 Transform::invertTransform(glm::vec3 point) const {
+	glm::vec3 newPoint = point - m_translation;
+	newPoint = (m_rotation.getConjugate() * newPoint * m_rotation).getVector();
+	return newPoint;
+}
+
+Transform& Transform::savePrevious() {
+	m_previousRotation = m_rotation;
+	m_previousTranslation = m_translation;
+	m_hasPrevious = true;
+	return *this;
+}
+
+// alpha = 0 : état précédent, alpha = 1 : état courant. Sans état précédent, l'état courant est renvoyé.
+glm::vec3 Transform::getInterpolatedTranslation(float alpha) const {
+	if (!m_hasPrevious || alpha >= 1) {
+		return m_translation;
+	}
+	return m_previousTranslation + (m_translation - m_previousTranslation) * alpha;
+}
+
+UnitQuaternion Transform::getInterpolatedRotation(float alpha) const {
+	if (!m_hasPrevious || alpha >= 1) {
+		return m_rotation;
+	}
+	return m_rotation.slerp(m_previousRotation, m_rotation, alpha);
+}
+
+Transform::~Transform() {}
+
+
+
+/* --- RANDOM --- */
+
+
+Random::Random(uint64_t seed) : m_seed(seed), m_state(0) { this->setSeed(seed); }
+
+uint64_t Random::getSeed() const { return m_seed; }
+
+Random& Random::setSeed(uint64_t seed) {
+	m_seed = seed;
+	uint64_t mixed = seed + 0x9e3779b97f4a7c15ull;
+	mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ull;
+	mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebull;
+	m_state = mixed ^ (mixed >> 31);
+	if (m_state == 0) {
+		m_state = 1;  // état absorbant de xorshift
+	}
+	return *this;
+}
+
+uint64_t Random::getState() const { return m_state; }
+
+Random& Random::setState(uint64_t state) {
+	if (state != 0) {
+		m_state = state;
+	}
+	return *this;
+}
+
+uint64_t Random::next() {
+	m_state ^= m_state >> 12;
+	m_state ^= m_state << 25;
+	m_state ^= m_state >> 27;
+	return m_state * 0x2545f4914f6cdd1dull;
+}
+
+// 24 bits de poids fort : exactement représentables par un float
+float Random::uniform() { return (next() >> 40) * (1.0f / 16777216); }
+
+float Random::uniform(float min, float max) { return min + (max - min) * uniform(); }
+
+Random::~Random() {}
+
+
+
+/* --- HEIGHTMAP --- */
+
+
+HeightMap::HeightMap(unsigned int nbrX, unsigned int nbrZ, float cellSize, float height)
+    : m_nbrX(max(nbrX, 2u)),
+      m_nbrZ(max(nbrZ, 2u)),
+      m_cellSize(cellSize),
+      m_heights(m_nbrX * m_nbrZ, height),
+      m_minHeight(height),
+      m_maxHeight(height) {}
+
+HeightMap::HeightMap(vector<float> const& heights, unsigned int nbrX, unsigned int nbrZ, float cellSize)
+    : HeightMap::HeightMap(nbrX, nbrZ, cellSize) {
+	if (heights.size() != m_heights.size()) {
+		cerr << "Error: Height map of " << m_nbrX << " x " << m_nbrZ << " vertices given " << heights.size() << " heights" << endl;
+	}
+	copy(heights.begin(), heights.begin() + min(heights.size(), m_heights.size()), m_heights.begin());
+	this->updateBounds();
+}
+
+HeightMap::HeightMap(string const& path, unsigned int nbrX, unsigned int nbrZ, float cellSize, float scale)
+    : HeightMap::HeightMap(nbrX, nbrZ, cellSize) {
+	ifstream file(path, ios::binary);
+	if (!file.read((char*)m_heights.data(), sizeof(float) * m_heights.size())) {
+		cerr << "Error: Could not read " << m_heights.size() << " heights from " << path << endl;
+		fill(m_heights.begin(), m_heights.end(), 0.0f);
+	}
+	for (float& height : m_heights) {
+		height *= scale;
+	}
+	this->updateBounds();
+}
+
+void HeightMap::updateBounds() {
+	auto bounds = minmax_element(m_heights.begin(), m_heights.end());
+	m_minHeight = *bounds.first;
+	m_maxHeight = *bounds.second;
+}
+
+unsigned int         HeightMap::getNbrX() const { return m_nbrX; }
+unsigned int         HeightMap::getNbrZ() const { return m_nbrZ; }
+float                HeightMap::getCellSize() const { return m_cellSize; }
+float                HeightMap::getWidth() const { return m_cellSize * (m_nbrX - 1); }
+float                HeightMap::getDepth() const { return m_cellSize * (m_nbrZ - 1); }
+float                HeightMap::getMinHeight() const { return m_minHeight; }
+float                HeightMap::getMaxHeight() const { return m_maxHeight; }
+vector<float> const& HeightMap::getHeights() const { return m_heights; }
+float                HeightMap::getHeight(unsigned int x, unsigned int z) const { return m_heights[z * m_nbrX + x]; }
+
+glm::vec3 HeightMap::getVertex(unsigned int x, unsigned int z) const {
+	return glm::vec3(x * m_cellSize, this->getHeight(x, z), z * m_cellSize);
+}
+
+HeightMap& HeightMap::setHeight(unsigned int x, unsigned int z, float height) {
+	m_heights[z * m_nbrX + x] = height;
+	m_minHeight = min(m_minHeight, height);
+	m_maxHeight = max(m_maxHeight, height);
+	return *this;
+}
+
+// Chaque octave tire une grille de valeurs dans [-1, 1] puis l'interpole (interpolation bilinéaire lissée par smoothstep)
+HeightMap& HeightMap::generate(float amplitude, float wavelength, unsigned int nbrOctaves, uint64_t seed) {
+	Random random(seed);
+	fill(m_heights.begin(), m_heights.end(), 0.0f);
+	for (unsigned int octave = 0; octave < nbrOctaves && wavelength > 0; octave++) {
+		unsigned int  nbrLatticeX = (unsigned int)ceil(this->getWidth() / wavelength) + 2;
+		unsigned int  nbrLatticeZ = (unsigned int)ceil(this->getDepth() / wavelength) + 2;
+		vector<float> lattice(nbrLatticeX * nbrLatticeZ);
+		for (float& value : lattice) {
+			value = random.uniform(-1, 1);
+		}
+
+		for (unsigned int z = 0; z < m_nbrZ; z++) {
+			float        v = z * m_cellSize / wavelength;
+			unsigned int k = min((unsigned int)v, nbrLatticeZ - 2);
+			float        t = v - k;
+			t = t * t * (3 - 2 * t);
+			for (unsigned int x = 0; x < m_nbrX; x++) {
+				float        u = x * m_cellSize / wavelength;
+				unsigned int i = min((unsigned int)u, nbrLatticeX - 2);
+				float        s = u - i;
+				s = s * s * (3 - 2 * s);
+				float low = lattice[k * nbrLatticeX + i] * (1 - s) + lattice[k * nbrLatticeX + i + 1] * s;
+				float high = lattice[(k + 1) * nbrLatticeX + i] * (1 - s) + lattice[(k + 1) * nbrLatticeX + i + 1] * s;
+				m_heights[z * m_nbrX + x] += amplitude * (low * (1 - t) + high * t);
+			}
+		}
+		amplitude *= 0.5f;
+		wavelength *= 0.5f;
+	}
+	this->updateBounds();
+	return *this;
+}
+
+void HeightMap::getCell(float x, float z, int& cellX, int& cellZ) const {
+	cellX = std::clamp((int)floor(x / m_cellSize), 0, (int)m_nbrX - 2);
+	cellZ = std::clamp((int)floor(z / m_cellSize), 0, (int)m_nbrZ - 2);
+}
+
+void HeightMap::getTriangles(unsigned int cellX, unsigned int cellZ, glm::vec3* vertices) const {
+	glm::vec3 a = this->getVertex(cellX, cellZ);
+	glm::vec3 b = this->getVertex(cellX + 1, cellZ);
+	glm::vec3 c = this->getVertex(cellX, cellZ + 1);
+	glm::vec3 d = this->getVertex(cellX + 1, cellZ + 1);
+	vertices[0] = a;
+	vertices[1] = c;
+	vertices[2] = b;
+	vertices[3] = b;
+	vertices[4] = c;
+	vertices[5] = d;
+}
+
+float HeightMap::sample(float x, float z) const {
+	int cellX;
+	int cellZ;
+	this->getCell(x, z, cellX, cellZ);
+	float u = std::clamp(x / m_cellSize - cellX, 0.0f, 1.0f);
+	float w = std::clamp(z / m_cellSize - cellZ, 0.0f, 1.0f);
+	float h00 = this->getHeight(cellX, cellZ);
+	float h10 = this->getHeight(cellX + 1, cellZ);
+	float h01 = this->getHeight(cellX, cellZ + 1);
+	float h11 = this->getHeight(cellX + 1, cellZ + 1);
+	if (u + w <= 1) {
+		return h00 + (h10 - h00) * u + (h01 - h00) * w;
+	}
+	return h11 + (h01 - h11) * (1 - u) + (h10 - h11) * (1 - w);
+}
+
+glm::vec3 HeightMap::getNormal(float x, float z) const {
+	int cellX;
+	int cellZ;
+	this->getCell(x, z, cellX, cellZ);
+	glm::vec3 vertices[6];
+	this->getTriangles(cellX, cellZ, vertices);
+	unsigned int first = x / m_cellSize - cellX + z / m_cellSize - cellZ <= 1 ? 0 : 3;
+	return glm::normalize(glm::cross(vertices[first + 1] - vertices[first], vertices[first + 2] - vertices[first]));
+}
+
+// Möller-Trumbore, les deux faces
+static bool intersectTriangle(glm::vec3 origin, glm::vec3 direction, glm::vec3 const* triangle, float& distance) {
+	glm::vec3 edge1 = triangle[1] - triangle[0];
+	glm::vec3 edge2 = triangle[2] - triangle[0];
+	glm::vec3 p = glm::cross(direction, edge2);
+	float     determinant = glm::dot(edge1, p);
+	if (abs(determinant) < 1e-12f) {
+		return false;
+	}
+	float     inverse = 1 / determinant;
+	glm::vec3 toOrigin = origin - triangle[0];
+	float     u = glm::dot(toOrigin, p) * inverse;
+	glm::vec3 q = glm::cross(toOrigin, edge1);
+	float     v = glm::dot(direction, q) * inverse;
+	if (u < 0 || v < 0 || u + v > 1) {
+		return false;
+	}
+	distance = glm::dot(edge2, q) * inverse;
+	return true;
+}
+
+// Le terrain est plein, sans fond : une origine sous la surface touche tout de suite, un rayon qui entre par un bord sous la
+// surface touche ce bord. Sinon le rayon est borné à la boîte de la grille, puis les cases sont parcourues comme les pixels
+// d'une droite (Amanatides et Woo)
+bool HeightMap::raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance, glm::vec3& normal) const {
+	glm::vec3 boxMin(0, -INFINITY, 0);
+	glm::vec3 boxMax(this->getWidth(), m_maxHeight, this->getDepth());
+	float     enter = 0;
+	float     exit = maxDistance;
+	int       enterAxis = -1;
+	for (int axis = 0; axis < 3; axis++) {
+		if (abs(direction[axis]) < 1e-12f) {
+			if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis]) {
+				return false;
+			}
+			continue;
+		}
+		float t1 = (boxMin[axis] - origin[axis]) / direction[axis];
+		float t2 = (boxMax[axis] - origin[axis]) / direction[axis];
+		if (min(t1, t2) > enter) {
+			enter = min(t1, t2);
+			enterAxis = axis;
+		}
+		exit = min(exit, max(t1, t2));
+	}
+	if (enter > exit) {
+		return false;
+	}
+
+	glm::vec3 start = origin + direction * enter;
+	if (start.y < this->sample(start.x, start.z)) {
+		distance = enter;
+		normal = -direction;  // origine sous le terrain
+		if (enterAxis >= 0) {
+			normal = glm::vec3(0);
+			normal[enterAxis] = direction[enterAxis] > 0 ? -1.0f : 1.0f;
+		}
+		return true;
+	}
+
+	int cellX;
+	int cellZ;
+	this->getCell(start.x, start.z, cellX, cellZ);
+	int   stepX = direction.x > 0 ? 1 : -1;
+	int   stepZ = direction.z > 0 ? 1 : -1;
+	float deltaX = abs(direction.x) > 1e-12f ? m_cellSize / abs(direction.x) : INFINITY;
+	float deltaZ = abs(direction.z) > 1e-12f ? m_cellSize / abs(direction.z) : INFINITY;
+	float nextX = abs(direction.x) > 1e-12f ? ((cellX + (stepX > 0)) * m_cellSize - origin.x) / direction.x : INFINITY;
+	float nextZ = abs(direction.z) > 1e-12f ? ((cellZ + (stepZ > 0)) * m_cellSize - origin.z) / direction.z : INFINITY;
+
+	glm::vec3 vertices[6];
+	while (true) {
+		this->getTriangles(cellX, cellZ, vertices);
+		bool hit = false;
+		for (unsigned int t = 0; t < 6; t += 3) {
+			float candidate;
+			if (intersectTriangle(origin, direction, vertices + t, candidate) && candidate >= enter - 1e-5f && candidate <= exit &&
+			    (!hit || candidate < distance)) {
+				hit = true;
+				distance = max(candidate, 0.0f);
+				normal = glm::normalize(glm::cross(vertices[t + 1] - vertices[t], vertices[t + 2] - vertices[t]));
+			}
+		}
+		if (hit) {
+			if (glm::dot(normal, direction) > 0) {
+				normal = -normal;  // terrain vu d'en dessous
+			}
+			return true;
+		}
+
+		if (min(nextX, nextZ) > exit) {
+			return false;
+		}
+		if (nextX < nextZ) {
+			cellX += stepX;
+			nextX += deltaX;
+		} else {
+			cellZ += stepZ;
+			nextZ += deltaZ;
+		}
+		if (cellX < 0 || cellZ < 0 || cellX > (int)m_nbrX - 2 || cellZ > (int)m_nbrZ - 2) {
+			return false;
+		}
+	}
+}
+
+HeightMap::~HeightMap() {}
+
+
+
 /* --- MATRIX --- */
 
 
@@ -2,7 +2,12 @@
 #define MATHS_UTILS
 
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <string>
+#include <vector>
 
 class Quaternion {
   protected:
@@ -76,6 +81,207 @@ class UnitQuaternion : public Quaternion {
 
 
 
+// Quaternions unitaires stockés en glm::vec4 (x, y, z, w) pour les boucles de la physique.
+// Définies ici pour pouvoir être intégrées par le compilateur dans les boucles sur les tableaux de solides.
+
+inline glm::vec4 quaternionProduct(glm::vec4 const& a, glm::vec4 const& b) {
+	return glm::vec4(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,  //
+	                 a.w * b.y + a.y * b.w + a.z * b.x - a.x * b.z,  //
+	                 a.w * b.z + a.z * b.w + a.x * b.y - a.y * b.x,  //
+	                 a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+}
+
+inline glm::vec3 quaternionRotate(glm::vec4 const& q, glm::vec3 const& v) {
+	glm::vec3 u(q.x, q.y, q.z);
+	glm::vec3 t = 2.0f * glm::cross(u, v);
+	return v + q.w * t + glm::cross(u, t);
+}
+
+inline glm::mat3 quaternionMatrix(glm::vec4 const& q) {
+	float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+	return glm::mat3(glm::vec3(1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy)),  //
+	                 glm::vec3(2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx)),  //
+	                 glm::vec3(2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy)));
+}
+
+// Rotation de angularSpeed * deltaTime (en rad) appliquée dans le repère monde
+inline glm::vec4 quaternionIntegrate(glm::vec4 const& q, glm::vec3 const& angularSpeed, float deltaTime) {
+	float angle = glm::length(angularSpeed) * deltaTime;
+	if (angle <= 0) {
+		return q;
+	}
+	glm::vec3 axis = angularSpeed * (std::sin(angle / 2) / (angle / deltaTime));
+	glm::vec4 result = quaternionProduct(glm::vec4(axis.x, axis.y, axis.z, std::cos(angle / 2)), q);
+	return result / glm::length(result);
+}
+
+// Matrice antisymétrique du produit vectoriel : skew(r) . v = r ^ v
+inline glm::mat3 skew(glm::vec3 const& r) { return glm::mat3(glm::vec3(0, r.z, -r.y), glm::vec3(-r.z, 0, r.x), glm::vec3(r.y, -r.x, 0)); }
+
+inline glm::mat3 inverseOrZero(glm::mat3 const& matrix) {
+	return std::abs(glm::determinant(matrix)) > 1e-12f ? glm::inverse(matrix) : glm::mat3(0);
+}
+
+
+
+// Position, orientation et échelle d'un objet dans le repère monde, indépendamment de son rendu
+class Transform {
+  protected:
+	UnitQuaternion m_rotation;
+	glm::vec3      m_translation;
+	glm::vec3      m_scale;
+
+	// État au pas de simulation précédent, pour l'interpolation du rendu
+	UnitQuaternion m_previousRotation;
+	glm::vec3      m_previousTranslation;
+	bool           m_hasPrevious;
+
+  public:
+	Transform();
+
+	UnitQuaternion& getRotation();
+	UnitQuaternion  getRotation() const;
+	Transform&      setRotation(UnitQuaternion const& rotation);
+	glm::vec3&      getTranslation();
+	glm::vec3       getTranslation() const;
+	Transform&      setTranslation(glm::vec3 const& translation);
+	glm::vec3&      getScale();
+	Transform&      translate(glm::vec3 translation);
+	Transform&      translate(float dx, float dy, float dz);
+	Transform&      rotateSelf(UnitQuaternion rotation, glm::vec3 point = glm::vec3(0));
+	Transform&      rotateSelf(float angle, glm::vec3(axis), glm::vec3 point = glm::vec3(0));
+	Transform&      rotateScene(UnitQuaternion rotation, glm::vec3 point = glm::vec3(0));
+	Transform&      rotateScene(float angle, glm::vec3(axis), glm::vec3 point = glm::vec3(0));
+	glm::vec3       transform(glm::vec3 point) const;
+	glm::vec3       invertTransform(glm::vec3 point) const;
+	Transform&      savePrevious();
+	glm::vec3       getInterpolatedTranslation(float alpha) const;
+	UnitQuaternion  getInterpolatedRotation(float alpha) const;
+
+	~Transform();
+};
+
+
+
+// Boîte englobante alignée sur les axes du repère monde
+struct AABB {
+	glm::vec3 min;
+	glm::vec3 max;
+
+	bool overlaps(AABB const& box) const {
+		return min.x <= box.max.x && box.min.x <= max.x && min.y <= box.max.y && box.min.y <= max.y && min.z <= box.max.z &&
+		       box.min.z <= max.z;
+	}
+
+	bool contains(AABB const& box) const {
+		return min.x <= box.min.x && min.y <= box.min.y && min.z <= box.min.z && box.max.x <= max.x && box.max.y <= max.y &&
+		       box.max.z <= max.z;
+	}
+
+	AABB merge(AABB const& box) const { return {glm::min(min, box.min), glm::max(max, box.max)}; }
+
+	float getSurfaceArea() const {
+		glm::vec3 size = max - min;
+		return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	// Méthode des dalles, inverseDirection = 1 / direction pour éviter les divisions dans les parcours d'arbre.
+	// Une composante nulle de la direction donne un inverse infini : le rayon est parallèle à la dalle, qu'il faut alors
+	// contenir, sans calculer 0 * inf = NaN quand l'origine est sur l'un de ses plans
+	bool intersectsRay(glm::vec3 const& origin, glm::vec3 const& inverseDirection, float maxDistance) const {
+		float enter = 0;
+		float exit = maxDistance;
+		for (int axis = 0; axis < 3; axis++) {
+			if (std::isinf(inverseDirection[axis])) {
+				if (origin[axis] < min[axis] || origin[axis] > max[axis]) {
+					return false;
+				}
+				continue;
+			}
+			float t1 = (min[axis] - origin[axis]) * inverseDirection[axis];
+			float t2 = (max[axis] - origin[axis]) * inverseDirection[axis];
+			enter = std::max(enter, std::min(t1, t2));
+			exit = std::min(exit, std::max(t1, t2));
+		}
+		return enter <= exit;
+	}
+};
+
+
+
+// Générateur pseudo-aléatoire à graine (xorshift64*, graine mélangée par splitmix64) : la même graine donne la même suite
+// sur toutes les plateformes, contrairement aux distributions de la bibliothèque standard
+class Random {
+  private:
+	uint64_t m_seed;
+	uint64_t m_state;
+
+  public:
+	Random(uint64_t seed = 0);
+
+	uint64_t getSeed() const;
+	Random&  setSeed(uint64_t seed);  // recommence la suite
+	uint64_t getState() const;
+	Random&  setState(uint64_t state);  // reprend la suite là où getState l'avait laissée
+	uint64_t next();
+	float    uniform();  // [0, 1[
+	float    uniform(float min, float max);
+
+	~Random();
+};
+
+
+
+// Grille régulière de nbrX × nbrZ hauteurs (axe y) espacées de cellSize sur le plan xz, le premier sommet à l'origine.
+// Chaque case est coupée en deux triangles par sa diagonale (x + 1, z) - (x, z + 1) ; la phase étroite et le maillage de rendu
+// partagent ce découpage, le sol affiché est donc exactement celui sur lequel marche le robot
+class HeightMap {
+  private:
+	unsigned int       m_nbrX;
+	unsigned int       m_nbrZ;
+	float              m_cellSize;
+	std::vector<float> m_heights;  // ligne par ligne : hauteur (x, z) à l'indice z * nbrX + x
+	float              m_minHeight;
+	float              m_maxHeight;
+
+	void updateBounds();
+
+  public:
+	HeightMap(unsigned int nbrX = 2, unsigned int nbrZ = 2, float cellSize = 1, float height = 0);
+	HeightMap(std::vector<float> const& heights, unsigned int nbrX, unsigned int nbrZ, float cellSize = 1);
+	// Fichier brut de nbrX × nbrZ float32 dans l'ordre de la grille ; terrain plat si le fichier est illisible ou trop court
+	HeightMap(std::string const& path, unsigned int nbrX, unsigned int nbrZ, float cellSize = 1, float scale = 1);
+
+	unsigned int              getNbrX() const;
+	unsigned int              getNbrZ() const;
+	float                     getCellSize() const;
+	float                     getWidth() const;  // selon x
+	float                     getDepth() const;  // selon z
+	float                     getMinHeight() const;
+	float                     getMaxHeight() const;
+	std::vector<float> const& getHeights() const;
+	float                     getHeight(unsigned int x, unsigned int z) const;
+	HeightMap&                setHeight(unsigned int x, unsigned int z, float height);
+	glm::vec3                 getVertex(unsigned int x, unsigned int z) const;
+	// Bruit de valeurs fractal : octaves de longueurs d'onde divisées par deux et d'amplitudes divisées par deux, même graine
+	// même terrain. Remplace les hauteurs
+	HeightMap&                generate(float amplitude, float wavelength, unsigned int nbrOctaves = 4, uint64_t seed = 0);
+
+	// Case contenant (x, z), bornée à la grille : un accès direct, sans parcours
+	void      getCell(float x, float z, int& cellX, int& cellZ) const;
+	void      getTriangles(unsigned int cellX, unsigned int cellZ, glm::vec3* vertices) const;  // 6 sommets, normales vers +y
+	float     sample(float x, float z) const;                                                    // hauteur sous (x, z), bornée aux bords
+	glm::vec3 getNormal(float x, float z) const;
+	// Rayon dans le repère de la grille : seules les cases survolées sont testées, dans l'ordre où le rayon les traverse
+	bool      raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance, glm::vec3& normal) const;
+
+	~HeightMap();
+};
+
+
+
 class Matrix {
   private:
 	unsigned int m_n;
@@ -16,7 +16,7 @@ using namespace std;
 
 
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
+Shader::Shader(const char* vertexPath, const char* fragmentPath) : m_shaderProgram(0), m_uniformLocations(), m_lookupCount(0) {
 	// Charger les shaders
 	string vertexString = loadShaderSource(vertexPath);
 	string fragmentString = loadShaderSource(fragmentPath);
@@ -69,6 +69,38 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
 
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
+
+	this->introspectUniforms();
+}
+
+// Récupère une seule fois l'emplacement de toutes les uniforms actives du programme
+void Shader::introspectUniforms() {
+	m_uniformLocations.clear();
+	m_lookupCount = 0;
+
+	GLint uniformCount = 0;
+	glGetProgramiv(m_shaderProgram, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+	char name[256];
+	for (GLint i = 0; i < uniformCount; i++) {
+		GLsizei length;
+		GLint   size;
+		GLenum  type;
+		glGetActiveUniform(m_shaderProgram, i, sizeof(name), &length, &size, &type, name);
+
+		// Les tableaux sont nommés "tableau[0]" : on les enregistre aussi sous leur nom nu
+		string uniformName(name, length);
+		GLint  location = glGetUniformLocation(m_shaderProgram, uniformName.c_str());
+		if (location < 0) {
+			continue;  // uniform appartenant à un bloc
+		}
+
+		m_uniformLocations[uniformName] = location;
+		size_t bracket = uniformName.find('[');
+		if (bracket != string::npos) {
+			m_uniformLocations[uniformName.substr(0, bracket)] = location;
+		}
+	}
 }
 
 
@@ -91,59 +123,91 @@ string Shader::loadShaderSource(const char* path) const {
 	}
 }
 
+GLint Shader::getUniformLocation(const char* uniformName) {
+	m_lookupCount++;
+	auto it = m_uniformLocations.find(uniformName);
+	if (it == m_uniformLocations.end()) {
+		return -1;  // ignoré silencieusement par glUniform*, comme une uniform optimisée par le compilateur
+	}
+	return it->second;
+}
+
+unsigned int Shader::getLookupCount() const { return m_lookupCount; }
+
+Shader& Shader::resetLookupCount() {
+	m_lookupCount = 0;
+	return *this;
+}
+
+// Associe un bloc d'uniforms du programme à un point de liaison partagé (voir UBO)
+void Shader::bindUniformBlock(const char* blockName, GLuint bindingPoint) {
+	GLuint blockIndex = glGetUniformBlockIndex(m_shaderProgram, blockName);
+	if (blockIndex != GL_INVALID_INDEX) {
+		glUniformBlockBinding(m_shaderProgram, blockIndex, bindingPoint);
+	}
+}
+
+void Shader::setUniform(GLint location, glm::vec3 const& vector) { glUniform3f(location, vector.x, vector.y, vector.z); }
+void Shader::setUniform(GLint location, glm::vec4 const& vector) { glUniform4f(location, vector.x, vector.y, vector.z, vector.w); }
+void Shader::setUniform(GLint location, glm::mat4 const& matrix) { glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix)); }
+void Shader::setUniform(GLint location, unsigned int const& value) { glUniform1ui(location, value); }
+void Shader::setUniform(GLint location, int const& value) { glUniform1i(location, value); }
+void Shader::setUniform(GLint location, float const& value) { glUniform1f(location, value); }
+
+void Shader::setUniform(GLint location, glm::vec3 const* array, unsigned int size) {
+	glUniform3fv(location, size, glm::value_ptr(array[0]));
+}
+
+void Shader::setUniform(GLint location, glm::vec4 const* array, unsigned int size) {
+	glUniform4fv(location, size, glm::value_ptr(array[0]));
+}
+
+void Shader::setUniform(GLint location, unsigned int const* array, unsigned int size) { glUniform1uiv(location, size, array); }
+void Shader::setUniform(GLint location, int const* array, unsigned int size) { glUniform1iv(location, size, array); }
+void Shader::setUniform(GLint location, float const* array, unsigned int size) { glUniform1fv(location, size, array); }
+
 void Shader::addUniform(const char* uniformName, glm::vec3 const& vector) {
-	GLuint uniformLoc = glGetUniformLocation(m_shaderProgram, uniformName);
-	glUniform3f(uniformLoc, vector.x, vector.y, vector.z);
+	setUniform(this->getUniformLocation(uniformName), vector);
 }
 
 void Shader::addUniform(const char* uniformName, glm::vec4 const& vector) {
-	GLuint uniformLoc = glGetUniformLocation(m_shaderProgram, uniformName);
-	glUniform4f(uniformLoc, vector.x, vector.y, vector.z, vector.w);
+	setUniform(this->getUniformLocation(uniformName), vector);
 }
 
 void Shader::addUniform(const char* uniformName, glm::mat4 const& matrix) {
-	GLuint uniformLoc = glGetUniformLocation(m_shaderProgram, uniformName);
-	glUniformMatrix4fv(uniformLoc, 1, GL_FALSE, glm::value_ptr(matrix));
+	setUniform(this->getUniformLocation(uniformName), matrix);
 }
 
 void Shader::addUniform(const char* uniformName, unsigned int const& value) {
-	GLuint uniformLoc = glGetUniformLocation(m_shaderProgram, uniformName);
-	glUniform1ui(uniformLoc, value);
+	setUniform(this->getUniformLocation(uniformName), value);
 }
 
 void Shader::addUniform(const char* uniformName, int const& value) {
-	GLuint uniformLoc = glGetUniformLocation(m_shaderProgram, uniformName);
-	glUniform1i(uniformLoc, value);
+	setUniform(this->getUniformLocation(uniformName), value);
 }
 
 void Shader::addUniform(const char* uniformName, float const& value) {
-	GLuint uniformLoc = glGetUniformLocation(m_shaderProgram, uniformName);
-	glUniform1f(uniformLoc, value);
+	setUniform(this->getUniformLocation(uniformName), value);
 }
 
 void Shader::addUniform(const char* uniformName, glm::vec3* const& array, unsigned int size) {
-	GLuint uniformLoc = glGetUniformLocation(m_shaderProgram, uniformName);
-	glUniform3fv(uniformLoc, size, glm::value_ptr(array[0]));
+	setUniform(this->getUniformLocation(uniformName), array, size);
 }
 
 void Shader::addUniform(const char* uniformName, glm::vec4* const& array, unsigned int size) {
-	GLuint uniformLoc = glGetUniformLocation(m_shaderProgram, uniformName);
-	glUniform4fv(uniformLoc, size, glm::value_ptr(array[0]));
+	setUniform(this->getUniformLocation(uniformName), array, size);
 }
 
 void Shader::addUniform(const char* uniformName, unsigned int* const& array, unsigned int size) {
-	GLuint uniformLoc = glGetUniformLocation(m_shaderProgram, uniformName);
-	glUniform1uiv(uniformLoc, size, array);
+	setUniform(this->getUniformLocation(uniformName), array, size);
 }
 
 void Shader::addUniform(const char* uniformName, int* const& array, unsigned int size) {
-	GLuint uniformLoc = glGetUniformLocation(m_shaderProgram, uniformName);
-	glUniform1iv(uniformLoc, size, array);
+	setUniform(this->getUniformLocation(uniformName), array, size);
 }
 
 void Shader::addUniform(const char* uniformName, float* const& array, unsigned int size) {
-	GLuint uniformLoc = glGetUniformLocation(m_shaderProgram, uniformName);
-	glUniform1fv(uniformLoc, size, array);
+	setUniform(this->getUniformLocation(uniformName), array, size);
 }
 
 Shader::~Shader() { glDeleteProgram(m_shaderProgram); }
@@ -169,9 +233,11 @@ VAO::~VAO() { glDeleteVertexArrays(1, &m_VAO); }
 
 VBO::VBO() : m_VBO() { glGenBuffers(1, &m_VBO); }
 
-void VBO::bind(unsigned int size, GLfloat* data) {
-	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-	glBufferData(GL_ARRAY_BUFFER, size * sizeof(GLfloat), data, GL_STATIC_DRAW);
+void VBO::bind() { glBindBuffer(GL_ARRAY_BUFFER, m_VBO); }
+
+void VBO::bind(unsigned int size, const GLfloat* data, GLenum usage) {
+	this->bind();
+	glBufferData(GL_ARRAY_BUFFER, size * sizeof(GLfloat), data, usage);
 }
 
 void VBO::unBind() { glBindBuffer(GL_ARRAY_BUFFER, 0); }
@@ -187,12 +253,15 @@ VBO::~VBO() { glDeleteBuffers(1, &m_VBO); }
 
 EBO::EBO() : m_EBO(), m_attrIndices(vector<GLuint>()) { glGenBuffers(1, &m_EBO); }
 
-void EBO::bind(unsigned int size, GLuint* data) {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+void EBO::bind() { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO); }
+
+void EBO::bind(unsigned int size, const GLuint* data) {
+	this->bind();
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size * sizeof(GLuint), data, GL_STATIC_DRAW);
 }
 
-void EBO::addAttribute(GLuint index, GLuint size, GLuint offset, GLuint stride, GLenum type, GLboolean normalized) {
+// Un diviseur non nul fait avancer l'attribut par instance plutôt que par sommet
+void EBO::addAttribute(GLuint index, GLuint size, GLuint offset, GLuint stride, GLenum type, GLboolean normalized, GLuint divisor) {
 	size_t typeSize;
 	if (type == GL_FLOAT) {
 		typeSize = sizeof(GLfloat);
@@ -205,6 +274,7 @@ void EBO::addAttribute(GLuint index, GLuint size, GLuint offset, GLuint stride,
 	m_attrIndices.push_back(index);
 	glVertexAttribPointer(index, size, type, normalized, stride * typeSize, (GLvoid*)(offset * typeSize));
 	glEnableVertexAttribArray(index);
+	glVertexAttribDivisor(index, divisor);
 }
 
 void EBO::unBind() {
@@ -215,3 +285,32 @@ void EBO::unBind() {
 }
 
 EBO::~EBO() { glDeleteBuffers(1, &m_EBO); }
+
+
+
+/* --- UBO --- */
+
+
+
+UBO::UBO(unsigned int size, GLuint bindingPoint) : m_UBO(), m_bindingPoint(bindingPoint), m_size(size) {
+	glGenBuffers(1, &m_UBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, m_UBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+GLuint       UBO::getBindingPoint() const { return m_bindingPoint; }
+unsigned int UBO::getSize() const { return m_size; }
+
+void UBO::bind() { glBindBuffer(GL_UNIFORM_BUFFER, m_UBO); }
+
+void UBO::update(unsigned int offset, unsigned int size, const void* data) {
+	this->bind();
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	this->unBind();
+}
+
+void UBO::unBind() { glBindBuffer(GL_UNIFORM_BUFFER, 0); }
+
+UBO::~UBO() { glDeleteBuffers(1, &m_UBO); }
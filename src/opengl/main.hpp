@@ -5,16 +5,43 @@
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
+#include <unordered_map>
+
+template <typename T>
+class Uniform;
 
 class Shader {
   private:
-	GLuint m_shaderProgram;
+	GLuint                                 m_shaderProgram;
+	std::unordered_map<std::string, GLint> m_uniformLocations;  // rempli une seule fois après le linkage
+	unsigned int                           m_lookupCount;       // nombre de recherches par nom depuis la dernière remise à zéro
+
+	void introspectUniforms();
 
   public:
 	Shader(const char* vertexPath, const char* fragmentPath);
 
-	std::string loadShaderSource(const char* path) const;
-	void        use();
+	std::string  loadShaderSource(const char* path) const;
+	void         use();
+	GLint        getUniformLocation(const char* uniformName);
+	unsigned int getLookupCount() const;
+	Shader&      resetLookupCount();
+	void         bindUniformBlock(const char* blockName, GLuint bindingPoint);
+
+	template <typename T>
+	Uniform<T> getUniform(const char* uniformName);
+
+	static void setUniform(GLint location, glm::vec3 const& vector);
+	static void setUniform(GLint location, glm::vec4 const& vector);
+	static void setUniform(GLint location, glm::mat4 const& matrix);
+	static void setUniform(GLint location, unsigned int const& value);
+	static void setUniform(GLint location, int const& value);
+	static void setUniform(GLint location, float const& value);
+	static void setUniform(GLint location, glm::vec3 const* array, unsigned int size);
+	static void setUniform(GLint location, glm::vec4 const* array, unsigned int size);
+	static void setUniform(GLint location, unsigned int const* array, unsigned int size);
+	static void setUniform(GLint location, int const* array, unsigned int size);
+	static void setUniform(GLint location, float const* array, unsigned int size);
 
 	void addUniform(const char* uniformName, glm::vec3 const& vector);
 	void addUniform(const char* uniformName, glm::vec4 const& vector);
@@ -31,6 +58,27 @@ class Shader {
 	~Shader();
 };
 
+// Poignée typée vers une uniform dont l'emplacement a été résolu à l'avance : aucune recherche par nom lors de l'envoi.
+// Le programme auquel elle appartient doit être en cours d'utilisation.
+template <typename T>
+class Uniform {
+  private:
+	GLint m_location;
+
+  public:
+	Uniform(GLint location = -1) : m_location(location) {}
+
+	GLint getLocation() const { return m_location; }
+	bool  exists() const { return m_location >= 0; }
+	void  set(T const& value) const { Shader::setUniform(m_location, value); }
+	void  set(T const* array, unsigned int size) const { Shader::setUniform(m_location, array, size); }
+};
+
+template <typename T>
+Uniform<T> Shader::getUniform(const char* uniformName) {
+	return Uniform<T>(this->getUniformLocation(uniformName));
+}
+
 class VAO {
   private:
 	GLuint m_VAO;
@@ -51,7 +99,8 @@ class VBO {
   public:
 	VBO();
 
-	void bind(unsigned int size, GLfloat* data);
+	void bind();
+	void bind(unsigned int size, const GLfloat* data, GLenum usage = GL_STATIC_DRAW);
 	void unBind();
 
 	~VBO();
@@ -65,11 +114,32 @@ class EBO {
   public:
 	EBO();
 
-	void bind(unsigned int size, GLuint* data);
-	void addAttribute(GLuint index, GLuint size, GLuint offset, GLuint stride, GLenum type = GL_FLOAT, GLboolean normalized = GL_FALSE);
+	void bind();
+	void bind(unsigned int size, const GLuint* data);
+	void addAttribute(GLuint index, GLuint size, GLuint offset, GLuint stride, GLenum type = GL_FLOAT, GLboolean normalized = GL_FALSE,
+	                  GLuint divisor = 0);
 	void unBind();
 
 	~EBO();
 };
 
+// Buffer d'uniforms (std140) attaché à un point de liaison, partageable entre plusieurs programmes
+class UBO {
+  private:
+	GLuint       m_UBO;
+	GLuint       m_bindingPoint;
+	unsigned int m_size;
+
+  public:
+	UBO(unsigned int size, GLuint bindingPoint);
+
+	GLuint       getBindingPoint() const;
+	unsigned int getSize() const;
+	void         bind();
+	void         update(unsigned int offset, unsigned int size, const void* data);
+	void         unBind();
+
+	~UBO();
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,497 @@
+#include "articulation.hpp"
+#include "main.hpp"
+#include "../maths/utils.hpp"
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+
+
+/* --- ARTICULATION --- */
+
+
+
+// Produits vectoriels spatiaux : mouvement ^ mouvement et mouvement ^ effort
+static SpatialVector crossMotion(SpatialVector const& v, SpatialVector const& m) {
+	return {glm::cross(v.angular, m.angular), glm::cross(v.angular, m.linear) + glm::cross(v.linear, m.angular)};
+}
+
+static SpatialVector crossForce(SpatialVector const& v, SpatialVector const& f) {
+	return {glm::cross(v.angular, f.angular) + glm::cross(v.linear, f.linear), glm::cross(v.angular, f.linear)};
+}
+
+static glm::vec4 conjugate(glm::vec4 const& q) { return glm::vec4(-q.x, -q.y, -q.z, q.w); }
+
+static glm::vec4 axisAngle(glm::vec3 const& axis, float angle) { return glm::vec4(axis * sin(angle / 2), cos(angle / 2)); }
+
+Articulation::Articulation(vector<WorldObject*> const& worldObjects, vector<Joint*> const& joints)
+    : m_links(vector<ArticulationLink>()), m_loopJoints(vector<Joint*>()), m_fixedBase(false), m_origin(glm::vec3(0)) {
+	ArticulationLink root = {};
+	root.worldObject = worldObjects[0];
+	root.joint = nullptr;
+	root.parent = -1;
+	root.rotation = glm::vec4(0, 0, 0, 1);
+	m_links.push_back(root);
+	m_fixedBase = worldObjects[0]->getStore().getInverseMasses()[worldObjects[0]->getIndex()] == 0;
+
+	// Parcours en largeur depuis la racine : un parent est toujours placé avant ses enfants
+	vector<bool> used(joints.size(), false);
+	for (unsigned int parent = 0; parent < m_links.size(); parent++) {
+		WorldObject* parentObject = m_links[parent].worldObject;
+		for (unsigned int i = 0; i < joints.size(); i++) {
+			Joint* joint = joints[i];
+			if (used[i] || (joint->getWorldObject1() != parentObject && joint->getWorldObject2() != parentObject)) {
+				continue;
+			}
+			used[i] = true;
+
+			ArticulationLink link = {};
+			link.joint = joint;
+			link.parent = parent;
+			link.reversed = joint->getWorldObject2() == parentObject;
+			link.worldObject = link.reversed ? joint->getWorldObject1() : joint->getWorldObject2();
+			link.parentAnchor = link.reversed ? joint->getContact2() : joint->getContact1();
+			link.childAnchor = link.reversed ? joint->getContact1() : joint->getContact2();
+			link.rotation = glm::vec4(0, 0, 0, 1);
+
+			bool alreadyLinked = false;
+			for (ArticulationLink const& other : m_links) {
+				alreadyLinked = alreadyLinked || other.worldObject == link.worldObject;
+			}
+			if (dynamic_cast<HingeJoint*>(joint) != nullptr) {
+				link.nbrDofs = 1;
+			} else if (dynamic_cast<BallJoint*>(joint) != nullptr) {
+				link.nbrDofs = 3;
+			} else if (dynamic_cast<FixedJoint*>(joint) != nullptr) {
+				link.nbrDofs = 0;
+			} else {
+				alreadyLinked = true;
+			}
+			if (alreadyLinked) {
+				m_loopJoints.push_back(joint);
+				continue;
+			}
+
+			// Orientation relative à angle nul, celle pour laquelle HingeJoint::getAngle s'annule
+			glm::vec4 parentOrientation = parentObject->getStore().getOrientations()[parentObject->getIndex()];
+			glm::vec4 childOrientation = link.worldObject->getStore().getOrientations()[link.worldObject->getIndex()];
+			link.restOrientation = quaternionProduct(conjugate(parentOrientation), childOrientation);
+			if (HingeJoint* hinge = dynamic_cast<HingeJoint*>(joint)) {
+				link.axis = quaternionRotate(conjugate(childOrientation), hinge->getWorldAxis());
+				float angle = link.reversed ? -hinge->getAngle() : hinge->getAngle();
+				link.restOrientation = quaternionProduct(link.restOrientation, axisAngle(link.axis, -angle));
+			}
+			m_links.push_back(link);
+		}
+	}
+
+	// Liaisons qui ne touchent pas l'arbre
+	for (unsigned int i = 0; i < joints.size(); i++) {
+		if (!used[i]) {
+			m_loopJoints.push_back(joints[i]);
+		}
+	}
+
+	this->pull();
+}
+
+vector<ArticulationLink>& Articulation::getLinks() { return m_links; }
+vector<Joint*>&           Articulation::getLoopJoints() { return m_loopJoints; }
+bool                      Articulation::getFixedBase() const { return m_fixedBase; }
+
+WorldObject* Articulation::getFirstMobile() const {
+	if (!m_fixedBase) {
+		return m_links[0].worldObject;
+	}
+	return m_links.size() > 1 ? m_links[1].worldObject : nullptr;
+}
+
+bool Articulation::isAwake() const {
+	WorldObject* worldObject = this->getFirstMobile();
+	return worldObject != nullptr && worldObject->getStore().isAwake(worldObject->getIndex());
+}
+
+int Articulation::findLink(Joint* joint) const {
+	for (unsigned int i = 1; i < m_links.size(); i++) {
+		if (m_links[i].joint == joint) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+Articulation& Articulation::applyJointTorque(Joint* joint, float torque) {
+	HingeJoint* hinge = dynamic_cast<HingeJoint*>(joint);
+	if (hinge != nullptr) {
+		this->applyJointTorque(joint, hinge->getWorldAxis() * torque);
+	}
+	return *this;
+}
+
+Articulation& Articulation::applyJointTorque(Joint* joint, glm::vec3 torque) {
+	int index = this->findLink(joint);
+	if (index >= 0) {
+		m_links[index].jointTorque += m_links[index].reversed ? -torque : torque;
+		m_links[index].worldObject->getStore().wake(m_links[index].worldObject->getIndex());
+	}
+	return *this;
+}
+
+Articulation& Articulation::pull() {
+	for (unsigned int i = 1; i < m_links.size(); i++) {
+		ArticulationLink& link = m_links[i];
+		WorldObject*      parentObject = m_links[link.parent].worldObject;
+		glm::vec4         parentOrientation = parentObject->getStore().getOrientations()[parentObject->getIndex()];
+		glm::vec4         childOrientation = link.worldObject->getStore().getOrientations()[link.worldObject->getIndex()];
+		glm::vec3         relativeSpeed = link.worldObject->getAngularSpeed() - parentObject->getAngularSpeed();
+
+		if (link.nbrDofs == 1) {
+			HingeJoint* hinge = static_cast<HingeJoint*>(link.joint);
+			link.angle = link.reversed ? -hinge->getAngle() : hinge->getAngle();
+			link.jointSpeed = glm::vec3(glm::dot(relativeSpeed, quaternionRotate(childOrientation, link.axis)), 0, 0);
+		} else if (link.nbrDofs == 3) {
+			glm::vec4 relative = quaternionProduct(conjugate(parentOrientation), childOrientation);
+			link.rotation = glm::normalize(quaternionProduct(conjugate(link.restOrientation), relative));
+			link.jointSpeed = quaternionRotate(conjugate(childOrientation), relativeSpeed);
+		}
+	}
+
+	// Les poses sont recalculées depuis les coordonnées articulaires : un écart aux liaisons est corrigé d'un coup
+	this->computeKinematics();
+	this->computeSpatialQuantities();
+	this->readRootVelocity();
+	this->computeVelocities();
+	this->writeVelocities();
+	return *this;
+}
+
+// Poses des solides depuis celle de la racine : q = qparent . q0 . qliaison, les points de liaison coïncident
+void Articulation::computeKinematics() {
+	for (unsigned int i = 1; i < m_links.size(); i++) {
+		ArticulationLink& link = m_links[i];
+		WorldObject*      parentObject = m_links[link.parent].worldObject;
+		BodyStore&        parentStore = parentObject->getStore();
+		BodyStore&        store = link.worldObject->getStore();
+		unsigned int      index = link.worldObject->getIndex();
+		glm::vec4         parentOrientation = parentStore.getOrientations()[parentObject->getIndex()];
+
+		glm::vec4 jointRotation = link.nbrDofs == 1 ? axisAngle(link.axis, link.angle) : link.rotation;
+		glm::vec4 orientation = quaternionProduct(quaternionProduct(parentOrientation, link.restOrientation), jointRotation);
+		orientation = glm::normalize(orientation);
+		glm::vec3 anchor = parentStore.getPositions()[parentObject->getIndex()] + quaternionRotate(parentOrientation, link.parentAnchor);
+
+		store.getOrientations()[index] = orientation;
+		store.getPositions()[index] = anchor - quaternionRotate(orientation, link.childAnchor);
+		store.updateWorldInverseInertia(index);
+	}
+}
+
+// Inerties et axes en coordonnées de Plücker, l'origine étant placée au centre d'inertie de la racine
+void Articulation::computeSpatialQuantities() {
+	for (unsigned int i = 0; i < m_links.size(); i++) {
+		ArticulationLink& link = m_links[i];
+		BodyStore&        store = link.worldObject->getStore();
+		unsigned int      index = link.worldObject->getIndex();
+		Solid&            solid = link.worldObject->getSolid();
+		glm::vec4         orientation = store.getOrientations()[index];
+		glm::mat3         rotation = quaternionMatrix(orientation);
+
+		glm::vec3 center = store.getPositions()[index] + quaternionRotate(orientation, store.getInertiaCenters()[index]);
+		if (i == 0) {
+			m_origin = center;
+		}
+		link.center = center - m_origin;
+		link.worldInertia = rotation * solid.getInertiaTensor() * glm::transpose(rotation);
+
+		// I = [[Ic + m . cx . cxt, m . cx], [m . cxt, m . Id]] avec cx = skew(c)
+		float     mass = solid.getTotalMass();
+		glm::mat3 centerSkew = skew(link.center);
+		link.inertia = {link.worldInertia - mass * centerSkew * centerSkew, mass * centerSkew, mass * glm::mat3(1)};
+
+		if (link.parent < 0) {
+			continue;
+		}
+
+		// Rotation autour d'un axe u passant par le point de liaison j : S = (u, j ^ u)
+		WorldObject* parentObject = m_links[link.parent].worldObject;
+		glm::vec4    parentOrientation = parentObject->getStore().getOrientations()[parentObject->getIndex()];
+		glm::vec3    anchor = parentObject->getStore().getPositions()[parentObject->getIndex()] - m_origin;
+		anchor += quaternionRotate(parentOrientation, link.parentAnchor);
+
+		for (unsigned int k = 0; k < link.nbrDofs; k++) {
+			glm::vec3 axis = link.nbrDofs == 1 ? rotation * link.axis : rotation[k];
+			link.axes[k] = {axis, glm::cross(anchor, axis)};
+		}
+	}
+}
+
+// Vitesse de la racine lue dans son BodyStore, qui l'intègre comme celle d'un solide libre
+void Articulation::readRootVelocity() {
+	ArticulationLink& root = m_links[0];
+	if (m_fixedBase) {
+		root.velocity = {glm::vec3(0), glm::vec3(0)};
+	} else {
+		glm::vec3 angularSpeed = root.worldObject->getAngularSpeed();
+		root.velocity = {angularSpeed, root.worldObject->getSpeedVector() - glm::cross(angularSpeed, root.center)};
+	}
+}
+
+// Vitesses des solides déduites de celle de la racine et des vitesses articulaires
+void Articulation::computeVelocities() {
+	for (unsigned int i = 1; i < m_links.size(); i++) {
+		ArticulationLink& link = m_links[i];
+		SpatialVector     jointVelocity = {glm::vec3(0), glm::vec3(0)};
+		for (unsigned int k = 0; k < link.nbrDofs; k++) {
+			jointVelocity = jointVelocity + link.axes[k] * link.jointSpeed[k];
+		}
+		link.velocity = m_links[link.parent].velocity + jointVelocity;
+		link.bias = crossMotion(link.velocity, jointVelocity);
+	}
+}
+
+// Vitesse du centre d'inertie et moment cinétique de chaque solide, pour les contacts et le code utilisateur
+void Articulation::writeVelocities() {
+	for (ArticulationLink& link : m_links) {
+		BodyStore&   store = link.worldObject->getStore();
+		unsigned int index = link.worldObject->getIndex();
+		link.writtenSpeed = link.velocity.linear + glm::cross(link.velocity.angular, link.center);
+		link.writtenMomentum = link.worldInertia * link.velocity.angular;
+		if (store.getInverseMasses()[index] == 0) {
+			continue;  // racine bloquée, que d'autres îles lisent peut-être en même temps
+		}
+		store.getVelocities()[index] = link.writtenSpeed;
+		store.getAngularMomenta()[index] = link.writtenMomentum;
+	}
+}
+
+// Featherstone : inerties articulées des feuilles vers la racine, puis accélérations de la racine vers les feuilles.
+// Pour une propagation d'impulsions, les inerties du pas sont réutilisées et les termes de vitesse (c, couples) ignorés.
+void Articulation::solve(bool impulse) {
+	for (unsigned int i = m_links.size() - 1; i > 0; i--) {
+		ArticulationLink& link = m_links[i];
+		unsigned int      nbrDofs = link.nbrDofs;
+
+		if (!impulse) {
+			glm::mat3 D(1);
+			for (unsigned int a = 0; a < nbrDofs; a++) {
+				link.projectedInertia[a] = link.articulatedInertia * link.axes[a];
+			}
+			for (unsigned int a = 0; a < nbrDofs; a++) {
+				for (unsigned int b = 0; b < nbrDofs; b++) {
+					D[b][a] = link.axes[a].dot(link.projectedInertia[b]);
+				}
+			}
+			link.inverseD = nbrDofs == 1 ? glm::mat3(D[0][0] > 1e-12f ? 1 / D[0][0] : 0) : inverseOrZero(D);
+		}
+
+		glm::vec3 jointTorque = impulse ? glm::vec3(0) : link.jointTorque;
+		for (unsigned int a = 0; a < nbrDofs; a++) {
+			link.jointForce[a] = glm::dot(link.axes[a].angular, jointTorque) - link.axes[a].dot(link.articulatedForce);
+		}
+
+		// Ia = IA - U . D-1 . Ut et pa = pA + Ia . c + U . D-1 . u, transmis au parent
+		glm::vec3         weights = link.inverseD * link.jointForce;
+		SpatialInertia    inertia = link.articulatedInertia;
+		SpatialVector     force = link.articulatedForce;
+		ArticulationLink& parent = m_links[link.parent];
+		for (unsigned int a = 0; a < nbrDofs; a++) {
+			force = force + link.projectedInertia[a] * weights[a];
+			for (unsigned int b = 0; b < nbrDofs && !impulse; b++) {
+				float d = link.inverseD[b][a];
+				inertia.angular -= glm::outerProduct(link.projectedInertia[a].angular, link.projectedInertia[b].angular) * d;
+				inertia.coupling -= glm::outerProduct(link.projectedInertia[a].angular, link.projectedInertia[b].linear) * d;
+				inertia.linear -= glm::outerProduct(link.projectedInertia[a].linear, link.projectedInertia[b].linear) * d;
+			}
+		}
+		if (!impulse) {
+			force = force + inertia * link.bias;
+			parent.articulatedInertia.angular += inertia.angular;
+			parent.articulatedInertia.coupling += inertia.coupling;
+			parent.articulatedInertia.linear += inertia.linear;
+		}
+		parent.articulatedForce = parent.articulatedForce + force;
+	}
+
+	ArticulationLink& root = m_links[0];
+	root.acceleration = m_fixedBase ? SpatialVector{glm::vec3(0), glm::vec3(0)} : this->solveBase(root.articulatedForce * -1);
+
+	for (unsigned int i = 1; i < m_links.size(); i++) {
+		ArticulationLink& link = m_links[i];
+		SpatialVector     acceleration = m_links[link.parent].acceleration;
+		if (!impulse) {
+			acceleration = acceleration + link.bias;
+		}
+
+		// qdd = D-1 . (u - Ut . a')
+		glm::vec3 projected(0);
+		for (unsigned int a = 0; a < link.nbrDofs; a++) {
+			projected[a] = link.jointForce[a] - link.projectedInertia[a].dot(acceleration);
+		}
+		link.jointAcceleration = link.inverseD * projected;
+		for (unsigned int a = 0; a < link.nbrDofs; a++) {
+			acceleration = acceleration + link.axes[a] * link.jointAcceleration[a];
+		}
+		link.acceleration = acceleration;
+	}
+}
+
+// Résout IA . a = f pour la racine libre, par complément de Schur du bloc linéaire
+SpatialVector Articulation::solveBase(SpatialVector const& force) const {
+	SpatialInertia const& inertia = m_links[0].articulatedInertia;
+	glm::mat3             inverseLinear = inverseOrZero(inertia.linear);
+	glm::mat3             couplingT = glm::transpose(inertia.coupling);
+	glm::mat3             schur = inertia.angular - inertia.coupling * inverseLinear * couplingT;
+
+	glm::vec3 angular = inverseOrZero(schur) * (force.angular - inertia.coupling * (inverseLinear * force.linear));
+	glm::vec3 linear = inverseLinear * (force.linear - couplingT * angular);
+	return {angular, linear};
+}
+
+void Articulation::prepare(double deltaTime) {
+	float dt = (float)deltaTime;
+	this->computeSpatialQuantities();
+	this->readRootVelocity();
+	this->computeVelocities();
+
+	// p = v ^* (I . v) - fext, les forces accumulées sur les solides sont consommées ici
+	for (ArticulationLink& link : m_links) {
+		BodyStore&    store = link.worldObject->getStore();
+		unsigned int  index = link.worldObject->getIndex();
+		glm::vec3     force = store.getForces()[index];
+		SpatialVector external = {store.getTorques()[index] + glm::cross(link.center, force), force};
+		store.getForces()[index] = glm::vec3(0);
+		store.getTorques()[index] = glm::vec3(0);
+
+		link.articulatedInertia = link.inertia;
+		link.articulatedForce = crossForce(link.velocity, link.inertia * link.velocity) - external;
+	}
+
+	this->solve(false);
+
+	// L'origine suivant la racine d'un pas à l'autre, l'accélération spatiale est convertie en accélération du centre d'inertie :
+	// ac = a + dw ^ c + w ^ vc
+	ArticulationLink& root = m_links[0];
+	if (!m_fixedBase) {
+		glm::vec3 angularSpeed = root.velocity.angular;
+		glm::vec3 speed = root.velocity.linear + glm::cross(angularSpeed, root.center);
+		glm::vec3 acceleration = root.acceleration.linear + glm::cross(root.acceleration.angular, root.center);
+		acceleration += glm::cross(angularSpeed, speed);
+		angularSpeed += root.acceleration.angular * dt;
+		speed += acceleration * dt;
+		root.velocity = {angularSpeed, speed - glm::cross(angularSpeed, root.center)};
+	}
+	for (unsigned int i = 1; i < m_links.size(); i++) {
+		m_links[i].jointSpeed += m_links[i].jointAcceleration * dt;
+		m_links[i].jointTorque = glm::vec3(0);
+	}
+	this->computeVelocities();
+	this->writeVelocities();
+}
+
+// Les variations de vitesse subies par les solides (contacts, liaisons de boucle) sont des impulsions P = I . dv,
+// dont la réponse de l'arbre entier est calculée avec les inerties articulées du pas
+void Articulation::project() {
+	bool changed = false;
+	for (ArticulationLink& link : m_links) {
+		BodyStore&   store = link.worldObject->getStore();
+		unsigned int index = link.worldObject->getIndex();
+		if (store.getInverseMasses()[index] == 0) {
+			link.articulatedForce = {glm::vec3(0), glm::vec3(0)};
+			continue;
+		}
+		glm::vec3 speed = store.getVelocities()[index] - link.writtenSpeed;
+		glm::vec3 momentum = store.getAngularMomenta()[index] - link.writtenMomentum;
+		glm::vec3 angularSpeed = store.getWorldInverseInertias()[index] * momentum;
+
+		// Comparaison exacte : un solide que personne n'a touché ne reçoit aucune impulsion
+		SpatialVector variation = {angularSpeed, speed - glm::cross(angularSpeed, link.center)};
+		link.articulatedForce = (link.inertia * variation) * -1;
+		changed = changed || speed != glm::vec3(0) || momentum != glm::vec3(0);
+	}
+	if (!changed) {
+		return;
+	}
+
+	this->solve(true);
+
+	if (!m_fixedBase) {
+		m_links[0].velocity = m_links[0].velocity + m_links[0].acceleration;
+	}
+	for (unsigned int i = 1; i < m_links.size(); i++) {
+		m_links[i].jointSpeed += m_links[i].jointAcceleration;
+	}
+	this->computeVelocities();
+	this->writeVelocities();
+}
+
+// La racine a déjà été intégrée par son BodyStore comme un solide libre : seules les coordonnées articulaires avancent ici
+void Articulation::integrate(double deltaTime) {
+	float dt = (float)deltaTime;
+	for (unsigned int i = 1; i < m_links.size(); i++) {
+		ArticulationLink& link = m_links[i];
+		if (link.nbrDofs == 1) {
+			link.angle += link.jointSpeed.x * dt;
+
+			// Butées du pivot : arrêt net, la vitesse vers la butée est annulée
+			HingeJoint* hinge = static_cast<HingeJoint*>(link.joint);
+			if (hinge->getLimited()) {
+				float lower = link.reversed ? -hinge->getUpperLimit() : hinge->getLowerLimit();
+				float upper = link.reversed ? -hinge->getLowerLimit() : hinge->getUpperLimit();
+				if (link.angle < lower) {
+					link.angle = lower;
+					link.jointSpeed.x = max(link.jointSpeed.x, 0.0f);
+				} else if (link.angle > upper) {
+					link.angle = upper;
+					link.jointSpeed.x = min(link.jointSpeed.x, 0.0f);
+				}
+			}
+		} else if (link.nbrDofs == 3) {
+			// Vitesse exprimée dans le repère de l'enfant : la rotation s'applique à droite
+			glm::vec4 step = quaternionIntegrate(glm::vec4(0, 0, 0, 1), link.jointSpeed, dt);
+			link.rotation = glm::normalize(quaternionProduct(link.rotation, step));
+		}
+	}
+
+	// w de la racine est gardée telle quelle : la relire depuis L compterait deux fois l'effet gyroscopique
+	ArticulationLink& root = m_links[0];
+	glm::vec3         speed = root.velocity.linear + glm::cross(root.velocity.angular, root.center);
+	this->computeKinematics();
+	this->computeSpatialQuantities();
+	root.velocity.linear = speed - glm::cross(root.velocity.angular, root.center);
+	this->computeVelocities();
+	this->writeVelocities();
+}
+
+void Articulation::sleep() {
+	for (ArticulationLink& link : m_links) {
+		link.jointSpeed = glm::vec3(0);
+		link.jointTorque = glm::vec3(0);
+		link.writtenSpeed = glm::vec3(0);
+		link.writtenMomentum = glm::vec3(0);
+	}
+}
+
+void Articulation::save(ArticulationLinkState* states) const {
+	for (unsigned int i = 0; i < m_links.size(); i++) {
+		ArticulationLink const& link = m_links[i];
+		states[i] = {link.angle, link.rotation, link.jointSpeed, link.jointTorque, link.writtenSpeed, link.writtenMomentum};
+	}
+}
+
+// Les poses des solides sont restaurées par le BodyStore : les coordonnées articulaires suffisent, sans recalcul
+void Articulation::restore(ArticulationLinkState const* states) {
+	for (unsigned int i = 0; i < m_links.size(); i++) {
+		ArticulationLink& link = m_links[i];
+		link.angle = states[i].angle;
+		link.rotation = states[i].rotation;
+		link.jointSpeed = states[i].jointSpeed;
+		link.jointTorque = states[i].jointTorque;
+		link.writtenSpeed = states[i].writtenSpeed;
+		link.writtenMomentum = states[i].writtenMomentum;
+	}
+}
+
+Articulation::~Articulation() {}
@@ -0,0 +1,125 @@
+#ifndef PHYSICS_ARTICULATION
+#define PHYSICS_ARTICULATION
+
+#include "../maths/utils.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+class Joint;
+class WorldObject;
+
+// Vecteur spatial en coordonnées de Plücker, repère monde : partie angulaire puis linéaire.
+// Mouvement : (w, vitesse du point du solide qui passe par l'origine), effort : (moment à l'origine, force)
+struct SpatialVector {
+	glm::vec3 angular;
+	glm::vec3 linear;
+
+	SpatialVector operator+(SpatialVector const& vector) const { return {angular + vector.angular, linear + vector.linear}; }
+	SpatialVector operator-(SpatialVector const& vector) const { return {angular - vector.angular, linear - vector.linear}; }
+	SpatialVector operator*(float factor) const { return {angular * factor, linear * factor}; }
+	float         dot(SpatialVector const& vector) const { return glm::dot(angular, vector.angular) + glm::dot(linear, vector.linear); }
+};
+
+// Inertie spatiale 6x6 symétrique, par blocs : [[angular, coupling], [coupling t, linear]]
+struct SpatialInertia {
+	glm::mat3 angular;
+	glm::mat3 coupling;
+	glm::mat3 linear;
+
+	SpatialVector operator*(SpatialVector const& motion) const {
+		return {angular * motion.angular + coupling * motion.linear, glm::transpose(coupling) * motion.angular + linear * motion.linear};
+	}
+};
+
+// Un solide de l'arbre et la liaison qui le relie à son parent
+struct ArticulationLink {
+	WorldObject* worldObject;
+	Joint*       joint;     // nullptr pour la racine
+	int          parent;    // indice dans l'articulation, -1 pour la racine
+	unsigned int nbrDofs;   // 0 encastrement, 1 pivot, 3 rotule
+	bool         reversed;  // l'enfant est le premier objet de la liaison
+
+	// Géométrie de la liaison, figée à la construction
+	glm::vec3 parentAnchor;     // point de liaison, repère local du parent
+	glm::vec3 childAnchor;      // repère local de l'enfant
+	glm::vec4 restOrientation;  // qparent-1 . qenfant à angle nul
+	glm::vec3 axis;             // axe du pivot, repère local de l'enfant
+
+	// Coordonnées articulaires
+	float     angle;        // pivot
+	glm::vec4 rotation;     // rotule, repère local de l'enfant
+	glm::vec3 jointSpeed;   // nbrDofs composantes, repère local de l'enfant pour la rotule
+	glm::vec3 jointTorque;  // couple moteur sur l'enfant, repère monde, remis à zéro à chaque pas
+
+	// Recalculés à chaque pas (Featherstone), relativement au centre d'inertie de la racine
+	glm::vec3      center;        // centre d'inertie du solide
+	glm::mat3      worldInertia;  // tenseur d'inertie au centre d'inertie, repère monde
+	SpatialVector  axes[3];       // S : mouvements permis par la liaison
+	SpatialInertia inertia;       // inertie du solide seul
+	SpatialVector  velocity;
+	SpatialVector  bias;  // c = v ^ S . qd
+	SpatialInertia articulatedInertia;
+	SpatialVector  articulatedForce;
+	SpatialVector  projectedInertia[3];  // U = IA . S
+	glm::mat3      inverseD;             // (St . IA . S)-1
+	glm::vec3      jointForce;           // u = tau - St . pA
+	glm::vec3      jointAcceleration;    // qdd, ou variation de qd lors d'une propagation d'impulsions
+	SpatialVector  acceleration;
+	glm::vec3      writtenSpeed;  // dernières valeurs écrites dans le BodyStore, pour y repérer les impulsions reçues
+	glm::vec3      writtenMomentum;
+};
+
+// Ce qu'un lien garde d'un pas à l'autre, pour les instantanés du Planet
+struct ArticulationLinkState {
+	float     angle;
+	glm::vec4 rotation;
+	glm::vec3 jointSpeed;
+	glm::vec3 jointTorque;
+	glm::vec3 writtenSpeed;
+	glm::vec3 writtenMomentum;
+};
+
+// Arbre de solides en coordonnées réduites : seules les coordonnées articulaires et la pose de la racine sont intégrées,
+// les liaisons sont donc exactes. Les accélérations sont obtenues en O(n) par l'algorithme de Featherstone (articulated body).
+// Les poses et vitesses des solides sont recopiées dans leur BodyStore, où les contacts les lisent et les modifient ;
+// ces modifications sont ramenées sur les coordonnées articulaires par project.
+class Articulation {
+  private:
+	std::vector<ArticulationLink> m_links;       // un parent est toujours placé avant ses enfants
+	std::vector<Joint*>           m_loopJoints;  // liaisons qui fermeraient une boucle, laissées au solveur par impulsions
+	bool                          m_fixedBase;   // racine bloquée (Solid verrouillé)
+	glm::vec3                     m_origin;      // centre d'inertie de la racine au début du pas
+
+	void          computeKinematics();
+	void          computeSpatialQuantities();
+	void          readRootVelocity();
+	void          computeVelocities();
+	void          writeVelocities();
+	void          solve(bool impulse);
+	SpatialVector solveBase(SpatialVector const& force) const;
+	int           findLink(Joint* joint) const;
+	WorldObject*  getFirstMobile() const;  // racine, ou premier enfant d'une racine bloquée
+
+  public:
+	// Le premier objet est la racine. Les liaisons autres que BallJoint, HingeJoint et FixedJoint restent aux impulsions
+	Articulation(std::vector<WorldObject*> const& worldObjects, std::vector<Joint*> const& joints);
+
+	std::vector<ArticulationLink>& getLinks();
+	std::vector<Joint*>&           getLoopJoints();
+	bool                           getFixedBase() const;
+	bool                           isAwake() const;  // tous les solides mobiles de l'arbre appartiennent à la même île
+	Articulation&                  applyJointTorque(Joint* joint, float torque);      // autour de l'axe d'un pivot
+	Articulation&                  applyJointTorque(Joint* joint, glm::vec3 torque);  // du premier objet sur le second, repère monde
+	Articulation&                  pull();  // relit les coordonnées articulaires depuis les poses et vitesses des objets
+
+	void prepare(double deltaTime);  // forces accumulées et couples moteurs versés dans les vitesses articulaires
+	void project();                  // impulsions reçues par les solides depuis prepare propagées dans l'arbre
+	void integrate(double deltaTime);
+	void sleep();  // vitesses articulaires annulées, comme celles des solides endormis
+	void save(ArticulationLinkState* states) const;  // getLinks().size() états
+	void restore(ArticulationLinkState const* states);
+
+	~Articulation();
+};
+
+#endif
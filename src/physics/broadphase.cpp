@@ -0,0 +1,428 @@
+#include "broadphase.hpp"
+#include "../maths/utils.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+
+/* --- SWEEPANDPRUNE --- */
+
+
+
+SweepAndPrune::SweepAndPrune() {}
+
+uint64_t SweepAndPrune::getKey(unsigned int proxy1, unsigned int proxy2) {
+	if (proxy1 > proxy2) {
+		swap(proxy1, proxy2);
+	}
+	return ((uint64_t)proxy1 << 32) | proxy2;
+}
+
+// À valeur égale, un min passe avant un max : deux boîtes qui se touchent se chevauchent sur l'axe, comme pour AABB::overlaps
+bool SweepAndPrune::isBefore(Endpoint const& endpoint1, Endpoint const& endpoint2) {
+	return endpoint1.value < endpoint2.value || (endpoint1.value == endpoint2.value && !endpoint1.isMax && endpoint2.isMax);
+}
+
+// Les nouvelles extrémités sont ajoutées en fin de tableau, après toutes les autres :
+// le prochain tri les ramène à leur place en créant au passage les paires du nouveau volume
+unsigned int SweepAndPrune::add(AABB const& box, WorldObject* worldObject, BoundingBox* boundingBox) {
+	unsigned int proxy;
+	if (!m_freeProxies.empty()) {
+		proxy = m_freeProxies.back();
+		m_freeProxies.pop_back();
+	} else {
+		proxy = m_proxies.size();
+		m_proxies.push_back(BroadPhaseProxy());
+		m_partners.push_back(vector<unsigned int>());
+	}
+	m_proxies[proxy] = {box, worldObject, boundingBox, true};
+
+	for (unsigned int axis = 0; axis < 3; axis++) {
+		m_endpoints[axis].push_back({numeric_limits<float>::max(), proxy, false});
+		m_endpoints[axis].push_back({numeric_limits<float>::max(), proxy, true});
+	}
+	return proxy;
+}
+
+void SweepAndPrune::remove(unsigned int proxy) {
+	if (proxy >= m_proxies.size() || !m_proxies[proxy].alive) {
+		return;
+	}
+
+	for (unsigned int axis = 0; axis < 3; axis++) {
+		vector<Endpoint>& endpoints = m_endpoints[axis];
+		endpoints.erase(remove_if(endpoints.begin(), endpoints.end(), [&](Endpoint const& endpoint) { return endpoint.proxy == proxy; }),
+		                endpoints.end());
+	}
+
+	while (!m_partners[proxy].empty()) {
+		this->removePair(proxy, m_partners[proxy].back());
+	}
+
+	m_proxies[proxy].alive = false;
+	m_freeProxies.push_back(proxy);
+}
+
+void SweepAndPrune::remove(WorldObject* worldObject) {
+	for (unsigned int proxy = 0; proxy < m_proxies.size(); proxy++) {
+		if (m_proxies[proxy].alive && m_proxies[proxy].worldObject == worldObject) {
+			this->remove(proxy);
+		}
+	}
+}
+
+void SweepAndPrune::setAABB(unsigned int proxy, AABB const& box) { m_proxies[proxy].box = box; }
+
+vector<BroadPhaseProxy>& SweepAndPrune::getProxies() { return m_proxies; }
+unsigned int             SweepAndPrune::getNbrProxies() const { return m_proxies.size() - m_freeProxies.size(); }
+
+// Les volumes d'un même objet ne se testent pas entre eux
+bool SweepAndPrune::canCollide(unsigned int proxy1, unsigned int proxy2) const {
+	WorldObject* worldObject = m_proxies[proxy1].worldObject;
+	return worldObject == nullptr || worldObject != m_proxies[proxy2].worldObject;
+}
+
+void SweepAndPrune::addPair(unsigned int proxy1, unsigned int proxy2) {
+	if (m_pairSet.insert(getKey(proxy1, proxy2)).second) {
+		m_partners[proxy1].push_back(proxy2);
+		m_partners[proxy2].push_back(proxy1);
+	}
+}
+
+void SweepAndPrune::removePair(unsigned int proxy1, unsigned int proxy2) {
+	if (m_pairSet.erase(getKey(proxy1, proxy2)) == 0) {
+		return;
+	}
+	for (auto [proxy, partner] : {pair(proxy1, proxy2), pair(proxy2, proxy1)}) {
+		vector<unsigned int>& partners = m_partners[proxy];
+		auto                  it = find(partners.begin(), partners.end(), partner);
+		*it = partners.back();
+		partners.pop_back();
+	}
+}
+
+// Tri par insertion : quand un min passe à gauche d'un max, les intervalles commencent à se chevaucher sur cet axe,
+// quand un max passe à gauche d'un min, ils se séparent. Les boîtes étant toutes à jour, le test complet tranche.
+void SweepAndPrune::sortAxis(unsigned int axis) {
+	vector<Endpoint>& endpoints = m_endpoints[axis];
+
+	for (unsigned int i = 1; i < endpoints.size(); i++) {
+		Endpoint     endpoint = endpoints[i];
+		unsigned int j = i;
+
+		while (j > 0 && isBefore(endpoint, endpoints[j - 1])) {
+			Endpoint const& other = endpoints[j - 1];
+
+			if (!endpoint.isMax && other.isMax) {
+				if (this->canCollide(endpoint.proxy, other.proxy) && m_proxies[endpoint.proxy].box.overlaps(m_proxies[other.proxy].box)) {
+					this->addPair(endpoint.proxy, other.proxy);
+				}
+			} else if (endpoint.isMax && !other.isMax) {
+				this->removePair(endpoint.proxy, other.proxy);
+			}
+
+			endpoints[j] = other;
+			j--;
+		}
+		endpoints[j] = endpoint;
+	}
+}
+
+void SweepAndPrune::update() {
+	for (unsigned int axis = 0; axis < 3; axis++) {
+		for (Endpoint& endpoint : m_endpoints[axis]) {
+			AABB const& box = m_proxies[endpoint.proxy].box;
+			endpoint.value = endpoint.isMax ? box.max[axis] : box.min[axis];
+		}
+		this->sortAxis(axis);
+	}
+
+	// Ordre indépendant de la table de hachage : la phase étroite traite les paires toujours dans le même ordre
+	m_pairs.clear();
+	m_pairs.reserve(m_pairSet.size());
+	for (uint64_t key : m_pairSet) {
+		m_pairs.push_back({(unsigned int)(key >> 32), (unsigned int)(key & 0xffffffff)});
+	}
+	sort(m_pairs.begin(), m_pairs.end(), [](BroadPhasePair const& pair1, BroadPhasePair const& pair2) {
+		return pair1.proxy1 != pair2.proxy1 ? pair1.proxy1 < pair2.proxy1 : pair1.proxy2 < pair2.proxy2;
+	});
+}
+
+vector<BroadPhasePair>& SweepAndPrune::getPairs() { return m_pairs; }
+
+SweepAndPrune::~SweepAndPrune() {}
+
+
+
+/* --- DYNAMICTREE --- */
+
+
+
+DynamicTree::DynamicTree(float margin, float displacementFactor)
+    : m_nodes(vector<TreeNode>()),
+      m_root(NULL_NODE),
+      m_freeList(NULL_NODE),
+      m_nbrProxies(0),
+      m_margin(margin),
+      m_displacementFactor(displacementFactor) {}
+
+unsigned int DynamicTree::allocateNode() {
+	unsigned int node;
+	if (m_freeList != NULL_NODE) {
+		node = m_freeList;
+		m_freeList = m_nodes[node].parent;
+	} else {
+		node = m_nodes.size();
+		m_nodes.push_back(TreeNode());
+	}
+	m_nodes[node] = {AABB(), NULL_NODE, NULL_NODE, NULL_NODE, 0, nullptr, nullptr};
+	return node;
+}
+
+void DynamicTree::freeNode(unsigned int node) {
+	m_nodes[node].parent = m_freeList;
+	m_nodes[node].height = -1;
+	m_freeList = node;
+}
+
+// Descente vers le voisin qui minimise l'augmentation de surface totale (heuristique de surface)
+void DynamicTree::insertLeaf(unsigned int leaf) {
+	if (m_root == NULL_NODE) {
+		m_root = leaf;
+		m_nodes[leaf].parent = NULL_NODE;
+		return;
+	}
+
+	AABB         leafBox = m_nodes[leaf].box;
+	unsigned int index = m_root;
+	while (!m_nodes[index].isLeaf()) {
+		unsigned int child1 = m_nodes[index].child1;
+		unsigned int child2 = m_nodes[index].child2;
+
+		float area = m_nodes[index].box.getSurfaceArea();
+		float combinedArea = m_nodes[index].box.merge(leafBox).getSurfaceArea();
+
+		// Coût de créer un nouveau parent ici, et coût minimal hérité par les descendants
+		float cost = 2 * combinedArea;
+		float inheritanceCost = 2 * (combinedArea - area);
+
+		float cost1 = leafBox.merge(m_nodes[child1].box).getSurfaceArea() + inheritanceCost;
+		if (!m_nodes[child1].isLeaf()) {
+			cost1 -= m_nodes[child1].box.getSurfaceArea();
+		}
+		float cost2 = leafBox.merge(m_nodes[child2].box).getSurfaceArea() + inheritanceCost;
+		if (!m_nodes[child2].isLeaf()) {
+			cost2 -= m_nodes[child2].box.getSurfaceArea();
+		}
+
+		if (cost < cost1 && cost < cost2) {
+			break;
+		}
+		index = cost1 < cost2 ? child1 : child2;
+	}
+
+	// Le voisin choisi et la feuille deviennent les enfants d'un nouveau parent
+	unsigned int sibling = index;
+	unsigned int oldParent = m_nodes[sibling].parent;
+	unsigned int newParent = this->allocateNode();
+	m_nodes[newParent].parent = oldParent;
+	m_nodes[newParent].box = leafBox.merge(m_nodes[sibling].box);
+	m_nodes[newParent].height = m_nodes[sibling].height + 1;
+	m_nodes[newParent].child1 = sibling;
+	m_nodes[newParent].child2 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent == NULL_NODE) {
+		m_root = newParent;
+	} else if (m_nodes[oldParent].child1 == sibling) {
+		m_nodes[oldParent].child1 = newParent;
+	} else {
+		m_nodes[oldParent].child2 = newParent;
+	}
+
+	// Remontée : équilibrage, hauteurs et boîtes
+	index = m_nodes[leaf].parent;
+	while (index != NULL_NODE) {
+		index = this->balance(index);
+
+		unsigned int child1 = m_nodes[index].child1;
+		unsigned int child2 = m_nodes[index].child2;
+		m_nodes[index].height = 1 + max(m_nodes[child1].height, m_nodes[child2].height);
+		m_nodes[index].box = m_nodes[child1].box.merge(m_nodes[child2].box);
+
+		index = m_nodes[index].parent;
+	}
+}
+
+void DynamicTree::removeLeaf(unsigned int leaf) {
+	if (leaf == m_root) {
+		m_root = NULL_NODE;
+		return;
+	}
+
+	unsigned int parent = m_nodes[leaf].parent;
+	unsigned int grandParent = m_nodes[parent].parent;
+	unsigned int sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+	// Le voisin prend la place du parent
+	if (grandParent == NULL_NODE) {
+		m_root = sibling;
+		m_nodes[sibling].parent = NULL_NODE;
+		this->freeNode(parent);
+		return;
+	}
+
+	if (m_nodes[grandParent].child1 == parent) {
+		m_nodes[grandParent].child1 = sibling;
+	} else {
+		m_nodes[grandParent].child2 = sibling;
+	}
+	m_nodes[sibling].parent = grandParent;
+	this->freeNode(parent);
+
+	unsigned int index = grandParent;
+	while (index != NULL_NODE) {
+		index = this->balance(index);
+
+		unsigned int child1 = m_nodes[index].child1;
+		unsigned int child2 = m_nodes[index].child2;
+		m_nodes[index].box = m_nodes[child1].box.merge(m_nodes[child2].box);
+		m_nodes[index].height = 1 + max(m_nodes[child1].height, m_nodes[child2].height);
+
+		index = m_nodes[index].parent;
+	}
+}
+
+// Rotation si les hauteurs des deux enfants de node diffèrent de plus de 1, renvoie le noeud qui a pris sa place
+unsigned int DynamicTree::balance(unsigned int a) {
+	if (m_nodes[a].isLeaf() || m_nodes[a].height < 2) {
+		return a;
+	}
+
+	unsigned int b = m_nodes[a].child1;
+	unsigned int c = m_nodes[a].child2;
+	int          difference = m_nodes[c].height - m_nodes[b].height;
+	if (difference >= -1 && difference <= 1) {
+		return a;
+	}
+
+	// L'enfant le plus haut monte à la place de a, a prend la place de son petit-enfant le plus haut
+	bool         rotateUpC = difference > 1;
+	unsigned int up = rotateUpC ? c : b;
+	unsigned int down = rotateUpC ? b : c;
+	unsigned int f = m_nodes[up].child1;
+	unsigned int g = m_nodes[up].child2;
+
+	m_nodes[up].child1 = a;
+	m_nodes[up].parent = m_nodes[a].parent;
+	m_nodes[a].parent = up;
+
+	if (m_nodes[up].parent == NULL_NODE) {
+		m_root = up;
+	} else if (m_nodes[m_nodes[up].parent].child1 == a) {
+		m_nodes[m_nodes[up].parent].child1 = up;
+	} else {
+		m_nodes[m_nodes[up].parent].child2 = up;
+	}
+
+	// Le petit-enfant le plus haut reste sous up, l'autre descend sous a à côté de down
+	unsigned int kept = m_nodes[f].height > m_nodes[g].height ? f : g;
+	unsigned int moved = kept == f ? g : f;
+	m_nodes[up].child2 = kept;
+	if (rotateUpC) {
+		m_nodes[a].child2 = moved;
+	} else {
+		m_nodes[a].child1 = moved;
+	}
+	m_nodes[moved].parent = a;
+
+	m_nodes[a].box = m_nodes[down].box.merge(m_nodes[moved].box);
+	m_nodes[a].height = 1 + max(m_nodes[down].height, m_nodes[moved].height);
+	m_nodes[up].box = m_nodes[a].box.merge(m_nodes[kept].box);
+	m_nodes[up].height = 1 + max(m_nodes[a].height, m_nodes[kept].height);
+
+	return up;
+}
+
+unsigned int DynamicTree::createProxy(AABB const& box, WorldObject* worldObject, BoundingBox* boundingBox) {
+	unsigned int proxy = this->allocateNode();
+	m_nodes[proxy].box = {box.min - glm::vec3(m_margin), box.max + glm::vec3(m_margin)};
+	m_nodes[proxy].worldObject = worldObject;
+	m_nodes[proxy].boundingBox = boundingBox;
+	this->insertLeaf(proxy);
+	m_nbrProxies++;
+	return proxy;
+}
+
+void DynamicTree::destroyProxy(unsigned int proxy) {
+	this->removeLeaf(proxy);
+	this->freeNode(proxy);
+	m_nbrProxies--;
+}
+
+void DynamicTree::remove(WorldObject* worldObject) {
+	for (unsigned int node = 0; node < m_nodes.size(); node++) {
+		if (m_nodes[node].height == 0 && m_nodes[node].worldObject == worldObject) {
+			this->destroyProxy(node);
+		}
+	}
+}
+
+// Rien à faire tant que la boîte reste dans l'AABB élargie de la feuille
+bool DynamicTree::moveProxy(unsigned int proxy, AABB const& box, glm::vec3 displacement) {
+	if (m_nodes[proxy].box.contains(box)) {
+		return false;
+	}
+
+	this->removeLeaf(proxy);
+
+	// Élargie de la marge, et étirée dans le sens du mouvement
+	AABB      fatBox = {box.min - glm::vec3(m_margin), box.max + glm::vec3(m_margin)};
+	glm::vec3 stretch = displacement * m_displacementFactor;
+	fatBox.min += glm::min(stretch, glm::vec3(0));
+	fatBox.max += glm::max(stretch, glm::vec3(0));
+
+	m_nodes[proxy].box = fatBox;
+	this->insertLeaf(proxy);
+	return true;
+}
+
+TreeNode const& DynamicTree::getNode(unsigned int node) const { return m_nodes[node]; }
+unsigned int    DynamicTree::getCapacity() const { return m_nodes.size(); }
+unsigned int    DynamicTree::getNbrProxies() const { return m_nbrProxies; }
+int             DynamicTree::getHeight() const { return m_root == NULL_NODE ? 0 : m_nodes[m_root].height; }
+
+void DynamicTree::query(AABB const& box, function<bool(unsigned int)> callback) const {
+	vector<unsigned int> stack;
+	if (m_root != NULL_NODE) {
+		stack.push_back(m_root);
+	}
+
+	while (!stack.empty()) {
+		unsigned int node = stack.back();
+		stack.pop_back();
+
+		if (!m_nodes[node].box.overlaps(box)) {
+			continue;
+		}
+		if (m_nodes[node].isLeaf()) {
+			if (!callback(node)) {
+				return;
+			}
+		} else {
+			stack.push_back(m_nodes[node].child1);
+			stack.push_back(m_nodes[node].child2);
+		}
+	}
+}
+
+DynamicTree::~DynamicTree() {}
@@ -0,0 +1,154 @@
+#ifndef PHYSICS_BROADPHASE
+#define PHYSICS_BROADPHASE
+
+#include "../maths/utils.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+class WorldObject;
+class BoundingBox;
+
+// Paire de volumes dont les AABB se chevauchent, à confirmer par la phase étroite (proxy1 < proxy2)
+struct BroadPhasePair {
+	unsigned int proxy1;
+	unsigned int proxy2;
+};
+
+// Un volume suivi par la phase large
+struct BroadPhaseProxy {
+	AABB         box;
+	WorldObject* worldObject;
+	BoundingBox* boundingBox;
+	bool         alive;
+};
+
+// Sweep and prune incrémental : les extrémités des AABB restent triées sur les trois axes d'un pas à l'autre.
+// Les objets bougeant peu entre deux pas, le tri par insertion est presque linéaire
+// et chaque échange d'extrémités signale exactement un début ou une fin de chevauchement sur un axe.
+class SweepAndPrune {
+  private:
+	// value est recopiée depuis la boîte pour que le tri ne parcoure que des données contiguës
+	struct Endpoint {
+		float        value;
+		unsigned int proxy;
+		bool         isMax;
+	};
+
+	std::vector<BroadPhaseProxy>           m_proxies;
+	std::vector<unsigned int>              m_freeProxies;
+	std::vector<Endpoint>                  m_endpoints[3];
+	std::unordered_set<uint64_t>           m_pairSet;
+	// Partenaires de chaque proxy, pour retirer ses paires sans parcourir m_pairSet
+	std::vector<std::vector<unsigned int>> m_partners;
+	std::vector<BroadPhasePair>            m_pairs;  // m_pairSet trié, reconstruit à chaque mise à jour
+
+	static uint64_t getKey(unsigned int proxy1, unsigned int proxy2);
+	static bool     isBefore(Endpoint const& endpoint1, Endpoint const& endpoint2);
+	bool            canCollide(unsigned int proxy1, unsigned int proxy2) const;
+	void            addPair(unsigned int proxy1, unsigned int proxy2);
+	void            removePair(unsigned int proxy1, unsigned int proxy2);
+	void            sortAxis(unsigned int axis);
+
+  public:
+	SweepAndPrune();
+
+	unsigned int                  add(AABB const& box, WorldObject* worldObject = nullptr, BoundingBox* boundingBox = nullptr);
+	void                          remove(unsigned int proxy);
+	void                          remove(WorldObject* worldObject);              // tous les volumes de l'objet
+	void                          setAABB(unsigned int proxy, AABB const& box);  // prise en compte au prochain update
+	std::vector<BroadPhaseProxy>& getProxies();  // indexés par proxy, certains peuvent être libres (alive à false)
+	unsigned int                  getNbrProxies() const;
+	void                          update();
+	std::vector<BroadPhasePair>&  getPairs();
+
+	~SweepAndPrune();
+};
+
+
+
+const unsigned int NULL_NODE = 0xffffffff;
+
+// Noeud de l'arbre : les feuilles portent un volume, les noeuds internes l'union de leurs deux enfants
+struct TreeNode {
+	AABB         box;     // élargie de la marge pour les feuilles
+	unsigned int parent;  // noeud suivant de la liste libre si le noeud est libre
+	unsigned int child1;
+	unsigned int child2;
+	int          height;  // 0 pour une feuille, -1 pour un noeud libre
+	WorldObject* worldObject;
+	BoundingBox* boundingBox;
+
+	bool isLeaf() const { return child1 == NULL_NODE; }
+};
+
+// Arbre dynamique de boîtes englobantes pour les requêtes sur le monde (régions, rayons).
+// Les feuilles gardent une AABB élargie : un volume qui bouge peu n'est pas réinséré.
+// Les rotations après chaque insertion et suppression gardent l'arbre équilibré.
+class DynamicTree {
+  private:
+	std::vector<TreeNode> m_nodes;
+	unsigned int          m_root;
+	unsigned int          m_freeList;
+	unsigned int          m_nbrProxies;
+	float                 m_margin;              // élargissement des AABB des feuilles
+	float                 m_displacementFactor;  // anticipation du déplacement au pas suivant
+
+	unsigned int allocateNode();
+	void         freeNode(unsigned int node);
+	void         insertLeaf(unsigned int leaf);
+	void         removeLeaf(unsigned int leaf);
+	unsigned int balance(unsigned int node);
+
+  public:
+	DynamicTree(float margin = 0.1, float displacementFactor = 2);
+
+	unsigned int    createProxy(AABB const& box, WorldObject* worldObject = nullptr, BoundingBox* boundingBox = nullptr);
+	void            destroyProxy(unsigned int proxy);
+	void            remove(WorldObject* worldObject);  // tous les volumes de l'objet
+	bool            moveProxy(unsigned int proxy, AABB const& box, glm::vec3 displacement = glm::vec3(0));  // true si réinséré
+	TreeNode const& getNode(unsigned int node) const;
+	unsigned int    getCapacity() const;  // les proxies sont les indices des feuilles, entre 0 et getCapacity()
+	unsigned int    getNbrProxies() const;
+	int             getHeight() const;
+
+	// callback(proxy) renvoie false pour arrêter la requête
+	void query(AABB const& box, std::function<bool(unsigned int)> callback) const;
+	// callback(proxy, maxDistance) renvoie la nouvelle distance maximale : la distance d'un impact pour ne garder que le plus proche,
+	// maxDistance pour continuer sans rien changer, 0 pour arrêter.
+	// Ni allocation ni std::function : ce parcours se répète à chaque rayon des lots de capteurs
+	template <class Callback> void raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, Callback&& callback) const;
+
+	~DynamicTree();
+};
+
+const unsigned int TREE_STACK_SIZE = 256;  // pile du parcours, bien au-delà de la hauteur d'un arbre équilibré
+
+template <class Callback> void DynamicTree::raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, Callback&& callback) const {
+	glm::vec3    inverseDirection = 1.0f / direction;
+	unsigned int stack[TREE_STACK_SIZE];
+	unsigned int size = 0;
+	if (m_root != NULL_NODE) {
+		stack[size++] = m_root;
+	}
+
+	while (size > 0) {
+		unsigned int node = stack[--size];
+		if (!m_nodes[node].box.intersectsRay(origin, inverseDirection, maxDistance)) {
+			continue;
+		}
+		if (m_nodes[node].isLeaf()) {
+			maxDistance = callback(node, maxDistance);
+			if (maxDistance <= 0) {
+				return;
+			}
+		} else {
+			stack[size++] = m_nodes[node].child1;
+			stack[size++] = m_nodes[node].child2;
+		}
+	}
+}
+
+#endif
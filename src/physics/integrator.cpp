@@ -0,0 +1,202 @@
+#include "integrator.hpp"
+#include "main.hpp"
+#include "../maths/utils.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+using namespace std;
+
+
+
+/* --- INTEGRATOR --- */
+
+
+
+Integrator::Integrator(bool exponentialMap) : m_exponentialMap(exponentialMap) {}
+
+bool Integrator::getExponentialMap() const { return m_exponentialMap; }
+
+glm::vec4 Integrator::rotate(glm::vec4 const& orientation, glm::vec3 const& angularSpeed, float deltaTime) const {
+	if (m_exponentialMap) {
+		return quaternionIntegrate(orientation, angularSpeed, deltaTime);
+	}
+
+	// dq/dt = 1/2 . w . q
+	glm::vec4 derivative = 0.5f * quaternionProduct(glm::vec4(angularSpeed, 0), orientation);
+	glm::vec4 result = orientation + derivative * deltaTime;
+	return result / glm::length(result);
+}
+
+// L = I . w <=> w = I-1 . L, avec I-1 = R . I0-1 . Rt pour une orientation quelconque
+glm::vec3 Integrator::getAngularSpeed(BodyStore& store, unsigned int index, glm::vec4 const& orientation,
+                                      glm::vec3 const& angularMomentum) const {
+	glm::mat3 rotation = quaternionMatrix(orientation);
+	return rotation * (store.getInverseInertias()[index] * (glm::transpose(rotation) * angularMomentum));
+}
+
+// La rotation se fait autour du centre d'inertie, qui s'est déplacé de displacement
+void Integrator::setOrientation(BodyStore& store, unsigned int index, glm::vec4 const& orientation, glm::vec3 const& displacement) const {
+	glm::vec3 localCenter = store.getInertiaCenters()[index];
+	glm::vec3 inertiaCenter = store.getPositions()[index] + quaternionRotate(store.getOrientations()[index], localCenter) + displacement;
+
+	store.getOrientations()[index] = orientation;
+	store.getPositions()[index] = inertiaCenter - quaternionRotate(orientation, localCenter);
+	store.updateWorldInverseInertia(index);
+}
+
+Integrator* Integrator::create(IntegratorType type, bool exponentialMap) {
+	switch (type) {
+		case VelocityVerlet:
+			return new VelocityVerletIntegrator(exponentialMap);
+		case RungeKutta4:
+			return new RungeKutta4Integrator(exponentialMap);
+		default:
+			return new SemiImplicitEulerIntegrator(exponentialMap);
+	}
+}
+
+// Utilisé par les objets qui n'appartiennent à aucun Planet
+Integrator& Integrator::getDefault() {
+	static SemiImplicitEulerIntegrator integrator;
+	return integrator;
+}
+
+Integrator::~Integrator() {}
+
+
+
+/* --- SEMIIMPLICITEULERINTEGRATOR --- */
+
+
+
+SemiImplicitEulerIntegrator::SemiImplicitEulerIntegrator(bool exponentialMap) : Integrator::Integrator(exponentialMap) {}
+
+const char* SemiImplicitEulerIntegrator::getName() const { return "semi-implicit Euler"; }
+
+void SemiImplicitEulerIntegrator::integrate(BodyStore& store, unsigned int begin, unsigned int end, double deltaTime) const {
+	float              dt = (float)deltaTime;
+	vector<glm::vec3>& velocities = store.getVelocities();
+	vector<glm::vec3>& angularMomenta = store.getAngularMomenta();
+	vector<glm::vec3>& forces = store.getForces();
+	vector<glm::vec3>& torques = store.getTorques();
+	vector<float>&     inverseMasses = store.getInverseMasses();
+	vector<glm::mat3>& worldInverseInertias = store.getWorldInverseInertias();
+	vector<glm::vec4>& orientations = store.getOrientations();
+
+	for (unsigned int i = begin; i < end; i++) {
+		if (inverseMasses[i] == 0) {  // solide bloqué
+			forces[i] = glm::vec3(0);
+			torques[i] = glm::vec3(0);
+			continue;
+		}
+
+		// Les vitesses d'abord, puis les positions avec les nouvelles vitesses
+		velocities[i] += forces[i] * inverseMasses[i] * dt;  // a = F / m et dv / dt = a
+		angularMomenta[i] += torques[i] * dt;                // dL / dt = ∑M
+		forces[i] = glm::vec3(0);
+		torques[i] = glm::vec3(0);
+
+		glm::vec3 angularSpeed = worldInverseInertias[i] * angularMomenta[i];
+		this->setOrientation(store, i, this->rotate(orientations[i], angularSpeed, dt), velocities[i] * dt);
+	}
+}
+
+SemiImplicitEulerIntegrator::~SemiImplicitEulerIntegrator() {}
+
+
+
+/* --- VELOCITYVERLETINTEGRATOR --- */
+
+
+
+VelocityVerletIntegrator::VelocityVerletIntegrator(bool exponentialMap) : Integrator::Integrator(exponentialMap) {}
+
+const char* VelocityVerletIntegrator::getName() const { return "velocity Verlet"; }
+
+void VelocityVerletIntegrator::integrate(BodyStore& store, unsigned int begin, unsigned int end, double deltaTime) const {
+	float              dt = (float)deltaTime;
+	vector<glm::vec3>& velocities = store.getVelocities();
+	vector<glm::vec3>& angularMomenta = store.getAngularMomenta();
+	vector<glm::vec3>& forces = store.getForces();
+	vector<glm::vec3>& torques = store.getTorques();
+	vector<float>&     inverseMasses = store.getInverseMasses();
+	vector<glm::mat3>& worldInverseInertias = store.getWorldInverseInertias();
+	vector<glm::vec4>& orientations = store.getOrientations();
+
+	for (unsigned int i = begin; i < end; i++) {
+		if (inverseMasses[i] == 0) {
+			forces[i] = glm::vec3(0);
+			torques[i] = glm::vec3(0);
+			continue;
+		}
+
+		// Demi-pas : v(t + dt/2) = v(t) + a . dt/2
+		glm::vec3 acceleration = forces[i] * inverseMasses[i];
+		velocities[i] += acceleration * (dt / 2);
+		angularMomenta[i] += torques[i] * (dt / 2);
+
+		// Pas complet des positions avec les vitesses du milieu du pas
+		glm::vec3 angularSpeed = worldInverseInertias[i] * angularMomenta[i];
+		this->setOrientation(store, i, this->rotate(orientations[i], angularSpeed, dt), velocities[i] * dt);
+
+		// Second demi-pas avec la force du début du pas, non réévaluée
+		velocities[i] += acceleration * (dt / 2);
+		angularMomenta[i] += torques[i] * (dt / 2);
+		forces[i] = glm::vec3(0);
+		torques[i] = glm::vec3(0);
+	}
+}
+
+VelocityVerletIntegrator::~VelocityVerletIntegrator() {}
+
+
+
+/* --- RUNGEKUTTA4INTEGRATOR --- */
+
+
+
+RungeKutta4Integrator::RungeKutta4Integrator(bool exponentialMap) : Integrator::Integrator(exponentialMap) {}
+
+const char* RungeKutta4Integrator::getName() const { return "Runge-Kutta 4"; }
+
+void RungeKutta4Integrator::integrate(BodyStore& store, unsigned int begin, unsigned int end, double deltaTime) const {
+	float              dt = (float)deltaTime;
+	vector<glm::vec3>& velocities = store.getVelocities();
+	vector<glm::vec3>& angularMomenta = store.getAngularMomenta();
+	vector<glm::vec3>& forces = store.getForces();
+	vector<glm::vec3>& torques = store.getTorques();
+	vector<float>&     inverseMasses = store.getInverseMasses();
+	vector<glm::vec4>& orientations = store.getOrientations();
+
+	for (unsigned int i = begin; i < end; i++) {
+		if (inverseMasses[i] == 0) {
+			forces[i] = glm::vec3(0);
+			torques[i] = glm::vec3(0);
+			continue;
+		}
+
+		// Force constante : la translation est exacte, x += v . dt + a . dt² / 2
+		glm::vec3 acceleration = forces[i] * inverseMasses[i];
+		glm::vec3 displacement = velocities[i] * dt + acceleration * (dt * dt / 2);
+		velocities[i] += acceleration * dt;
+
+		// La vitesse angulaire dépend de l'orientation (I-1 = R . I0-1 . Rt) : quatre évaluations sur le pas
+		glm::vec4 q = orientations[i];
+		glm::vec3 L = angularMomenta[i];
+		glm::vec3 halfL = L + torques[i] * (dt / 2);
+		glm::vec3 endL = L + torques[i] * dt;
+
+		glm::vec3 w1 = this->getAngularSpeed(store, i, q, L);
+		glm::vec3 w2 = this->getAngularSpeed(store, i, this->rotate(q, w1, dt / 2), halfL);
+		glm::vec3 w3 = this->getAngularSpeed(store, i, this->rotate(q, w2, dt / 2), halfL);
+		glm::vec3 w4 = this->getAngularSpeed(store, i, this->rotate(q, w3, dt), endL);
+
+		angularMomenta[i] = endL;
+		forces[i] = glm::vec3(0);
+		torques[i] = glm::vec3(0);
+		this->setOrientation(store, i, this->rotate(q, (w1 + 2.0f * w2 + 2.0f * w3 + w4) / 6.0f, dt), displacement);
+	}
+}
+
+RungeKutta4Integrator::~RungeKutta4Integrator() {}
@@ -0,0 +1,74 @@
+#ifndef PHYSICS_INTEGRATOR
+#define PHYSICS_INTEGRATOR
+
+#include "../maths/utils.hpp"
+#include <glm/glm.hpp>
+
+class BodyStore;
+
+enum IntegratorType { SemiImplicitEuler, VelocityVerlet, RungeKutta4 };
+
+// Avance les lignes [begin, end) d'un BodyStore d'un pas de temps.
+// Les forces et moments accumulés sont supposés constants pendant le pas, puis remis à 0.
+class Integrator {
+  protected:
+	bool m_exponentialMap;  // rotation exacte exp(w . dt / 2) plutôt que q += dq/dt . dt renormalisé
+
+	glm::vec4 rotate(glm::vec4 const& orientation, glm::vec3 const& angularSpeed, float deltaTime) const;
+	glm::vec3 getAngularSpeed(BodyStore& store, unsigned int index, glm::vec4 const& orientation, glm::vec3 const& angularMomentum) const;
+	void      setOrientation(BodyStore& store, unsigned int index, glm::vec4 const& orientation, glm::vec3 const& displacement) const;
+
+  public:
+	Integrator(bool exponentialMap = true);
+
+	bool                getExponentialMap() const;
+	virtual const char* getName() const = 0;
+	virtual void        integrate(BodyStore& store, unsigned int begin, unsigned int end, double deltaTime) const = 0;
+
+	static Integrator* create(IntegratorType type, bool exponentialMap = true);
+	static Integrator& getDefault();
+
+	virtual ~Integrator();
+};
+
+
+// Les intégrateurs
+
+// v += a . dt puis x += v . dt : stable là où Euler explicite diverge, pour le même coût
+class SemiImplicitEulerIntegrator : public Integrator {
+  public:
+	SemiImplicitEulerIntegrator(bool exponentialMap = true);
+
+	const char* getName() const;
+	void        integrate(BodyStore& store, unsigned int begin, unsigned int end, double deltaTime) const;
+
+	~SemiImplicitEulerIntegrator();
+};
+
+// Demi-pas de vitesse, pas de position, demi-pas de vitesse. Les forces n'étant relevées qu'une fois par pas, le second
+// demi-pas réutilise celles du début : x += v . dt + a . dt² / 2 à accélération constante, sans la réévaluation en fin de pas
+// qui rendrait le schéma symplectique pour des forces dépendant de la position
+class VelocityVerletIntegrator : public Integrator {
+  public:
+	VelocityVerletIntegrator(bool exponentialMap = true);
+
+	const char* getName() const;
+	void        integrate(BodyStore& store, unsigned int begin, unsigned int end, double deltaTime) const;
+
+	~VelocityVerletIntegrator();
+};
+
+// Translation à accélération constante, comme Verlet. Seule la rotation a quatre étages : la vitesse angulaire est recalculée
+// aux orientations intermédiaires (I-1 dépend de l'orientation), le moment cinétique variant linéairement sous le couple du pas.
+// Plus précis pour les rotations rapides et les effets gyroscopiques, mais pas d'ordre 4 pour des forces dépendant de l'état
+class RungeKutta4Integrator : public Integrator {
+  public:
+	RungeKutta4Integrator(bool exponentialMap = true);
+
+	const char* getName() const;
+	void        integrate(BodyStore& store, unsigned int begin, unsigned int end, double deltaTime) const;
+
+	~RungeKutta4Integrator();
+};
+
+#endif
@@ -0,0 +1,324 @@
+#include "island.hpp"
+#include "main.hpp"
+#include "articulation.hpp"
+#include "broadphase.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+using namespace std;
+
+
+
+/* --- ISLANDMANAGER --- */
+
+
+
+IslandManager::IslandManager(float linearThreshold, float angularThreshold, float timeToSleep)
+    : m_linearThreshold(linearThreshold),
+      m_angularThreshold(angularThreshold),
+      m_timeToSleep(timeToSleep),
+      m_enabled(true),
+      m_nbrIslands(0) {}
+
+float        IslandManager::getLinearThreshold() const { return m_linearThreshold; }
+float        IslandManager::getAngularThreshold() const { return m_angularThreshold; }
+float        IslandManager::getTimeToSleep() const { return m_timeToSleep; }
+bool         IslandManager::getEnabled() const { return m_enabled; }
+unsigned int IslandManager::getNbrIslands() const { return m_nbrIslands; }
+
+vector<Island>&        IslandManager::getIslands() { return m_islands; }
+vector<Joint*>&        IslandManager::getJoints() { return m_joints; }
+vector<unsigned int>&  IslandManager::getManifolds() { return m_manifolds; }
+vector<Articulation*>& IslandManager::getArticulations() { return m_articulations; }
+
+IslandManager& IslandManager::setThresholds(float linearThreshold, float angularThreshold) {
+	m_linearThreshold = linearThreshold;
+	m_angularThreshold = angularThreshold;
+	return *this;
+}
+
+IslandManager& IslandManager::setTimeToSleep(float timeToSleep) {
+	m_timeToSleep = timeToSleep;
+	return *this;
+}
+
+IslandManager& IslandManager::setEnabled(bool enabled) {
+	m_enabled = enabled;
+	return *this;
+}
+
+// Compression de chemin par moitiés
+unsigned int IslandManager::find(unsigned int row) {
+	while (m_parents[row] != row) {
+		m_parents[row] = m_parents[m_parents[row]];
+		row = m_parents[row];
+	}
+	return row;
+}
+
+// La plus petite ligne devient la racine : le résultat ne dépend pas de l'ordre des unions
+void IslandManager::unite(unsigned int row1, unsigned int row2) {
+	row1 = this->find(row1);
+	row2 = this->find(row2);
+	if (row1 < row2) {
+		m_parents[row2] = row1;
+	} else if (row2 < row1) {
+		m_parents[row1] = row2;
+	}
+}
+
+bool IslandManager::isMobile(BodyStore& store, WorldObject* worldObject) const {
+	return store.getInverseMasses()[worldObject->getIndex()] > 0;
+}
+
+// Un solide éveillé réveille l'île endormie qu'il touche ; le réveil déplace des lignes, d'où la relecture des indices
+void IslandManager::wakePair(BodyStore& store, WorldObject* worldObject1, WorldObject* worldObject2) {
+	bool awake1 = store.isAwake(worldObject1->getIndex()) && this->isMobile(store, worldObject1);
+	bool awake2 = store.isAwake(worldObject2->getIndex()) && this->isMobile(store, worldObject2);
+	if (awake1 && !awake2) {
+		store.wake(worldObject2->getIndex());
+	} else if (awake2 && !awake1) {
+		store.wake(worldObject1->getIndex());
+	}
+}
+
+unsigned int IslandManager::getIsland(unsigned int row1, unsigned int row2) const {
+	return row1 < m_rowIslands.size() ? m_rowIslands[row1] : m_rowIslands[row2];
+}
+
+// Tri par comptage stable des éléments 0 ... keys.size() - 1 selon leur île : ceux de l'île k finissent dans
+// sorted[offsets[k], offsets[k + 1]). Les éléments de clé nbrIslands n'appartiennent à aucune île et sont écartés
+template <typename T, typename Item>
+static void sortByIsland(vector<unsigned int> const& keys, unsigned int nbrIslands, vector<unsigned int>& offsets, vector<T>& sorted,
+                         Item item) {
+	offsets.assign(nbrIslands + 2, 0);
+	for (unsigned int key : keys) {
+		offsets[key + 1]++;
+	}
+	for (unsigned int k = 0; k <= nbrIslands; k++) {
+		offsets[k + 1] += offsets[k];
+	}
+	sorted.resize(keys.size());
+	for (unsigned int i = 0; i < keys.size(); i++) {
+		sorted[offsets[keys[i]]++] = item(i);
+	}
+
+	// Chaque offsets[k] pointe maintenant sur la fin de l'île k, c'est-à-dire le début de la suivante
+	for (unsigned int k = nbrIslands + 1; k > 0; k--) {
+		offsets[k] = offsets[k - 1];
+	}
+	offsets[0] = 0;
+	sorted.resize(offsets[nbrIslands]);
+}
+
+// Une force qui ne change presque rien au mouvement pendant timeToSleep (le poids d'un objet posé) laisse l'île endormie.
+// Les forces des solides éveillés sont retenues comme référence pour le jour où ils s'endormiront.
+// Un réveil déplace les lignes : les solides à réveiller sont relevés avant, puis seules les lignes restées endormies perdent
+// leurs forces
+void IslandManager::checkForces(BodyStore& store) {
+	vector<glm::vec3>& forces = store.getForces();
+	vector<glm::vec3>& torques = store.getTorques();
+	vector<glm::vec3>& restForces = store.getRestForces();
+	vector<glm::vec3>& restTorques = store.getRestTorques();
+
+	m_island.clear();
+	for (unsigned int i = store.getNbrAwake(); i < store.size(); i++) {
+		float     inverseMass = store.getInverseMasses()[i];
+		glm::vec3 acceleration = (forces[i] - restForces[i]) * inverseMass;
+		glm::vec3 angularAcceleration = store.getWorldInverseInertias()[i] * (torques[i] - restTorques[i]);
+		if (inverseMass > 0 && (glm::length(acceleration) * m_timeToSleep > m_linearThreshold ||
+		                        glm::length(angularAcceleration) * m_timeToSleep > m_angularThreshold)) {
+			m_island.push_back(store.getOwners()[i]);
+		}
+	}
+	for (WorldObject* worldObject : m_island) {
+		store.wake(worldObject->getIndex());
+	}
+
+	for (unsigned int i = store.getNbrAwake(); i < store.size(); i++) {
+		forces[i] = glm::vec3(0);
+		torques[i] = glm::vec3(0);
+	}
+
+	for (unsigned int i = 0; i < store.getNbrAwake(); i++) {
+		restForces[i] = forces[i];
+		restTorques[i] = torques[i];
+	}
+}
+
+void IslandManager::build(BodyStore& store, vector<Contact> const& contacts, SweepAndPrune& broadPhase, vector<Joint*> const& joints,
+                          vector<Articulation*> const& articulations) {
+	vector<BroadPhaseProxy>& proxies = broadPhase.getProxies();
+
+	if (!m_enabled) {
+		for (unsigned int i = store.getNbrAwake(); i < store.size(); i++) {
+			store.wake(i);
+		}
+	}
+
+	// Les solides bloqués ne bougent jamais : ils rejoignent la partie endormie, seuls, dès leur arrivée
+	m_island.clear();
+	for (unsigned int i = 0; i < store.getNbrAwake(); i++) {
+		if (store.getInverseMasses()[i] == 0) {
+			m_island.push_back(store.getOwners()[i]);
+		}
+	}
+	for (WorldObject* worldObject : m_island) {
+		store.sleep({worldObject});
+	}
+
+	// Réveils par contact ou liaison avec un solide éveillé
+	for (Contact const& contact : contacts) {
+		this->wakePair(store, proxies[contact.proxy1].worldObject, proxies[contact.proxy2].worldObject);
+	}
+	for (Joint* joint : joints) {
+		this->wakePair(store, joint->getWorldObject1(), joint->getWorldObject2());
+	}
+
+	// Union-find sur les lignes éveillées, toutes mobiles désormais
+	unsigned int nbrAwake = store.getNbrAwake();
+	m_parents.resize(nbrAwake);
+	for (unsigned int i = 0; i < nbrAwake; i++) {
+		m_parents[i] = i;
+	}
+	for (Contact const& contact : contacts) {
+		unsigned int row1 = proxies[contact.proxy1].worldObject->getIndex();
+		unsigned int row2 = proxies[contact.proxy2].worldObject->getIndex();
+		if (row1 < nbrAwake && row2 < nbrAwake) {
+			this->unite(row1, row2);
+		}
+	}
+	for (Joint* joint : joints) {
+		unsigned int row1 = joint->getWorldObject1()->getIndex();
+		unsigned int row2 = joint->getWorldObject2()->getIndex();
+		if (row1 < nbrAwake && row2 < nbrAwake) {
+			this->unite(row1, row2);
+		}
+	}
+	for (Articulation* articulation : articulations) {
+		unsigned int first = nbrAwake;
+		for (ArticulationLink& link : articulation->getLinks()) {
+			unsigned int row = link.worldObject->getIndex();
+			if (row < nbrAwake) {
+				first = first == nbrAwake ? row : first;
+				this->unite(first, row);
+			}
+		}
+	}
+
+	// La racine d'une île est sa plus petite ligne, déjà numérotée quand ses autres lignes sont atteintes
+	unsigned int nbrIslands = 0;
+	m_keys.resize(nbrAwake);
+	for (unsigned int i = 0; i < nbrAwake; i++) {
+		unsigned int root = this->find(i);
+		m_keys[i] = root == i ? nbrIslands++ : m_keys[root];
+	}
+
+	// Lignes rangées île par île ; une fois rangées, elles ne bougent plus tant que les îles ne changent pas
+	vector<WorldObject*>& owners = store.getOwners();
+	sortByIsland(m_keys, nbrIslands, m_offsets, m_bodies, [&](unsigned int i) { return owners[i]; });
+	store.reorder(m_bodies);
+	m_islands.resize(nbrIslands);
+	m_rowIslands.resize(nbrAwake);
+	for (unsigned int k = 0; k < nbrIslands; k++) {
+		m_islands[k].bodyBegin = m_offsets[k];
+		m_islands[k].bodyEnd = m_offsets[k + 1];
+		for (unsigned int row = m_offsets[k]; row < m_offsets[k + 1]; row++) {
+			m_rowIslands[row] = k;
+		}
+	}
+
+	// Liaisons d'au moins un solide éveillé, dans leur ordre d'origine
+	m_keys.resize(joints.size());
+	for (unsigned int j = 0; j < joints.size(); j++) {
+		unsigned int row1 = joints[j]->getWorldObject1()->getIndex();
+		unsigned int row2 = joints[j]->getWorldObject2()->getIndex();
+		m_keys[j] = row1 < nbrAwake || row2 < nbrAwake ? this->getIsland(row1, row2) : nbrIslands;
+	}
+	sortByIsland(m_keys, nbrIslands, m_offsets, m_joints, [&](unsigned int j) { return joints[j]; });
+	for (unsigned int k = 0; k < nbrIslands; k++) {
+		m_islands[k].jointBegin = m_offsets[k];
+		m_islands[k].jointEnd = m_offsets[k + 1];
+	}
+
+	// Articulations éveillées, dans l'île de leur premier solide mobile
+	m_keys.resize(articulations.size());
+	for (unsigned int a = 0; a < articulations.size(); a++) {
+		m_keys[a] = nbrIslands;
+		for (ArticulationLink& link : articulations[a]->getLinks()) {
+			if (link.worldObject->getIndex() < nbrAwake) {
+				m_keys[a] = m_rowIslands[link.worldObject->getIndex()];
+				break;
+			}
+		}
+	}
+	sortByIsland(m_keys, nbrIslands, m_offsets, m_articulations, [&](unsigned int a) { return articulations[a]; });
+	for (unsigned int k = 0; k < nbrIslands; k++) {
+		m_islands[k].articulationBegin = m_offsets[k];
+		m_islands[k].articulationEnd = m_offsets[k + 1];
+	}
+}
+
+// Les manifolds viennent d'être recalculés avec les lignes rangées par build
+void IslandManager::groupManifolds(vector<ContactManifold> const& manifolds, BodyStore& store) {
+	unsigned int nbrAwake = store.getNbrAwake();
+	unsigned int nbrIslands = m_islands.size();
+	m_keys.resize(manifolds.size());
+	for (unsigned int m = 0; m < manifolds.size(); m++) {
+		unsigned int body1 = manifolds[m].body1;
+		unsigned int body2 = manifolds[m].body2;
+		m_keys[m] = body1 < nbrAwake || body2 < nbrAwake ? this->getIsland(body1, body2) : nbrIslands;
+	}
+	sortByIsland(m_keys, nbrIslands, m_offsets, m_manifolds, [](unsigned int m) { return m; });
+	for (unsigned int k = 0; k < nbrIslands; k++) {
+		m_islands[k].manifoldBegin = m_offsets[k];
+		m_islands[k].manifoldEnd = m_offsets[k + 1];
+	}
+}
+
+void IslandManager::sleep(BodyStore& store, double deltaTime) {
+	m_nbrIslands = m_islands.size();
+	if (!m_enabled) {
+		return;
+	}
+
+	// Temps passé sous les seuils ; les solides des îles à endormir sont mis de côté avant de déplacer la moindre ligne
+	float dt = (float)deltaTime;
+	m_bodies.clear();
+	m_keys.clear();
+	for (unsigned int k = 0; k < m_islands.size(); k++) {
+		Island const& island = m_islands[k];
+		float         islandTime = m_timeToSleep;
+		for (unsigned int i = island.bodyBegin; i < island.bodyEnd; i++) {
+			float& sleepTime = store.getSleepTimes()[i];
+			float  speed = glm::length(store.getVelocities()[i]);
+			float  angularSpeed = glm::length(store.getWorldInverseInertias()[i] * store.getAngularMomenta()[i]);
+			sleepTime = speed > m_linearThreshold || angularSpeed > m_angularThreshold ? 0 : sleepTime + dt;
+			islandTime = min(islandTime, sleepTime);
+		}
+		if (islandTime >= m_timeToSleep) {
+			m_bodies.insert(m_bodies.end(), store.getOwners().begin() + island.bodyBegin, store.getOwners().begin() + island.bodyEnd);
+			m_keys.push_back(k);
+		}
+	}
+
+	unsigned int begin = 0;
+	for (unsigned int k : m_keys) {
+		Island const& island = m_islands[k];
+		m_island.assign(m_bodies.begin() + begin, m_bodies.begin() + begin + island.bodyEnd - island.bodyBegin);
+		begin += island.bodyEnd - island.bodyBegin;
+		for (WorldObject* worldObject : m_island) {
+			worldObject->getTransform().savePrevious();  // plus d'interpolation entre deux poses pour un solide immobile
+		}
+		store.sleep(m_island);
+		for (unsigned int a = island.articulationBegin; a < island.articulationEnd; a++) {
+			m_articulations[a]->sleep();
+		}
+		m_nbrIslands--;
+	}
+}
+
+IslandManager::~IslandManager() {}
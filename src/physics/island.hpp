@@ -0,0 +1,84 @@
+#ifndef PHYSICS_ISLAND
+#define PHYSICS_ISLAND
+
+#include "narrowphase.hpp"
+#include "solver.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+class Articulation;
+class BodyStore;
+class Joint;
+class SweepAndPrune;
+class WorldObject;
+
+// Solides, liaisons, contacts et articulations d'une île : tout ce qu'il faut pour la résoudre seule.
+// Ses solides occupent des lignes consécutives du BodyStore, les autres bornes indexent les tableaux de l'IslandManager
+struct Island {
+	unsigned int bodyBegin;
+	unsigned int bodyEnd;
+	unsigned int jointBegin;
+	unsigned int jointEnd;
+	unsigned int manifoldBegin;
+	unsigned int manifoldEnd;
+	unsigned int articulationBegin;
+	unsigned int articulationEnd;
+};
+
+// Îles de simulation : solides mobiles reliés par des contacts ou des liaisons (union-find sur les lignes éveillées du BodyStore).
+// Deux îles ne partagent aucune donnée modifiée pendant un pas et peuvent être résolues en parallèle ; les solides bloqués,
+// seulement lus, ne relient pas les îles entre elles. Les îles sont numérotées dans l'ordre de leur première ligne et chacune
+// garde l'ordre global de ses liaisons et contacts : le résultat ne dépend pas de la façon dont elles sont réparties.
+// Une île dont tous les solides restent sous les seuils de vitesse pendant timeToSleep s'endort d'un bloc : ses lignes quittent
+// la partie éveillée du BodyStore et ne coûtent plus rien au Planet.
+// Elle se réveille au contact d'un solide éveillé, par une liaison, ou quand les forces qu'elle reçoit changent.
+class IslandManager {
+  private:
+	std::vector<unsigned int>  m_parents;     // union-find, indexé par ligne éveillée
+	std::vector<unsigned int>  m_rowIslands;  // île de chaque ligne éveillée
+	std::vector<unsigned int>  m_keys;        // île de chaque élément à ranger
+	std::vector<unsigned int>  m_offsets;     // tri par comptage
+	std::vector<Island>        m_islands;
+	std::vector<WorldObject*>  m_bodies;  // ordre des lignes éveillées, puis solides des îles à endormir
+	std::vector<Joint*>        m_joints;  // rangés île par île
+	std::vector<unsigned int>  m_manifolds;
+	std::vector<Articulation*> m_articulations;
+	std::vector<WorldObject*>  m_island;
+	float                      m_linearThreshold;   // m/s
+	float                      m_angularThreshold;  // rad/s
+	float                      m_timeToSleep;       // secondes sous les seuils avant l'endormissement
+	bool                       m_enabled;
+	unsigned int               m_nbrIslands;  // îles restées éveillées au dernier pas
+
+	unsigned int find(unsigned int row);
+	void         unite(unsigned int row1, unsigned int row2);
+	bool         isMobile(BodyStore& store, WorldObject* worldObject) const;
+	void         wakePair(BodyStore& store, WorldObject* worldObject1, WorldObject* worldObject2);
+	unsigned int getIsland(unsigned int row1, unsigned int row2) const;  // île de la première ligne éveillée
+
+  public:
+	IslandManager(float linearThreshold = 0.05, float angularThreshold = 0.05, float timeToSleep = 0.5);
+
+	float                       getLinearThreshold() const;
+	float                       getAngularThreshold() const;
+	float                       getTimeToSleep() const;
+	bool                        getEnabled() const;
+	unsigned int                getNbrIslands() const;
+	IslandManager&              setThresholds(float linearThreshold, float angularThreshold);
+	IslandManager&              setTimeToSleep(float timeToSleep);
+	IslandManager&              setEnabled(bool enabled);  // désactivé, les îles endormies sont réveillées au prochain pas
+	std::vector<Island>&        getIslands();
+	std::vector<Joint*>&        getJoints();
+	std::vector<unsigned int>&  getManifolds();  // indices dans ContactSolver::getManifolds
+	std::vector<Articulation*>& getArticulations();
+
+	void checkForces(BodyStore& store);  // en début de pas, avant que les forces accumulées ne soient consommées
+	void build(BodyStore& store, std::vector<Contact> const& contacts, SweepAndPrune& broadPhase, std::vector<Joint*> const& joints,
+	           std::vector<Articulation*> const& articulations);  // réveils, îles, puis lignes du BodyStore rangées île par île
+	void groupManifolds(std::vector<ContactManifold> const& manifolds, BodyStore& store);
+	void sleep(BodyStore& store, double deltaTime);  // après l'intégration
+
+	~IslandManager();
+};
+
+#endif
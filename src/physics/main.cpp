@@ -1,13 +1,15 @@
 #include "main.hpp"
+#include "scheduler.hpp"
 #include "../maths/utils.hpp"
-#include "../three/main.hpp"
-#include "../lib/glad/glad.h"
 
 #include <glm/glm.hpp>
 #include <vector>
 #include <cmath>
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <iostream>
+#include <algorithm>
 
 using namespace std;
 
@@ -17,15 +19,15 @@ using namespace std;
 
 
 
-Clock::Clock() : m_deltaTime(1 / 100), m_now(chrono::high_resolution_clock::now()) {}
+Clock::Clock() : m_deltaTime(0), m_now(chrono::high_resolution_clock::now()) {}
 
 void Clock::tick() {
 	auto newNow = chrono::high_resolution_clock::now();
-	m_deltaTime = chrono::duration_cast<chrono::milliseconds>(newNow - m_now).count();
+	m_deltaTime = chrono::duration_cast<chrono::nanoseconds>(newNow - m_now).count();
 	m_now = newNow;
 }
 
-double Clock::getDeltaTime() const { return (double)m_deltaTime / 1000; }
+double Clock::getDeltaTime() const { return (double)m_deltaTime / 1e9; }
 
 Clock::~Clock() {}
 
@@ -71,6 +73,32 @@ glm::vec3       BoundingBox::getPosition() const { return m_position; }
 BoundingBoxType BoundingBox::getType() const { return m_type; }
 float           BoundingBox::getRadius() const { return 0.0f; }
 
+// Même réaction que l'ancien cas sphère-sphère, appliquée au point le plus profond : rebond proportionnel à la vitesse
+Force BoundingBox::intersect(BoundingBox const& boundingBox, glm::vec3 hisTranslation, UnitQuaternion hisRotation,
+                             glm::vec3 thisTranslation, UnitQuaternion thisRotation, glm::vec3 thisSpeed) const {
+	vector<Contact> contacts;
+	glm::vec4       thisOrientation = thisRotation.getValue();
+	ConvexCore      thisCore = this->getCore(thisTranslation, thisOrientation);
+	if (ConvexCollider::collide(thisCore, boundingBox.getCore(hisTranslation, hisRotation.getValue()), contacts) == 0) {
+		return Force();
+	}
+
+	Contact const* deepest = &contacts[0];
+	for (Contact const& contact : contacts) {
+		if (contact.depth > deepest->depth) {
+			deepest = &contact;
+		}
+	}
+	glm::vec4 conjugate(-thisOrientation.x, -thisOrientation.y, -thisOrientation.z, thisOrientation.w);
+	return Force(quaternionRotate(conjugate, deepest->point1 - thisTranslation),
+	             -deepest->normal * (float)glm::length(thisSpeed) * m_restitutionCoef);
+}
+
+bool BoundingBox::raycast(glm::vec3 translation, glm::vec4 orientation, glm::vec3 origin, glm::vec3 direction, float maxDistance,
+                          float& distance, glm::vec3& normal) const {
+	return ConvexCollider::raycast(this->getCore(translation, orientation), origin, direction, maxDistance, distance, normal);
+}
+
 BoundingBox::~BoundingBox() {}
 
 
@@ -83,52 +111,63 @@ Solid::Solid(vector<Mass> masses, bool locked)
     : m_masses(masses),
       m_inertiaCenter(glm::vec3(0)),
       m_inertiaTensor(glm::mat3(1)),
-      m_speedVector(glm::vec3(0)),
-      m_angularMomentum(glm::vec3(0)),
-      m_locked(locked) {
-	this->calculateInertiaCenter();
-	this->calculateInertiaTensor();
+      m_locked(locked),
+      m_totalMass(0),
+      m_inverseMass(0),
+      m_inverseInertiaTensor(glm::mat3(0)) {
+	this->calculateAll();
 }
 
-bool Solid::getLocked() const { return m_locked; }
-
-float Solid::getTotalMass() const {
-	float totalMass(0);
-
-	for (Mass mass : m_masses) {
-		totalMass += mass.getMass();
-	}
+bool                Solid::getLocked() const { return m_locked; }
+float               Solid::getTotalMass() const { return m_totalMass; }
+float               Solid::getInverseMass() const { return m_inverseMass; }
+glm::vec3           Solid::getInertiaCenter() const { return m_inertiaCenter; }
+glm::mat3           Solid::getInertiaTensor() const { return m_inertiaTensor; }
+glm::mat3           Solid::getInverseInertiaTensor() const { return m_inverseInertiaTensor; }
+vector<Mass> const& Solid::getMasses() const { return m_masses; }
+
+Solid& Solid::setLocked(bool locked) {
+	m_locked = locked;
+	this->calculateInverses();
+	return *this;
+}
 
-	return totalMass;
+Solid& Solid::setMasses(vector<Mass> const& masses) {
+	m_masses = masses;
+	this->calculateAll();
+	return *this;
 }
 
-glm::vec3 Solid::getInertiaCenter() const { return m_inertiaCenter; }
-glm::mat3 Solid::getInertiaTensor() const { return m_inertiaTensor; }
+Solid& Solid::addMass(Mass const& mass) {
+	m_masses.push_back(mass);
+	this->calculateAll();
+	return *this;
+}
 
-glm::vec3 Solid::getSpeedVector() const { return m_speedVector; }
-glm::vec3 Solid::getAngularMomentum() const { return m_angularMomentum; }
+void Solid::calculateTotalMass() {
+	m_totalMass = 0;
 
-glm::vec3 Solid::getAngularSpeed() const {
-	glm::vec3 angularSpeed = glm::inverse(m_inertiaTensor) * m_angularMomentum;  // L = I . w <=> w = I-1 . L
-	return angularSpeed;
+	for (Mass const& mass : m_masses) {
+		m_totalMass += mass.getMass();
+	}
 }
 
-glm::vec3 Solid::getSpeedAt(glm::vec3 point) const { return m_speedVector + glm::cross(this->getAngularSpeed(), point); }
-
 void Solid::calculateInertiaCenter() {
 	m_inertiaCenter = glm::vec3(0);
 
-	for (Mass mass : m_masses) {
+	for (Mass const& mass : m_masses) {
 		m_inertiaCenter += mass.getPosition() * mass.getMass();
 	}
 
-	m_inertiaCenter /= this->getTotalMass();
+	if (m_totalMass > 0) {
+		m_inertiaCenter /= m_totalMass;
+	}
 }
 
 void Solid::calculateInertiaTensor() {
 	m_inertiaTensor = glm::mat3(0);
 
-	for (Mass mass : m_masses) {
+	for (Mass const& mass : m_masses) {
 		glm::vec3 v = mass.getPosition() - m_inertiaCenter;
 
 		float A = v.y * v.y + v.z * v.z;
@@ -148,38 +187,273 @@ void Solid::calculateInertiaTensor() {
 	}
 }
 
+// Les inverses servent à chaque pas et à chaque itération des contraintes : on ne les calcule qu'ici
+void Solid::calculateInverses() {
+	bool movable = !m_locked && m_totalMass > 0;
+	bool invertible = abs(glm::determinant(m_inertiaTensor)) > 1e-12f;
 
-Solid& Solid::setSpeedVector(glm::vec3 speedVector) {
-	m_speedVector = speedVector;
-	return *this;
+	m_inverseMass = movable ? 1 / m_totalMass : 0;
+	m_inverseInertiaTensor = movable && invertible ? glm::inverse(m_inertiaTensor) : glm::mat3(0);
 }
 
-Solid& Solid::setAngularMomentum(glm::vec3 angularMomentum) {
-	m_angularMomentum = angularMomentum;
-	return *this;
+void Solid::calculateAll() {
+	this->calculateTotalMass();
+	this->calculateInertiaCenter();
+	this->calculateInertiaTensor();
+	this->calculateInverses();
 }
 
-Solid& Solid::incrementSpeed(glm::vec3 deltaSpeed) {
-	m_speedVector += deltaSpeed;
-	return *this;
+Solid::~Solid() {}
+
+
+
+/* --- BODYSTORE --- */
+
+
+
+BodyStore::BodyStore() : m_nbrAwake(0), m_integrator(&Integrator::getDefault()) {}
+
+unsigned int BodyStore::size() const { return m_owners.size(); }
+unsigned int BodyStore::getNbrAwake() const { return m_nbrAwake; }
+bool         BodyStore::isAwake(unsigned int index) const { return index < m_nbrAwake; }
+
+void BodyStore::swapRows(unsigned int index1, unsigned int index2) {
+	if (index1 == index2) {
+		return;
+	}
+	swap(m_owners[index1], m_owners[index2]);
+	swap(m_positions[index1], m_positions[index2]);
+	swap(m_orientations[index1], m_orientations[index2]);
+	swap(m_velocities[index1], m_velocities[index2]);
+	swap(m_angularMomenta[index1], m_angularMomenta[index2]);
+	swap(m_forces[index1], m_forces[index2]);
+	swap(m_torques[index1], m_torques[index2]);
+	swap(m_inverseMasses[index1], m_inverseMasses[index2]);
+	swap(m_inverseInertias[index1], m_inverseInertias[index2]);
+	swap(m_worldInverseInertias[index1], m_worldInverseInertias[index2]);
+	swap(m_inertiaCenters[index1], m_inertiaCenters[index2]);
+	swap(m_sleepTimes[index1], m_sleepTimes[index2]);
+	swap(m_restForces[index1], m_restForces[index2]);
+	swap(m_restTorques[index1], m_restTorques[index2]);
+	swap(m_islandNext[index1], m_islandNext[index2]);
+	m_owners[index1]->m_index = index1;
+	m_owners[index2]->m_index = index2;
 }
 
-Solid& Solid::incrementAngularMomentum(glm::vec3 deltaAngularMomentum) {
-	m_angularMomentum += deltaAngularMomentum;
-	return *this;
+// Nouvelle ligne éveillée, initialisée depuis le Transform et le Solid de l'objet, au repos
+unsigned int BodyStore::add(WorldObject* owner) {
+	Solid&     solid = owner->getSolid();
+	Transform& transform = owner->getTransform();
+
+	m_owners.push_back(owner);
+	m_positions.push_back(transform.getTranslation());
+	m_orientations.push_back(transform.getRotation().getValue());
+	m_velocities.push_back(glm::vec3(0));
+	m_angularMomenta.push_back(glm::vec3(0));
+	m_forces.push_back(glm::vec3(0));
+	m_torques.push_back(glm::vec3(0));
+	m_inverseMasses.push_back(solid.getInverseMass());
+	m_inverseInertias.push_back(solid.getInverseInertiaTensor());
+	m_worldInverseInertias.push_back(glm::mat3(0));
+	m_inertiaCenters.push_back(solid.getInertiaCenter());
+	m_sleepTimes.push_back(0);
+	m_restForces.push_back(glm::vec3(0));
+	m_restTorques.push_back(glm::vec3(0));
+	m_islandNext.push_back(nullptr);
+
+	owner->m_index = m_owners.size() - 1;
+	this->updateWorldInverseInertia(owner->m_index);
+	this->swapRows(owner->m_index, m_nbrAwake++);
+	return owner->m_index;
 }
 
-Solid& Solid::applyLinearImpulse(glm::vec3 impulse) {
-	m_speedVector += impulse;
-	return *this;
+// La dernière ligne prend la place de la ligne supprimée : les tableaux restent contigus
+void BodyStore::remove(unsigned int index) {
+	// Une île endormie est réveillée plutôt que de garder un anneau incomplet
+	WorldObject* owner = m_owners[index];
+	this->wake(index);
+	index = owner->m_index;
+	if (index < m_nbrAwake) {
+		this->swapRows(index, --m_nbrAwake);
+		index = m_nbrAwake;
+	}
+	this->swapRows(index, m_owners.size() - 1);
+
+	m_owners.pop_back();
+	m_positions.pop_back();
+	m_orientations.pop_back();
+	m_velocities.pop_back();
+	m_angularMomenta.pop_back();
+	m_forces.pop_back();
+	m_torques.pop_back();
+	m_inverseMasses.pop_back();
+	m_inverseInertias.pop_back();
+	m_worldInverseInertias.pop_back();
+	m_inertiaCenters.pop_back();
+	m_sleepTimes.pop_back();
+	m_restForces.pop_back();
+	m_restTorques.pop_back();
+	m_islandNext.pop_back();
 }
 
-Solid& Solid::applyAngularImpulse(glm::vec3 impulse) {
-	m_angularMomentum += impulse;
+// Déplace une ligne vers un autre BodyStore en conservant son état dynamique, elle y arrive éveillée
+unsigned int BodyStore::moveTo(unsigned int index, BodyStore& store) {
+	WorldObject* owner = m_owners[index];
+	this->wake(index);
+	index = owner->m_index;
+
+	store.m_owners.push_back(owner);
+	store.m_positions.push_back(m_positions[index]);
+	store.m_orientations.push_back(m_orientations[index]);
+	store.m_velocities.push_back(m_velocities[index]);
+	store.m_angularMomenta.push_back(m_angularMomenta[index]);
+	store.m_forces.push_back(m_forces[index]);
+	store.m_torques.push_back(m_torques[index]);
+	store.m_inverseMasses.push_back(m_inverseMasses[index]);
+	store.m_inverseInertias.push_back(m_inverseInertias[index]);
+	store.m_worldInverseInertias.push_back(m_worldInverseInertias[index]);
+	store.m_inertiaCenters.push_back(m_inertiaCenters[index]);
+	store.m_sleepTimes.push_back(0);
+	store.m_restForces.push_back(glm::vec3(0));
+	store.m_restTorques.push_back(glm::vec3(0));
+	store.m_islandNext.push_back(nullptr);
+
+	this->remove(index);
+	owner->m_store = &store;
+	owner->m_index = store.m_owners.size() - 1;
+	store.swapRows(owner->m_index, store.m_nbrAwake++);
+	return owner->m_index;
+}
+
+Integrator& BodyStore::getIntegrator() { return *m_integrator; }
+
+BodyStore& BodyStore::setIntegrator(Integrator& integrator) {
+	m_integrator = &integrator;
 	return *this;
 }
 
-Solid::~Solid() {}
+vector<WorldObject*>& BodyStore::getOwners() { return m_owners; }
+vector<glm::vec3>&    BodyStore::getPositions() { return m_positions; }
+vector<glm::vec4>&    BodyStore::getOrientations() { return m_orientations; }
+vector<glm::vec3>&    BodyStore::getVelocities() { return m_velocities; }
+vector<glm::vec3>&    BodyStore::getAngularMomenta() { return m_angularMomenta; }
+vector<glm::vec3>&    BodyStore::getForces() { return m_forces; }
+vector<glm::vec3>&    BodyStore::getTorques() { return m_torques; }
+vector<float>&        BodyStore::getInverseMasses() { return m_inverseMasses; }
+vector<glm::mat3>&    BodyStore::getInverseInertias() { return m_inverseInertias; }
+vector<glm::mat3>&    BodyStore::getWorldInverseInertias() { return m_worldInverseInertias; }
+vector<glm::vec3>&    BodyStore::getInertiaCenters() { return m_inertiaCenters; }
+vector<float>&        BodyStore::getSleepTimes() { return m_sleepTimes; }
+vector<glm::vec3>&    BodyStore::getRestForces() { return m_restForces; }
+vector<glm::vec3>&    BodyStore::getRestTorques() { return m_restTorques; }
+
+// Les solides de l'île sont ramenés un à un dans la partie éveillée en suivant l'anneau
+void BodyStore::wake(unsigned int index) {
+	if (index < m_nbrAwake || m_inverseMasses[index] == 0) {
+		return;
+	}
+
+	WorldObject* first = m_owners[index];
+	WorldObject* current = first;
+	do {
+		unsigned int row = current->m_index;
+		WorldObject* next = m_islandNext[row];
+		m_islandNext[row] = nullptr;
+		m_sleepTimes[row] = 0;
+		this->swapRows(row, m_nbrAwake++);
+		current = next;
+	} while (current != nullptr && current != first);
+}
+
+void BodyStore::sleep(vector<WorldObject*> const& island) {
+	for (unsigned int i = 0; i < island.size(); i++) {
+		unsigned int row = island[i]->m_index;
+		m_velocities[row] = glm::vec3(0);
+		m_angularMomenta[row] = glm::vec3(0);
+		m_forces[row] = glm::vec3(0);
+		m_torques[row] = glm::vec3(0);
+		m_sleepTimes[row] = 0;
+		m_islandNext[row] = island[(i + 1) % island.size()];
+		if (row < m_nbrAwake) {
+			this->swapRows(row, --m_nbrAwake);
+		}
+	}
+}
+
+void BodyStore::reorder(vector<WorldObject*> const& order) {
+	for (unsigned int i = 0; i < order.size(); i++) {
+		this->swapRows(i, order[i]->m_index);
+	}
+}
+
+void BodyStore::save(BodyState* states) const {
+	for (unsigned int i = 0; i < m_owners.size(); i++) {
+		states[i] = {m_owners[i], m_islandNext[i], m_positions[i], m_orientations[i], m_velocities[i], m_angularMomenta[i],
+		             m_forces[i], m_torques[i], m_restForces[i], m_restTorques[i], m_sleepTimes[i]};
+	}
+}
+
+// Rien n'est écrit si un des solides n'appartient plus à ce BodyStore
+bool BodyStore::restore(BodyState const* states, unsigned int nbrAwake) {
+	for (unsigned int i = 0; i < m_owners.size(); i++) {
+		if (states[i].owner->m_store != this) {
+			return false;
+		}
+	}
+
+	for (unsigned int i = 0; i < m_owners.size(); i++) {
+		this->swapRows(i, states[i].owner->m_index);
+		m_islandNext[i] = states[i].islandNext;
+		m_positions[i] = states[i].position;
+		m_orientations[i] = states[i].orientation;
+		m_velocities[i] = states[i].velocity;
+		m_angularMomenta[i] = states[i].angularMomentum;
+		m_forces[i] = states[i].force;
+		m_torques[i] = states[i].torque;
+		m_restForces[i] = states[i].restForce;
+		m_restTorques[i] = states[i].restTorque;
+		m_sleepTimes[i] = states[i].sleepTime;
+		this->updateWorldInverseInertia(i);
+	}
+	m_nbrAwake = nbrAwake;
+	this->syncTransforms(0, m_owners.size());
+	return true;
+}
+
+// I-1 = R . I0-1 . Rt dans le repère monde
+void BodyStore::updateWorldInverseInertia(unsigned int index) {
+	glm::mat3 rotation = quaternionMatrix(m_orientations[index]);
+	m_worldInverseInertias[index] = rotation * m_inverseInertias[index] * glm::transpose(rotation);
+}
+
+// Sans effet si les forces ont déjà été versées pendant ce pas.
+// Un solide bloqué, que plusieurs îles peuvent partager, n'est pas écrit : ses forces sont vidées par l'intégration ou l'IslandManager
+void BodyStore::applyForces(unsigned int index, double deltaTime) {
+	if (m_inverseMasses[index] == 0) {
+		return;
+	}
+	m_velocities[index] += m_forces[index] * m_inverseMasses[index] * (float)deltaTime;
+	m_angularMomenta[index] += m_torques[index] * (float)deltaTime;
+	m_forces[index] = glm::vec3(0);
+	m_torques[index] = glm::vec3(0);
+}
+
+// Script de mise à jour de la physique, sur les lignes [begin, end)
+void BodyStore::integrate(unsigned int begin, unsigned int end, double deltaTime) { m_integrator->integrate(*this, begin, end, deltaTime); }
+
+void BodyStore::integrate(double deltaTime) { this->integrate(0, m_nbrAwake, deltaTime); }
+
+// Recopie les poses calculées dans les Transform, pour le rendu et le code utilisateur
+void BodyStore::syncTransforms(unsigned int begin, unsigned int end) {
+	for (unsigned int i = begin; i < end; i++) {
+		glm::vec4 q = m_orientations[i];
+		m_owners[i]->getTransform().setTranslation(m_positions[i]).setRotation(UnitQuaternion(Quaternion(q.x, q.y, q.z, q.w)));
+	}
+}
+
+void BodyStore::syncTransforms() { this->syncTransforms(0, m_nbrAwake); }
+
+BodyStore::~BodyStore() {}
 
 
 
@@ -187,11 +461,13 @@ Solid::~Solid() {}
 
 
 
-WorldObject::WorldObject(std::vector<BoundingBox*> boundingBoxes, Solid& solid, Mesh& mesh)
-    : m_boundingBoxes(boundingBoxes), m_solid(solid), m_resultantForce(glm::vec3(0)), m_torque(glm::vec3(0)), m_mesh(mesh) {}
+WorldObject::WorldObject(std::vector<BoundingBox*> boundingBoxes, Solid& solid, Transform& transform)
+    : m_boundingBoxes(boundingBoxes), m_solid(solid), m_transform(transform), m_ownStore(), m_store(&m_ownStore), m_index(0) {
+	m_ownStore.add(this);
+}
 
-glm::vec3 WorldObject::getResultantForce() const { return m_resultantForce; }
-glm::vec3 WorldObject::getTorque() const { return m_torque; }
+glm::vec3 WorldObject::getResultantForce() const { return m_store->getForces()[m_index]; }
+glm::vec3 WorldObject::getTorque() const { return m_store->getTorques()[m_index]; }
 
 WorldObject& WorldObject::applyForce(Force const& force) {
 	this->applyWrench(glm::mat2x3(force.getDirection(), glm::vec3(0)), force.getPosition());
@@ -201,58 +477,105 @@ WorldObject& WorldObject::applyForce(Force const& force) {
 glm::mat2x3 WorldObject::getWrench(Force const& force) const {
 	// Moment M = OA ^ F
 	// Torseur de type [Tx Ty Tz Mx My Mz] dans le repère monde
-	return glm::mat2x3(
-	    glm::vec3(force.getDirection()),
-	    glm::vec3(glm::cross(m_mesh.getRotation().rotate(force.getPosition() - m_solid.getInertiaCenter()), force.getDirection())));
+	glm::vec3 arm = quaternionRotate(m_store->getOrientations()[m_index], force.getPosition() - m_solid.getInertiaCenter());
+	return glm::mat2x3(glm::vec3(force.getDirection()), glm::vec3(glm::cross(arm, force.getDirection())));
 }
 
 WorldObject& WorldObject::applyWrench(glm::mat2x3 wrench, glm::vec3 point) {
-	m_resultantForce += wrench[0];                                                                                   // Fo = Fa
-	m_torque += wrench[1] + glm::cross(m_mesh.getRotation().rotate(point - m_solid.getInertiaCenter()), wrench[0]);  // Mo = Ma + OA ^ F
+	glm::vec3 arm = quaternionRotate(m_store->getOrientations()[m_index], point - m_solid.getInertiaCenter());  // OA dans le repère monde
+	m_store->getForces()[m_index] += wrench[0];                                                                // Fo = Fa
+	m_store->getTorques()[m_index] += wrench[1] + glm::cross(arm, wrench[0]);                                  // Mo = Ma + OA ^ F
 	return *this;
 }
 
-std::vector<BoundingBox*>& WorldObject::getBoundingBoxes() { return m_boundingBoxes; }
-Mesh&                      WorldObject::getMesh() { return m_mesh; }
-Solid&                     WorldObject::getSolid() { return m_solid; }
+glm::vec3 WorldObject::getPosition() const { return m_store->getPositions()[m_index]; }
 
-// Script de mise à jour de la physique
-WorldObject& WorldObject::update(double deltaTime) {
-	if (m_solid.getLocked()) {
-		return *this;
-	}
+UnitQuaternion WorldObject::getOrientation() const {
+	glm::vec4 q = m_store->getOrientations()[m_index];
+	return UnitQuaternion(Quaternion(q.x, q.y, q.z, q.w));
+}
+
+glm::vec3 WorldObject::getSpeedVector() const { return m_store->getVelocities()[m_index]; }
+glm::vec3 WorldObject::getAngularMomentum() const { return m_store->getAngularMomenta()[m_index]; }
 
-	// On applique la somme des forces
-	glm::vec3 worldDeltaSpeed = m_resultantForce / m_solid.getTotalMass() * (float)deltaTime;  // a = F / m et dv / dt = a
-	m_solid.incrementSpeed(worldDeltaSpeed);
+// Une vitesse imposée réveille l'île du solide, qui peut alors changer de ligne
+WorldObject& WorldObject::setSpeedVector(glm::vec3 speedVector) {
+	m_store->wake(m_index);
+	m_store->getVelocities()[m_index] = speedVector;
+	return *this;
+}
+
+WorldObject& WorldObject::setAngularMomentum(glm::vec3 angularMomentum) {
+	m_store->wake(m_index);
+	m_store->getAngularMomenta()[m_index] = angularMomentum;
+	return *this;
+}
+
+glm::vec3 WorldObject::getAngularSpeed() const {
+	return m_store->getWorldInverseInertias()[m_index] * this->getAngularMomentum();
+}
 
-	// On applique la somme des moments
-	glm::vec3 worldDeltaAngularMomentum = m_torque * (float)deltaTime;  // dL / dt = ∑M
-	m_solid.incrementAngularMomentum(worldDeltaAngularMomentum);
+glm::vec3 WorldObject::getSpeedAt(glm::vec3 point) const {
+	glm::vec3 arm = quaternionRotate(m_store->getOrientations()[m_index], point - m_solid.getInertiaCenter());
+	return this->getSpeedVector() + glm::cross(this->getAngularSpeed(), arm);
+}
 
-	// On remet à 0 les forces et les moments
-	m_resultantForce = glm::vec3(0);
-	m_torque = glm::vec3(0);
+WorldObject& WorldObject::applyLinearImpulse(glm::vec3 impulse) {
+	m_store->wake(m_index);
+	m_store->getVelocities()[m_index] += impulse * m_store->getInverseMasses()[m_index];
+	return *this;
+}
 
-	// Translation linéaire
-	m_mesh.translate(m_solid.getSpeedVector() * (float)deltaTime);  // dx/dt = v
+WorldObject& WorldObject::applyAngularImpulse(glm::vec3 impulse) {
+	m_store->wake(m_index);
+	if (m_store->getInverseMasses()[m_index] > 0) {
+		m_store->getAngularMomenta()[m_index] += impulse;
+	}
+	return *this;
+}
 
-	// Rotation autour de l'axe instantané
-	glm::mat3 inertiaTensor = m_mesh.getRotation().rotate(m_solid.getInertiaTensor());    // I = R . I0 . R-1
-	glm::vec3 angularSpeed = m_solid.getAngularMomentum();  // L = I . w <=> w = I-1 . L
-	// glm::vec3 angularSpeed = glm::inverse(inertiaTensor) * m_solid.getAngularMomentum();  // L = I . w <=> w = I-1 . L
-	float     norm = glm::length(angularSpeed);                                           // en rad/s
+std::vector<BoundingBox*>& WorldObject::getBoundingBoxes() { return m_boundingBoxes; }
+Transform&                 WorldObject::getTransform() { return m_transform; }
+Solid&                     WorldObject::getSolid() { return m_solid; }
+BodyStore&                 WorldObject::getStore() { return *m_store; }
+unsigned int               WorldObject::getIndex() const { return m_index; }
+bool                       WorldObject::isAttached() const { return m_store != &m_ownStore; }
 
-	if (norm > 0) {  // éviter les divisions par 0 et les petites rotations inutiles
-		glm::vec3 axis = glm::normalize(angularSpeed);
-		float     angle = norm * (float)deltaTime / M_PI * 180.0f;            // conversion rad → degré
-		m_mesh.rotateScene(angle, angularSpeed, m_solid.getInertiaCenter());  // rotation dans le repère local
+WorldObject& WorldObject::attach(BodyStore& store) {
+	if (m_store != &store) {
+		m_store->moveTo(m_index, store);
 	}
+	return *this;
+}
+
+WorldObject& WorldObject::detach() { return this->attach(m_ownStore); }
+
+WorldObject& WorldObject::pullTransform() {
+	m_store->wake(m_index);
+	m_store->getPositions()[m_index] = m_transform.getTranslation();
+	m_store->getOrientations()[m_index] = m_transform.getRotation().getValue();
+	m_store->updateWorldInverseInertia(m_index);
+	return *this;
+}
 
+WorldObject& WorldObject::pullSolid() {
+	m_store->getInverseMasses()[m_index] = m_solid.getInverseMass();
+	m_store->getInverseInertias()[m_index] = m_solid.getInverseInertiaTensor();
+	m_store->getInertiaCenters()[m_index] = m_solid.getInertiaCenter();
+	m_store->updateWorldInverseInertia(m_index);
+	m_store->wake(m_index);  // un solide qui cesse d'être verrouillé rejoint les solides éveillés
 	return *this;
 }
 
-WorldObject::~WorldObject() {}
+// Avance cet objet seul, hors d'un Planet
+WorldObject& WorldObject::update(double deltaTime) {
+	m_store->wake(m_index);
+	m_store->integrate(m_index, m_index + 1, deltaTime);
+	m_store->syncTransforms(m_index, m_index + 1);
+	return *this;
+}
+
+WorldObject::~WorldObject() { this->detach(); }
 
 
 
@@ -261,11 +584,120 @@ WorldObject::~WorldObject() {}
 
 
 Joint::Joint(WorldObject* worldObject1, glm::vec3 wO1Contact, WorldObject* worldObject2, glm::vec3 wO2Contact)
-    : m_worldObject1(worldObject1), m_wO1Contact(wO1Contact), m_worldObject2(worldObject2), m_wO2Contact(wO2Contact), m_twist() {}
+    : m_worldObject1(worldObject1),
+      m_wO1Contact(wO1Contact),
+      m_worldObject2(worldObject2),
+      m_wO2Contact(wO2Contact),
+      m_twist(),
+      m_baumgarte(0.2),
+      m_arm1(glm::vec3(0)),
+      m_arm2(glm::vec3(0)),
+      m_pointMass(glm::mat3(0)),
+      m_pointBias(glm::vec3(0)),
+      m_pointImpulse(glm::vec3(0)) {}
 
 WorldObject* Joint::getWorldObject1() { return m_worldObject1; }
 WorldObject* Joint::getWorldObject2() { return m_worldObject2; }
+glm::vec3    Joint::getContact1() const { return m_wO1Contact; }
+glm::vec3    Joint::getContact2() const { return m_wO2Contact; }
 glm::mat2x3& Joint::getTwist() { return m_twist; }
+glm::vec3    Joint::getPointImpulse() const { return m_pointImpulse; }
+
+JointCache Joint::getCache() const { return {m_pointImpulse, glm::vec3(0), 0, 0}; }
+void       Joint::setCache(JointCache const& cache) { m_pointImpulse = cache.pointImpulse; }
+
+Joint& Joint::setBaumgarte(float baumgarte) {
+	m_baumgarte = baumgarte;
+	return *this;
+}
+
+glm::vec4 Joint::getOrientation(WorldObject* worldObject) const {
+	return worldObject->getStore().getOrientations()[worldObject->getIndex()];
+}
+
+glm::mat3 Joint::getInverseInertia(WorldObject* worldObject) const {
+	return worldObject->getStore().getWorldInverseInertias()[worldObject->getIndex()];
+}
+
+glm::vec3 Joint::getAngularSpeed(WorldObject* worldObject) const {
+	return this->getInverseInertia(worldObject) * worldObject->getStore().getAngularMomenta()[worldObject->getIndex()];
+}
+
+glm::vec3 Joint::getVelocityAt(WorldObject* worldObject, glm::vec3 arm) const {
+	return worldObject->getStore().getVelocities()[worldObject->getIndex()] + glm::cross(this->getAngularSpeed(worldObject), arm);
+}
+
+void Joint::applyImpulse(WorldObject* worldObject, glm::vec3 impulse, glm::vec3 arm) {
+	BodyStore&   store = worldObject->getStore();
+	unsigned int index = worldObject->getIndex();
+	if (store.getInverseMasses()[index] > 0) {
+		store.getVelocities()[index] += impulse * store.getInverseMasses()[index];
+		store.getAngularMomenta()[index] += glm::cross(arm, impulse);  // dL = r ^ P
+	}
+}
+
+void Joint::applyAngularImpulse(WorldObject* worldObject, glm::vec3 impulse) {
+	BodyStore&   store = worldObject->getStore();
+	unsigned int index = worldObject->getIndex();
+	if (store.getInverseMasses()[index] > 0) {
+		store.getAngularMomenta()[index] += impulse;
+	}
+}
+
+void Joint::preparePoint(double deltaTime) {
+	// Les forces extérieures sont versées dans les vitesses pour que la liaison les compense dès ce pas
+	m_worldObject1->getStore().applyForces(m_worldObject1->getIndex(), deltaTime);
+	m_worldObject2->getStore().applyForces(m_worldObject2->getIndex(), deltaTime);
+
+	glm::vec4 orientation1 = this->getOrientation(m_worldObject1);
+	glm::vec4 orientation2 = this->getOrientation(m_worldObject2);
+	m_arm1 = quaternionRotate(orientation1, m_wO1Contact - m_worldObject1->getSolid().getInertiaCenter());
+	m_arm2 = quaternionRotate(orientation2, m_wO2Contact - m_worldObject2->getSolid().getInertiaCenter());
+
+	// K = (1/m1 + 1/m2) . Id - skew(r1) . I1-1 . skew(r1) - skew(r2) . I2-1 . skew(r2)
+	BodyStore& store1 = m_worldObject1->getStore();
+	BodyStore& store2 = m_worldObject2->getStore();
+	float      inverseMass = store1.getInverseMasses()[m_worldObject1->getIndex()] + store2.getInverseMasses()[m_worldObject2->getIndex()];
+	glm::mat3  skew1 = skew(m_arm1);
+	glm::mat3  skew2 = skew(m_arm2);
+	glm::mat3  K = inverseMass * glm::mat3(1) - skew1 * this->getInverseInertia(m_worldObject1) * skew1 -
+	              skew2 * this->getInverseInertia(m_worldObject2) * skew2;
+	m_pointMass = inverseOrZero(K);
+
+	// Écart entre les deux points, rattrapé en partie à chaque pas (Baumgarte)
+	glm::vec3 anchor1 = store1.getPositions()[m_worldObject1->getIndex()] + quaternionRotate(orientation1, m_wO1Contact);
+	glm::vec3 anchor2 = store2.getPositions()[m_worldObject2->getIndex()] + quaternionRotate(orientation2, m_wO2Contact);
+	m_pointBias = (anchor2 - anchor1) * (m_baumgarte / (float)deltaTime);
+}
+
+void Joint::warmStartPoint() {
+	this->applyImpulse(m_worldObject1, -m_pointImpulse, m_arm1);
+	this->applyImpulse(m_worldObject2, m_pointImpulse, m_arm2);
+}
+
+void Joint::solvePoint() {
+	glm::vec3 relativeSpeed = this->getVelocityAt(m_worldObject2, m_arm2) - this->getVelocityAt(m_worldObject1, m_arm1);
+	glm::vec3 impulse = m_pointMass * -(relativeSpeed + m_pointBias);
+	m_pointImpulse += impulse;
+
+	this->applyImpulse(m_worldObject1, -impulse, m_arm1);
+	this->applyImpulse(m_worldObject2, impulse, m_arm2);
+}
+
+void Joint::prepare(double deltaTime) { this->preparePoint(deltaTime); }
+void Joint::warmStart() { this->warmStartPoint(); }
+void Joint::solveVelocities() { this->solvePoint(); }
+
+void Joint::applyConstraints(double deltaTime, unsigned int iterations) {
+	if (deltaTime <= 0) {
+		return;
+	}
+	this->prepare(deltaTime);
+	this->warmStart();
+	for (unsigned int i = 0; i < iterations; i++) {
+		this->solveVelocities();
+	}
+}
 
 Joint::~Joint() {}
 
@@ -275,20 +707,86 @@ Joint::~Joint() {}
 
 
 
-Skeleton::Skeleton(vector<WorldObject*> worldObjects, vector<Joint*> joints) : m_worldObjects(worldObjects), m_joints(joints) {}
+Skeleton::Skeleton(vector<WorldObject*> worldObjects, vector<Joint*> joints)
+    : m_worldObjects(worldObjects), m_joints(joints), m_motors(vector<JointMotor*>()), m_articulation(nullptr) {}
+
+vector<WorldObject*>& Skeleton::getWorldObjects() { return m_worldObjects; }
+vector<Joint*>&       Skeleton::getJoints() { return m_joints; }
+vector<JointMotor*>&  Skeleton::getMotors() { return m_motors; }
+Articulation*         Skeleton::getArticulation() { return m_articulation; }
+
+// L'articulation part des poses et vitesses actuelles des objets.
+// Un Planet garde l'articulation et ses liaisons de boucle dans ses listes et ses îles : le mode ne change plus après l'ajout
+Skeleton& Skeleton::setArticulated(bool articulated) {
+	if (!m_worldObjects.empty() && m_worldObjects.front()->isAttached()) {
+		cerr << "Error: Cannot change the articulated mode of a skeleton added to a planet" << endl;
+		return *this;
+	}
+	if (articulated && m_articulation == nullptr && !m_worldObjects.empty()) {
+		m_articulation = new Articulation(m_worldObjects, m_joints);
+	} else if (!articulated && m_articulation != nullptr) {
+		delete m_articulation;
+		m_articulation = nullptr;
+	}
+	return *this;
+}
+
+Skeleton& Skeleton::addMotor(JointMotor* motor) {
+	m_motors.push_back(motor);
+	return *this;
+}
+
+// Toutes les cibles d'une action en un appel : le reste de la commande tourne dans les pas de physique
+Skeleton& Skeleton::setTargets(const float* angles, const float* speeds) {
+	for (unsigned int i = 0; i < m_motors.size(); i++) {
+		m_motors[i]->setTarget(angles[i], speeds != nullptr ? speeds[i] : 0.0f);
+	}
+	return *this;
+}
+
+void Skeleton::actuate() {
+	for (JointMotor* motor : m_motors) {
+		motor->actuate(m_articulation);
+	}
+}
 
-vector<Joint*>& Skeleton::getJoints() { return m_joints; }
+// Les liaisons sont résolues ensemble : chaque itération les parcourt toutes
+void Skeleton::applyConstraints(double deltaTime, unsigned int iterations) {
+	if (deltaTime <= 0) {
+		return;
+	}
+	for (Joint* joint : m_joints) {
+		joint->prepare(deltaTime);
+		joint->warmStart();
+	}
+	for (unsigned int i = 0; i < iterations; i++) {
+		for (Joint* joint : m_joints) {
+			joint->solveVelocities();
+		}
+	}
+}
 
+// Avance le squelette seul, hors d'un Planet
 void Skeleton::update(double deltaTime) {
+	this->actuate();
+	if (m_articulation != nullptr) {
+		// Seule la racine est intégrée comme un solide libre, les autres poses découlent des coordonnées articulaires
+		m_articulation->prepare(deltaTime);
+		m_worldObjects[0]->update(deltaTime);
+		m_articulation->integrate(deltaTime);
+		for (WorldObject* worldObject : m_worldObjects) {
+			worldObject->getStore().syncTransforms(worldObject->getIndex(), worldObject->getIndex() + 1);
+		}
+		return;
+	}
+
 	for (WorldObject* WorldObject : m_worldObjects) {
 		WorldObject->update(deltaTime);
 	}
-	for (Joint* joint : m_joints) {
-		joint->applyConstraints(deltaTime);
-	}
+	this->applyConstraints(deltaTime);
 }
 
-Skeleton::~Skeleton() {}
+Skeleton::~Skeleton() { delete m_articulation; }
 
 
 
@@ -296,43 +794,600 @@ Skeleton::~Skeleton() {}
 
 
 
-Planet::Planet(float gravityIntensity)
-    : m_clock(Clock()), m_gravityIntensity(gravityIntensity), m_scene(Scene()), m_skeletons(vector<Skeleton*>()) {}
+Planet::Planet(float gravityIntensity, double fixedDeltaTime, unsigned int maxSubSteps, IntegratorType integratorType,
+               unsigned int solverIterations)
+    : m_clock(Clock()),
+      m_gravityIntensity(gravityIntensity),
+      m_skeletons(vector<Skeleton*>()),
+      m_joints(vector<Joint*>()),
+      m_articulations(vector<Articulation*>()),
+      m_bodies(),
+      m_integrator(Integrator::create(integratorType)),
+      m_broadPhase(),
+      m_tree(),
+      m_treeProxies(vector<unsigned int>()),
+      m_sphereBatch(),
+      m_sphereOfProxy(vector<unsigned int>()),
+      m_contacts(vector<Contact>()),
+      m_contactSolver(),
+      m_solverIterations(solverIterations),
+      m_islands(),
+      m_threadPool(nullptr),
+      m_fixedDeltaTime(fixedDeltaTime),
+      m_maxSubSteps(maxSubSteps),
+      m_accumulator(0),
+      m_alpha(1),
+      m_frameWrenches(vector<pair<WorldObject*, glm::mat2x3>>()),
+      m_deterministic(false),
+      m_random() {
+	m_bodies.setIntegrator(*m_integrator);
+}
+
+vector<Skeleton*>& Planet::getSkeletons() { return m_skeletons; }
+BodyStore&         Planet::getBodies() { return m_bodies; }
+Integrator&        Planet::getIntegrator() { return *m_integrator; }
+SweepAndPrune&     Planet::getBroadPhase() { return m_broadPhase; }
+DynamicTree&       Planet::getTree() { return m_tree; }
+vector<Contact>&   Planet::getContacts() { return m_contacts; }
+ContactSolver&     Planet::getContactSolver() { return m_contactSolver; }
+IslandManager&     Planet::getIslands() { return m_islands; }
+unsigned int       Planet::getSolverIterations() const { return m_solverIterations; }
+double             Planet::getFixedDeltaTime() const { return m_fixedDeltaTime; }
+unsigned int       Planet::getMaxSubSteps() const { return m_maxSubSteps; }
+float              Planet::getAlpha() const { return m_alpha; }
+ThreadPool*        Planet::getThreadPool() { return m_threadPool; }
+bool               Planet::getDeterministic() const { return m_deterministic; }
+Random&            Planet::getRandom() { return m_random; }
+
+Planet& Planet::setDeterministic(bool deterministic, uint64_t seed) {
+	m_deterministic = deterministic;
+	m_random.setSeed(seed);
+	m_accumulator = 0;
+	m_clock.tick();  // le retard accumulé en mode déterministe n'est pas rattrapé en le quittant
+	return *this;
+}
 
-Scene& Planet::getScene() { return m_scene; }
+// FNV-1a sur les octets des floats : deux états égaux à un bit près donnent deux empreintes différentes
+uint64_t Planet::hashState() {
+	uint64_t hash = 14695981039346656037ull;
+	for (Skeleton* skeleton : m_skeletons) {
+		for (WorldObject* worldObject : skeleton->getWorldObjects()) {
+			float     values[13];
+			glm::vec3 position = worldObject->getPosition();
+			glm::vec4 orientation = worldObject->getOrientation().getValue();
+			glm::vec3 speed = worldObject->getSpeedVector();
+			glm::vec3 angularMomentum = worldObject->getAngularMomentum();
+			memcpy(values, &position, sizeof(float) * 3);
+			memcpy(values + 3, &orientation, sizeof(float) * 4);
+			memcpy(values + 7, &speed, sizeof(float) * 3);
+			memcpy(values + 10, &angularMomentum, sizeof(float) * 3);
+			unsigned char* bytes = (unsigned char*)values;
+			for (unsigned int i = 0; i < sizeof(values); i++) {
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			}
+		}
+	}
+	return hash;
+}
 
-Planet& Planet::add(Skeleton* skeleton) {
-	m_skeletons.push_back(skeleton);
+Planet& Planet::setThreadPool(ThreadPool* threadPool) {
+	m_threadPool = threadPool;
+	return *this;
+}
 
-	for (Joint* joint : skeleton->getJoints()) {
-		m_scene.add(&joint->getWorldObject1()->getMesh());
-		m_scene.add(&joint->getWorldObject2()->getMesh());
+Planet& Planet::setFixedDeltaTime(double fixedDeltaTime) {
+	if (fixedDeltaTime > 0) {
+		m_fixedDeltaTime = fixedDeltaTime;
 	}
+	return *this;
+}
+
+Planet& Planet::setMaxSubSteps(unsigned int maxSubSteps) {
+	m_maxSubSteps = max(maxSubSteps, 1u);
+	return *this;
+}
+
+Planet& Planet::setSolverIterations(unsigned int solverIterations) {
+	m_solverIterations = solverIterations;
+	return *this;
+}
 
+Planet& Planet::add(Skeleton* skeleton) {
+	if (find(m_skeletons.begin(), m_skeletons.end(), skeleton) == m_skeletons.end()) {
+		m_skeletons.push_back(skeleton);
+
+		// En mode articulé, seules les liaisons qui fermeraient une boucle restent au solveur par impulsions
+		vector<Joint*>* joints = &skeleton->getJoints();
+		if (skeleton->getArticulation() != nullptr) {
+			m_articulations.push_back(skeleton->getArticulation());
+			joints = &skeleton->getArticulation()->getLoopJoints();
+		}
+		m_joints.insert(m_joints.end(), joints->begin(), joints->end());
+		for (WorldObject* worldObject : skeleton->getWorldObjects()) {
+			worldObject->attach(m_bodies);
+			for (BoundingBox* boundingBox : worldObject->getBoundingBoxes()) {
+				glm::vec3 position = m_bodies.getPositions()[worldObject->getIndex()];
+				glm::vec4 orientation = m_bodies.getOrientations()[worldObject->getIndex()];
+				AABB      box = boundingBox->getAABB(position, orientation);
+				unsigned int proxy = m_broadPhase.add(box, worldObject, boundingBox);
+				if (proxy >= m_treeProxies.size()) {
+					m_treeProxies.resize(proxy + 1);
+				}
+				m_treeProxies[proxy] = m_tree.createProxy(box, worldObject, boundingBox);
+			}
+		}
+	}
 	return *this;
 }
 
 Planet& Planet::remove(Skeleton* skeleton) {
 	auto it = find(m_skeletons.begin(), m_skeletons.end(), skeleton);
 	if (it != m_skeletons.end()) {
-		for (Joint* joint : skeleton->getJoints()) {
-			m_scene.remove(&joint->getWorldObject1()->getMesh());
-			m_scene.remove(&joint->getWorldObject2()->getMesh());
+		for (WorldObject* worldObject : skeleton->getWorldObjects()) {
+			m_broadPhase.remove(worldObject);
+			m_tree.remove(worldObject);
+			worldObject->detach();
 		}
 		m_skeletons.erase(it);
+		Articulation* articulation = skeleton->getArticulation();
+		m_articulations.erase(std::remove(m_articulations.begin(), m_articulations.end(), articulation), m_articulations.end());
+		for (Joint* joint : skeleton->getJoints()) {
+			m_joints.erase(std::remove(m_joints.begin(), m_joints.end(), joint), m_joints.end());
+		}
+
+		// Les proxies libérés seront réutilisés : les contacts en cours n'ont plus de sens
+		m_contacts.clear();
+		m_contactSolver.clear();
 	}
 	return *this;
 }
 
-void Planet::update() {
+// Recalcule les AABB depuis les poses du BodyStore puis met à jour les paires candidates et l'arbre.
+// Les solides endormis n'ont pas bougé : leurs AABB sont gardées, et seules les feuilles des proxies recalculés sont déplacées
+void Planet::updateBroadPhase(double deltaTime, bool sleeping) {
+	vector<glm::vec3>& positions = m_bodies.getPositions();
+	vector<glm::vec4>& orientations = m_bodies.getOrientations();
+	vector<glm::vec3>& velocities = m_bodies.getVelocities();
+	vector<float>&     inverseMasses = m_bodies.getInverseMasses();
+
+	vector<BroadPhaseProxy>& proxies = m_broadPhase.getProxies();
+	for (unsigned int proxy = 0; proxy < proxies.size(); proxy++) {
+		if (!proxies[proxy].alive) {
+			continue;
+		}
+		unsigned int index = proxies[proxy].worldObject->getIndex();
+		if (sleeping || m_bodies.isAwake(index) || inverseMasses[index] == 0) {
+			proxies[proxy].box = proxies[proxy].boundingBox->getAABB(positions[index], orientations[index]);
+			// Une réinsertion ne change pas l'indice de la feuille
+			m_tree.moveProxy(m_treeProxies[proxy], proxies[proxy].box, velocities[index] * (float)deltaTime);
+		}
+	}
+	m_broadPhase.update();
+}
+
+// Les sphères sont recopiées en structure of arrays puis testées par lots sur les paires candidates.
+// Une paire sans solide éveillé ne peut pas avoir changé : seules les sphères des autres paires sont recopiées.
+// La table des sphères par proxy est gardée d'un pas à l'autre, seules ses entrées utilisées sont remises à NO_SPHERE
+void Planet::updateNarrowPhase() {
+	vector<BroadPhaseProxy>& proxies = m_broadPhase.getProxies();
+	m_sphereOfProxy.resize(proxies.size(), NO_SPHERE);
+
+	auto addSphere = [&](unsigned int proxy) {
+		if (m_sphereOfProxy[proxy] == NO_SPHERE) {
+			unsigned int index = proxies[proxy].worldObject->getIndex();
+			glm::vec3    center = m_bodies.getPositions()[index];
+			center += quaternionRotate(m_bodies.getOrientations()[index], proxies[proxy].boundingBox->getPosition());
+			m_sphereOfProxy[proxy] = m_sphereBatch.addSphere(center, proxies[proxy].boundingBox->getRadius(), proxy);
+		}
+		return m_sphereOfProxy[proxy];
+	};
+
+	m_sphereBatch.clear();
+	for (BroadPhasePair const& pair : m_broadPhase.getPairs()) {
+		BroadPhaseProxy const& proxy1 = proxies[pair.proxy1];
+		BroadPhaseProxy const& proxy2 = proxies[pair.proxy2];
+		if (proxy1.boundingBox->getType() != BoundingBoxType::Sphere || proxy2.boundingBox->getType() != BoundingBoxType::Sphere) {
+			continue;
+		}
+		if (!m_bodies.isAwake(proxy1.worldObject->getIndex()) && !m_bodies.isAwake(proxy2.worldObject->getIndex())) {
+			continue;
+		}
+		m_sphereBatch.addPair(addSphere(pair.proxy1), addSphere(pair.proxy2));
+	}
+	for (unsigned int sphere = 0; sphere < m_sphereBatch.getNbrSpheres(); sphere++) {
+		m_sphereOfProxy[m_sphereBatch.getProxy(sphere)] = NO_SPHERE;
+	}
+
+	m_contacts.clear();
+	m_sphereBatch.collide(m_contacts);
+
+	// Les autres couples de volumes, un par un, par la table de ConvexCollider
+	for (BroadPhasePair const& pair : m_broadPhase.getPairs()) {
+		BroadPhaseProxy const& proxy1 = proxies[pair.proxy1];
+		BroadPhaseProxy const& proxy2 = proxies[pair.proxy2];
+		if (proxy1.boundingBox->getType() == BoundingBoxType::Sphere && proxy2.boundingBox->getType() == BoundingBoxType::Sphere) {
+			continue;
+		}
+		unsigned int index1 = proxy1.worldObject->getIndex();
+		unsigned int index2 = proxy2.worldObject->getIndex();
+		if (!m_bodies.isAwake(index1) && !m_bodies.isAwake(index2)) {
+			continue;
+		}
+
+		ConvexCore   core1 = proxy1.boundingBox->getCore(m_bodies.getPositions()[index1], m_bodies.getOrientations()[index1]);
+		ConvexCore   core2 = proxy2.boundingBox->getCore(m_bodies.getPositions()[index2], m_bodies.getOrientations()[index2]);
+		unsigned int first = m_contacts.size();
+		ConvexCollider::collide(core1, core2, m_contacts);
+		for (unsigned int i = first; i < m_contacts.size(); i++) {
+			m_contacts[i].proxy1 = pair.proxy1;
+			m_contacts[i].proxy2 = pair.proxy2;
+		}
+	}
+}
+
+// Volumes dont l'AABB exacte chevauche box
+vector<QueryHit> Planet::queryAABB(AABB const& box) {
+	vector<QueryHit> hits;
+	m_tree.query(box, [&](unsigned int proxy) {
+		TreeNode const& leaf = m_tree.getNode(proxy);
+		unsigned int    index = leaf.worldObject->getIndex();
+		if (leaf.boundingBox->getAABB(m_bodies.getPositions()[index], m_bodies.getOrientations()[index]).overlaps(box)) {
+			hits.push_back({leaf.worldObject, leaf.boundingBox});
+		}
+		return true;
+	});
+	return hits;
+}
+
+// Volumes dont l'AABB exacte est à moins de radius de center
+vector<QueryHit> Planet::querySphere(glm::vec3 center, float radius) {
+	vector<QueryHit> hits;
+	m_tree.query({center - glm::vec3(radius), center + glm::vec3(radius)}, [&](unsigned int proxy) {
+		TreeNode const& leaf = m_tree.getNode(proxy);
+		unsigned int    index = leaf.worldObject->getIndex();
+		AABB            box = leaf.boundingBox->getAABB(m_bodies.getPositions()[index], m_bodies.getOrientations()[index]);
+		glm::vec3       closest = glm::clamp(center, box.min, box.max);
+		if (glm::length(closest - center) <= radius) {
+			hits.push_back({leaf.worldObject, leaf.boundingBox});
+		}
+		return true;
+	});
+	return hits;
+}
+
+// Impact le plus proche le long du rayon, direction normée
+bool Planet::raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, RaycastHit& hit) {
+	bool found = false;
+	m_tree.raycast(origin, direction, maxDistance, [&](unsigned int proxy, float distanceMax) {
+		TreeNode const& leaf = m_tree.getNode(proxy);
+		unsigned int    index = leaf.worldObject->getIndex();
+		float           distance;
+		glm::vec3       normal;
+		if (!leaf.boundingBox->raycast(m_bodies.getPositions()[index], m_bodies.getOrientations()[index], origin, direction, distanceMax,
+		                               distance, normal)) {
+			return distanceMax;
+		}
+		hit = {leaf.worldObject, leaf.boundingBox, origin + direction * distance, normal, distance};
+		found = true;
+		return distance;
+	});
+	return found;
+}
+
+const unsigned int RAYS_PER_TASK = 64;  // paquet de rayons d'une tâche du pool de threads
+
+// Les volumes sont figés une fois pour tout le lot : un appel virtuel par volume, aucun par rayon. Chaque rayon descend ensuite
+// l'arbre puis passe par la table de ConvexCollider. Les tâches du pool prennent les rayons par paquets, sans rien écrire en commun
+unsigned int Planet::raycast(const glm::vec3* origins, const glm::vec3* directions, unsigned int nbrRays, float maxDistance,
+                             float* distances, glm::vec3* normals, WorldObject** worldObjects) {
+	m_rayCores.resize(m_tree.getCapacity());
+	for (unsigned int proxy = 0; proxy < m_tree.getCapacity(); proxy++) {
+		TreeNode const& node = m_tree.getNode(proxy);
+		if (node.height == 0) {
+			unsigned int index = node.worldObject->getIndex();
+			m_rayCores[proxy] = node.boundingBox->getCore(m_bodies.getPositions()[index], m_bodies.getOrientations()[index]);
+		}
+	}
+
+	atomic<unsigned int> nbrHits(0);
+
+	auto castRays = [&](unsigned int packet) {
+		unsigned int hits = 0;
+		unsigned int last = min(nbrRays, (packet + 1) * RAYS_PER_TASK);
+		for (unsigned int ray = packet * RAYS_PER_TASK; ray < last; ray++) {
+			glm::vec3    origin = origins[ray];
+			glm::vec3    direction = directions[ray];
+			float        closest = maxDistance;
+			glm::vec3    closestNormal(0);
+			unsigned int closestProxy = NULL_NODE;
+			m_tree.raycast(origin, direction, maxDistance, [&](unsigned int proxy, float distanceMax) {
+				float     distance;
+				glm::vec3 normal;
+				if (!ConvexCollider::raycast(m_rayCores[proxy], origin, direction, distanceMax, distance, normal)) {
+					return distanceMax;
+				}
+				closest = distance;
+				closestNormal = normal;
+				closestProxy = proxy;
+				return distance;
+			});
+
+			distances[ray] = closest;
+			if (normals != nullptr) {
+				normals[ray] = closestNormal;
+			}
+			if (worldObjects != nullptr) {
+				worldObjects[ray] = closestProxy != NULL_NODE ? m_tree.getNode(closestProxy).worldObject : nullptr;
+			}
+			hits += closestProxy != NULL_NODE;
+		}
+		nbrHits += hits;
+	};
+
+	unsigned int nbrPackets = (nbrRays + RAYS_PER_TASK - 1) / RAYS_PER_TASK;
+	if (m_threadPool != nullptr && nbrPackets > 1) {
+		m_threadPool->parallelFor(nbrPackets, castRays);
+	} else {
+		for (unsigned int packet = 0; packet < nbrPackets; packet++) {
+			castRays(packet);
+		}
+	}
+	return nbrHits;
+}
+
+// Une île est résolue comme un monde à part entière : elle ne partage avec les autres que des solides bloqués, seulement lus.
+// Liaisons et contacts (détectés à la fin du pas précédent) sont résolus ensemble sur les vitesses, avant l'intégration
+// des positions. Après chaque passe, les impulsions reçues par les solides articulés sont propagées dans leur arbre
+void Planet::stepIsland(unsigned int index, double deltaTime) {
+	Island const&          island = m_islands.getIslands()[index];
+	vector<Joint*>&        joints = m_islands.getJoints();
+	vector<Articulation*>& articulations = m_islands.getArticulations();
+	unsigned int const*    manifolds = m_islands.getManifolds().data();
+
+	// Les articulations avancent d'abord leurs vitesses articulaires sous l'effet des forces accumulées
+	for (unsigned int a = island.articulationBegin; a < island.articulationEnd; a++) {
+		articulations[a]->prepare(deltaTime);
+	}
+
+	for (unsigned int j = island.jointBegin; j < island.jointEnd; j++) {
+		joints[j]->prepare(deltaTime);
+		joints[j]->warmStart();
+	}
+	m_contactSolver.prepare(m_bodies, deltaTime, manifolds, island.manifoldBegin, island.manifoldEnd);
+	m_contactSolver.warmStart(m_bodies, manifolds, island.manifoldBegin, island.manifoldEnd);
+	for (unsigned int a = island.articulationBegin; a < island.articulationEnd; a++) {
+		articulations[a]->project();
+	}
+
+	for (unsigned int i = 0; i < m_solverIterations; i++) {
+		for (unsigned int j = island.jointBegin; j < island.jointEnd; j++) {
+			joints[j]->solveVelocities();
+		}
+		m_contactSolver.solveVelocities(m_bodies, manifolds, island.manifoldBegin, island.manifoldEnd);
+		for (unsigned int a = island.articulationBegin; a < island.articulationEnd; a++) {
+			articulations[a]->project();
+		}
+	}
+
+	// Les racines sont intégrées comme des solides libres, puis les articulations replacent les autres solides
+	m_bodies.integrate(island.bodyBegin, island.bodyEnd, deltaTime);
+	for (unsigned int a = island.articulationBegin; a < island.articulationEnd; a++) {
+		articulations[a]->integrate(deltaTime);
+	}
+	m_bodies.syncTransforms(island.bodyBegin, island.bodyEnd);
+}
+
+// Avance la simulation d'un pas donné, sans horloge : utilisable sans fenêtre et plus vite que le temps réel.
+// Les îles éveillées sont résolues indépendamment, en parallèle si un ThreadPool est fourni ; chacune suit toujours
+// le même ordre de calcul, le résultat est donc identique quel que soit le nombre de threads
+void Planet::step(double deltaTime) {
+	// Les moteurs tournent à la fréquence de la physique, quel que soit le rythme des cibles
+	for (Skeleton* skeleton : m_skeletons) {
+		skeleton->actuate();
+	}
+
+	// Une force nouvelle sur une île endormie la réveille avant que la résolution ne commence
+	m_islands.checkForces(m_bodies);
+	m_islands.build(m_bodies, m_contacts, m_broadPhase, m_joints, m_articulations);
+	m_contactSolver.update(m_contacts, m_broadPhase, m_bodies);
+	m_islands.groupManifolds(m_contactSolver.getManifolds(), m_bodies);
+
+	unsigned int nbrIslands = m_islands.getIslands().size();
+	if (m_threadPool != nullptr) {
+		m_threadPool->parallelFor(nbrIslands, [&](unsigned int index) { this->stepIsland(index, deltaTime); });
+	} else {
+		for (unsigned int index = 0; index < nbrIslands; index++) {
+			this->stepIsland(index, deltaTime);
+		}
+	}
+
+	m_islands.sleep(m_bodies, deltaTime);
+	this->updateBroadPhase(deltaTime);
+	this->updateNarrowPhase();
+}
+
+// Consomme le temps réel écoulé par pas fixes et renvoie le nombre de pas effectués
+unsigned int Planet::update() {
+	// Le temps réel écoulé ne doit pas influer sur la simulation : exactement un pas, et rien à interpoler
+	if (m_deterministic) {
+		for (unsigned int i = 0; i < m_bodies.getNbrAwake(); i++) {
+			m_bodies.getOwners()[i]->getTransform().savePrevious();
+		}
+		this->step(m_fixedDeltaTime);
+		m_alpha = 1;
+		return 1;
+	}
+
 	m_clock.tick();
+	m_accumulator += m_clock.getDeltaTime();
+
+	// Au-delà de m_maxSubSteps pas de retard, la simulation ralentit plutôt que d'exploser en coût
+	double maxAccumulator = m_maxSubSteps * m_fixedDeltaTime;
+	if (m_accumulator > maxAccumulator) {
+		m_accumulator = maxAccumulator;
+	}
+
+	// Les forces appliquées depuis l'image précédente valent pour chacun de ses pas, et non pour le premier seulement :
+	// relevées par objet, les lignes du BodyStore changeant quand des îles s'endorment ou se réveillent
+	vector<glm::vec3>& forces = m_bodies.getForces();
+	vector<glm::vec3>& torques = m_bodies.getTorques();
+	m_frameWrenches.clear();
+	for (unsigned int i = 0; i < m_bodies.size(); i++) {
+		if (forces[i] != glm::vec3(0) || torques[i] != glm::vec3(0)) {
+			m_frameWrenches.push_back({m_bodies.getOwners()[i], glm::mat2x3(forces[i], torques[i])});
+		}
+	}
+
+	unsigned int subSteps = 0;
+	while (m_accumulator >= m_fixedDeltaTime) {
+		for (unsigned int i = 0; i < m_bodies.getNbrAwake(); i++) {
+			m_bodies.getOwners()[i]->getTransform().savePrevious();
+		}
+		if (subSteps > 0) {
+			for (pair<WorldObject*, glm::mat2x3> const& wrench : m_frameWrenches) {
+				forces[wrench.first->getIndex()] = wrench.second[0];
+				torques[wrench.first->getIndex()] = wrench.second[1];
+			}
+		}
+
+		this->step(m_fixedDeltaTime);
+		m_accumulator -= m_fixedDeltaTime;
+		subSteps++;
+	}
+
+	m_alpha = m_accumulator / m_fixedDeltaTime;
+	return subSteps;
+}
+
+static size_t snapshotSize(PlanetSnapshotHeader const& header) {
+	return sizeof(header) + header.nbrBodies * sizeof(BodyState) + header.nbrManifolds * sizeof(ContactManifold) +
+	       header.nbrJoints * sizeof(JointCache) + header.nbrLinks * sizeof(ArticulationLinkState) +
+	       header.nbrMotors * sizeof(JointMotorState) + header.nbrContacts * sizeof(Contact);
+}
+
+void Planet::save(vector<unsigned char>& snapshot) {
+	vector<ContactManifold>& manifolds = m_contactSolver.getManifolds();
+	unsigned int             nbrLinks = 0;
+	unsigned int             nbrMotors = 0;
+	for (Articulation* articulation : m_articulations) {
+		nbrLinks += articulation->getLinks().size();
+	}
+	for (Skeleton* skeleton : m_skeletons) {
+		nbrMotors += skeleton->getMotors().size();
+	}
 
+	PlanetSnapshotHeader header = {{'E', 'M', 'P', 'S'},
+	                               m_bodies.size(),
+	                               m_bodies.getNbrAwake(),
+	                               (uint32_t)m_joints.size(),
+	                               nbrLinks,
+	                               nbrMotors,
+	                               (uint32_t)m_contacts.size(),
+	                               (uint32_t)manifolds.size(),
+	                               m_alpha,
+	                               m_random.getSeed(),
+	                               m_random.getState(),
+	                               m_accumulator};
+	snapshot.resize(snapshotSize(header));
+
+	unsigned char* data = snapshot.data();
+	memcpy(data, &header, sizeof(header));
+	data += sizeof(header);
+	m_bodies.save((BodyState*)data);
+	data += header.nbrBodies * sizeof(BodyState);
+	memcpy(data, manifolds.data(), header.nbrManifolds * sizeof(ContactManifold));
+	data += header.nbrManifolds * sizeof(ContactManifold);
+	for (Joint* joint : m_joints) {
+		JointCache cache = joint->getCache();
+		memcpy(data, &cache, sizeof(cache));
+		data += sizeof(cache);
+	}
+	for (Articulation* articulation : m_articulations) {
+		articulation->save((ArticulationLinkState*)data);
+		data += articulation->getLinks().size() * sizeof(ArticulationLinkState);
+	}
 	for (Skeleton* skeleton : m_skeletons) {
-		skeleton->update(m_clock.getDeltaTime());
+		for (JointMotor* motor : skeleton->getMotors()) {
+			JointMotorState state = motor->getState();
+			memcpy(data, &state, sizeof(state));
+			data += sizeof(state);
+		}
 	}
+	memcpy(data, m_contacts.data(), header.nbrContacts * sizeof(Contact));
 }
 
-Planet::~Planet() {}
+// Les contacts et les manifolds sont restaurés tels quels plutôt que recalculés : le pas suivant reprend exactement là où
+// l'instantané a été pris, warm starting compris
+bool Planet::restore(vector<unsigned char> const& snapshot) {
+	PlanetSnapshotHeader header;
+	unsigned int         nbrLinks = 0;
+	unsigned int         nbrMotors = 0;
+	for (Articulation* articulation : m_articulations) {
+		nbrLinks += articulation->getLinks().size();
+	}
+	for (Skeleton* skeleton : m_skeletons) {
+		nbrMotors += skeleton->getMotors().size();
+	}
+	if (snapshot.size() >= sizeof(header)) {
+		memcpy(&header, snapshot.data(), sizeof(header));
+	}
+	if (snapshot.size() < sizeof(header) || memcmp(header.magic, "EMPS", 4) != 0 || header.nbrBodies != m_bodies.size() ||
+	    header.nbrJoints != m_joints.size() || header.nbrLinks != nbrLinks || header.nbrMotors != nbrMotors ||
+	    snapshot.size() != snapshotSize(header)) {
+		cerr << "Error: Snapshot does not match this planet" << endl;
+		return false;
+	}
+
+	const unsigned char* data = snapshot.data() + sizeof(header);
+	if (!m_bodies.restore((BodyState const*)data, header.nbrAwake)) {
+		cerr << "Error: Snapshot refers to bodies that left this planet" << endl;
+		return false;
+	}
+	data += header.nbrBodies * sizeof(BodyState);
+
+	vector<ContactManifold>& manifolds = m_contactSolver.getManifolds();
+	manifolds.resize(header.nbrManifolds);
+	memcpy(manifolds.data(), data, header.nbrManifolds * sizeof(ContactManifold));
+	data += header.nbrManifolds * sizeof(ContactManifold);
+	for (Joint* joint : m_joints) {
+		JointCache cache;
+		memcpy(&cache, data, sizeof(cache));
+		joint->setCache(cache);
+		data += sizeof(cache);
+	}
+	for (Articulation* articulation : m_articulations) {
+		articulation->restore((ArticulationLinkState const*)data);
+		data += articulation->getLinks().size() * sizeof(ArticulationLinkState);
+	}
+	for (Skeleton* skeleton : m_skeletons) {
+		for (JointMotor* motor : skeleton->getMotors()) {
+			JointMotorState state;
+			memcpy(&state, data, sizeof(state));
+			motor->setState(state);
+			data += sizeof(state);
+		}
+	}
+	m_contacts.resize(header.nbrContacts);
+	memcpy(m_contacts.data(), data, header.nbrContacts * sizeof(Contact));
+
+	m_random.setSeed(header.randomSeed).setState(header.randomState);
+	m_accumulator = header.accumulator;
+	m_alpha = header.alpha;
+
+	// Volumes de la phase large replacés, y compris ceux des solides endormis ; rien à interpoler depuis l'état abandonné
+	this->updateBroadPhase(0, true);
+	for (WorldObject* worldObject : m_bodies.getOwners()) {
+		worldObject->getTransform().savePrevious();
+	}
+	return true;
+}
+
+Planet::~Planet() {
+	while (m_bodies.size() > 0) {
+		m_bodies.getOwners().back()->detach();
+	}
+	delete m_integrator;
+}
 
 
 
@@ -345,30 +1400,155 @@ SphereBoundingBox::SphereBoundingBox(glm::vec3 position, float radius, float res
 
 float SphereBoundingBox::getRadius() const { return m_radius; }
 
-Force SphereBoundingBox::intersect(BoundingBox const& boundingBox, glm::vec3 hisTranslation, UnitQuaternion hisRotation,
-                                   glm::vec3 thisTranslation, UnitQuaternion thisRotation, glm::vec3 thisSpeed) const {
-	glm::vec3 thisPosition = m_position;
-	thisPosition = (thisRotation * thisPosition * thisRotation.getConjugate()).getVector() + thisTranslation;
-	glm::vec3 hisPosition = boundingBox.getPosition();
-	hisPosition = (hisRotation * hisPosition * hisRotation.getConjugate()).getVector() + hisTranslation;
+AABB SphereBoundingBox::getAABB(glm::vec3 translation, glm::vec4 orientation) const {
+	glm::vec3 center = translation + quaternionRotate(orientation, m_position);
+	return {center - glm::vec3(m_radius), center + glm::vec3(m_radius)};
+}
 
-	if (boundingBox.getType() == BoundingBoxType::Sphere) {
-		glm::vec3 thisToHis = hisPosition - thisPosition;
-		float     distance = glm::length(thisToHis);
-		float     intersectedPart = m_radius + boundingBox.getRadius() - distance;
-		if (intersectedPart > 0) {
-			Force reaction(glm::normalize(thisToHis) * m_radius,
-			               glm::normalize(-thisToHis) * (float)glm::length(thisSpeed) * m_restitutionCoef);
-			return reaction;
-		}
-	}
-	return Force();
+ConvexCore SphereBoundingBox::getCore(glm::vec3 translation, glm::vec4 orientation) const {
+	return {Sphere, translation + quaternionRotate(orientation, m_position), glm::mat3(1), glm::vec3(0), nullptr, 0, m_radius};
 }
 
 SphereBoundingBox::~SphereBoundingBox() {}
 
 
 
+/* --- CAPSULEBOUNDINGBOX --- */
+
+
+
+CapsuleBoundingBox::CapsuleBoundingBox(glm::vec3 position, float radius, float halfHeight, float restitutionCoef, float sliding)
+    : BoundingBox::BoundingBox(restitutionCoef, sliding, position, BoundingBoxType::Capsule), m_radius(radius), m_halfHeight(halfHeight) {}
+
+float CapsuleBoundingBox::getRadius() const { return m_radius; }
+float CapsuleBoundingBox::getHalfHeight() const { return m_halfHeight; }
+
+AABB CapsuleBoundingBox::getAABB(glm::vec3 translation, glm::vec4 orientation) const {
+	glm::vec3 center = translation + quaternionRotate(orientation, m_position);
+	glm::vec3 axis = glm::abs(quaternionRotate(orientation, glm::vec3(0, m_halfHeight, 0)));
+	return {center - axis - glm::vec3(m_radius), center + axis + glm::vec3(m_radius)};
+}
+
+ConvexCore CapsuleBoundingBox::getCore(glm::vec3 translation, glm::vec4 orientation) const {
+	return {Capsule,
+	        translation + quaternionRotate(orientation, m_position),
+	        quaternionMatrix(orientation),
+	        glm::vec3(0, m_halfHeight, 0),
+	        nullptr,
+	        0,
+	        m_radius};
+}
+
+CapsuleBoundingBox::~CapsuleBoundingBox() {}
+
+
+
+/* --- BOXBOUNDINGBOX --- */
+
+
+
+BoxBoundingBox::BoxBoundingBox(glm::vec3 position, glm::vec3 halfExtents, float restitutionCoef, float sliding)
+    : BoundingBox::BoundingBox(restitutionCoef, sliding, position, BoundingBoxType::Box),
+      m_halfExtents(halfExtents),
+      m_margin(min(0.04f, 0.2f * min(halfExtents.x, min(halfExtents.y, halfExtents.z)))) {}
+
+glm::vec3 BoxBoundingBox::getHalfExtents() const { return m_halfExtents; }
+
+// Demi-côtés projetés sur les axes du monde : |R| . h
+AABB BoxBoundingBox::getAABB(glm::vec3 translation, glm::vec4 orientation) const {
+	glm::vec3 center = translation + quaternionRotate(orientation, m_position);
+	glm::mat3 rotation = quaternionMatrix(orientation);
+	glm::vec3 extent =
+	    glm::abs(rotation[0]) * m_halfExtents.x + glm::abs(rotation[1]) * m_halfExtents.y + glm::abs(rotation[2]) * m_halfExtents.z;
+	return {center - extent, center + extent};
+}
+
+ConvexCore BoxBoundingBox::getCore(glm::vec3 translation, glm::vec4 orientation) const {
+	return {Box,
+	        translation + quaternionRotate(orientation, m_position),
+	        quaternionMatrix(orientation),
+	        m_halfExtents - glm::vec3(m_margin),
+	        nullptr,
+	        0,
+	        m_margin};
+}
+
+BoxBoundingBox::~BoxBoundingBox() {}
+
+
+
+/* --- CONVEXHULLBOUNDINGBOX --- */
+
+
+
+ConvexHullBoundingBox::ConvexHullBoundingBox(glm::vec3 position, vector<glm::vec3> vertices, float restitutionCoef, float sliding)
+    : BoundingBox::BoundingBox(restitutionCoef, sliding, position, BoundingBoxType::ConvexHull), m_vertices(vertices) {
+	if (m_vertices.empty()) {
+		m_vertices.push_back(glm::vec3(0));
+	}
+}
+
+vector<glm::vec3> const& ConvexHullBoundingBox::getVertices() const { return m_vertices; }
+
+AABB ConvexHullBoundingBox::getAABB(glm::vec3 translation, glm::vec4 orientation) const {
+	glm::vec3 center = translation + quaternionRotate(orientation, m_position);
+	AABB      box = {glm::vec3(INFINITY), glm::vec3(-INFINITY)};
+	for (glm::vec3 const& vertex : m_vertices) {
+		glm::vec3 point = center + quaternionRotate(orientation, vertex);
+		box.min = glm::min(box.min, point);
+		box.max = glm::max(box.max, point);
+	}
+	return box;
+}
+
+ConvexCore ConvexHullBoundingBox::getCore(glm::vec3 translation, glm::vec4 orientation) const {
+	return {ConvexHull,
+	        translation + quaternionRotate(orientation, m_position),
+	        quaternionMatrix(orientation),
+	        glm::vec3(0),
+	        m_vertices.data(),
+	        (unsigned int)m_vertices.size(),
+	        0};
+}
+
+ConvexHullBoundingBox::~ConvexHullBoundingBox() {}
+
+
+
+/* --- HEIGHTFIELDBOUNDINGBOX --- */
+
+
+
+HeightfieldBoundingBox::HeightfieldBoundingBox(HeightMap const& heightMap, glm::vec3 position, float restitutionCoef, float sliding)
+    : BoundingBox::BoundingBox(restitutionCoef, sliding, position, BoundingBoxType::Heightfield), m_heightMap(heightMap) {}
+
+HeightMap const& HeightfieldBoundingBox::getHeightMap() const { return m_heightMap; }
+
+AABB HeightfieldBoundingBox::getAABB(glm::vec3 translation, glm::vec4 orientation) const {
+	glm::vec3 low(0, m_heightMap.getMinHeight(), 0);
+	glm::vec3 high(m_heightMap.getWidth(), m_heightMap.getMaxHeight(), m_heightMap.getDepth());
+	glm::vec3 center = translation + quaternionRotate(orientation, m_position + (low + high) * 0.5f);
+	glm::mat3 rotation = quaternionMatrix(orientation);
+	glm::vec3 half = (high - low) * 0.5f;
+	glm::vec3 extent = glm::abs(rotation[0]) * half.x + glm::abs(rotation[1]) * half.y + glm::abs(rotation[2]) * half.z;
+	return {center - extent, center + extent};
+}
+
+ConvexCore HeightfieldBoundingBox::getCore(glm::vec3 translation, glm::vec4 orientation) const {
+	return {Heightfield,
+	        translation + quaternionRotate(orientation, m_position),
+	        quaternionMatrix(orientation),
+	        glm::vec3(0),
+	        nullptr,
+	        0,
+	        0,
+	        &m_heightMap};
+}
+
+HeightfieldBoundingBox::~HeightfieldBoundingBox() {}
+
+
+
 /* --- BALLJOINT --- */
 
 
@@ -378,10 +1558,315 @@ BallJoint::BallJoint(WorldObject* worldObject1, glm::vec3 wO1Contact, WorldObjec
 	m_twist = glm::mat2x3(glm::vec3(1, 1, 1), glm::vec3(0, 0, 0));
 }
 
-void BallJoint::applyConstraints(double deltaTime) {
-	if (deltaTime <= 0) {
+BallJoint::~BallJoint() {}
+
+
+
+/* --- HINGEJOINT --- */
+
+
+
+HingeJoint::HingeJoint(WorldObject* worldObject1, glm::vec3 wO1Contact, WorldObject* worldObject2, glm::vec3 wO2Contact, glm::vec3 axis)
+    : Joint::Joint(worldObject1, wO1Contact, worldObject2, wO2Contact),
+      m_axis1(glm::normalize(axis)),
+      m_lowerLimit(0),
+      m_upperLimit(0),
+      m_limited(false),
+      m_perpendicular1(glm::vec3(0)),
+      m_perpendicular2(glm::vec3(0)),
+      m_angularMass(glm::mat2(0)),
+      m_angularBias(glm::vec2(0)),
+      m_angularImpulse(glm::vec2(0)),
+      m_axis(glm::vec3(0)),
+      m_axialMass(0),
+      m_limitBias(0),
+      m_limitImpulse(0),
+      m_limitState(0) {
+	m_twist = glm::mat2x3(m_axis1, glm::vec3(0));
+
+	// Une perpendiculaire quelconque à l'axe sert de référence pour l'angle
+	m_reference1 = abs(m_axis1.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+	m_reference1 = glm::normalize(m_reference1 - m_axis1 * glm::dot(m_reference1, m_axis1));
+
+	// Axe et référence exprimés dans le repère du second objet : q2-1 . q1 . v
+	glm::vec4 orientation1 = this->getOrientation(worldObject1);
+	glm::vec4 orientation2 = this->getOrientation(worldObject2);
+	glm::vec4 conjugate2(-orientation2.x, -orientation2.y, -orientation2.z, orientation2.w);
+	m_axis2 = quaternionRotate(conjugate2, quaternionRotate(orientation1, m_axis1));
+	m_reference2 = quaternionRotate(conjugate2, quaternionRotate(orientation1, m_reference1));
+}
+
+// Angle de rotation du second objet par rapport au premier autour de l'axe, dans [-pi, pi]
+float HingeJoint::getAngle() const {
+	glm::vec3 axis = this->getWorldAxis();
+	glm::vec3 reference1 = quaternionRotate(this->getOrientation(m_worldObject1), m_reference1);
+	glm::vec3 reference2 = quaternionRotate(this->getOrientation(m_worldObject2), m_reference2);
+	return atan2(glm::dot(glm::cross(reference1, reference2), axis), glm::dot(reference1, reference2));
+}
+
+float HingeJoint::getSpeed() const {
+	return glm::dot(this->getAngularSpeed(m_worldObject2) - this->getAngularSpeed(m_worldObject1), this->getWorldAxis());
+}
+
+glm::vec3 HingeJoint::getWorldAxis() const { return quaternionRotate(this->getOrientation(m_worldObject1), m_axis1); }
+bool      HingeJoint::getLimited() const { return m_limited; }
+float     HingeJoint::getLowerLimit() const { return m_lowerLimit; }
+float     HingeJoint::getUpperLimit() const { return m_upperLimit; }
+
+HingeJoint& HingeJoint::setLimits(float lowerLimit, float upperLimit) {
+	m_lowerLimit = min(lowerLimit, upperLimit);
+	m_upperLimit = max(lowerLimit, upperLimit);
+	m_limited = true;
+	return *this;
+}
+
+JointCache HingeJoint::getCache() const {
+	return {m_pointImpulse, glm::vec3(m_angularImpulse.x, m_angularImpulse.y, 0), m_limitImpulse, m_limitState};
+}
+
+void HingeJoint::setCache(JointCache const& cache) {
+	m_pointImpulse = cache.pointImpulse;
+	m_angularImpulse = glm::vec2(cache.angularImpulse.x, cache.angularImpulse.y);
+	m_limitImpulse = cache.limitImpulse;
+	m_limitState = cache.limitState;
+}
+
+HingeJoint& HingeJoint::removeLimits() {
+	m_limited = false;
+	m_limitImpulse = 0;
+	return *this;
+}
+
+void HingeJoint::prepare(double deltaTime) {
+	this->preparePoint(deltaTime);
+
+	glm::vec4 orientation1 = this->getOrientation(m_worldObject1);
+	glm::vec3 axis2 = quaternionRotate(this->getOrientation(m_worldObject2), m_axis2);
+	glm::mat3 inverseInertia = this->getInverseInertia(m_worldObject1) + this->getInverseInertia(m_worldObject2);
+
+	// Base perpendiculaire à l'axe liée au premier objet : les impulsions accumulées restent comparables d'un pas à l'autre
+	m_axis = quaternionRotate(orientation1, m_axis1);
+	m_perpendicular1 = quaternionRotate(orientation1, m_reference1);
+	m_perpendicular2 = glm::cross(m_axis, m_perpendicular1);
+
+	glm::vec3 inertia1 = inverseInertia * m_perpendicular1;
+	glm::vec3 inertia2 = inverseInertia * m_perpendicular2;
+	glm::mat2 K(glm::vec2(glm::dot(m_perpendicular1, inertia1), glm::dot(m_perpendicular2, inertia1)),
+	            glm::vec2(glm::dot(m_perpendicular1, inertia2), glm::dot(m_perpendicular2, inertia2)));
+	float     determinant = K[0][0] * K[1][1] - K[0][1] * K[1][0];
+	m_angularMass = abs(determinant) > 1e-12f ? glm::inverse(K) : glm::mat2(0);
+
+	// a1 ^ a2 : petite rotation qui sépare les deux axes
+	glm::vec3 misalignment = glm::cross(m_axis, axis2);
+	float     factor = m_baumgarte / (float)deltaTime;
+	m_angularBias = glm::vec2(glm::dot(misalignment, m_perpendicular1), glm::dot(misalignment, m_perpendicular2)) * factor;
+
+	// Butées : à l'approche, la vitesse est limitée pour atteindre la butée sans la dépasser
+	float axialInverseMass = glm::dot(m_axis, inverseInertia * m_axis);
+	m_axialMass = axialInverseMass > 0 ? 1 / axialInverseMass : 0;
+
+	int   limitState = 0;
+	float angle = this->getAngle();
+	if (m_limited && angle <= m_lowerLimit + 0.01f) {
+		limitState = -1;
+		m_limitBias = angle > m_lowerLimit ? (angle - m_lowerLimit) / (float)deltaTime : (angle - m_lowerLimit) * factor;
+	} else if (m_limited && angle >= m_upperLimit - 0.01f) {
+		limitState = 1;
+		m_limitBias = angle < m_upperLimit ? (angle - m_upperLimit) / (float)deltaTime : (angle - m_upperLimit) * factor;
+	}
+	if (limitState != m_limitState) {
+		m_limitImpulse = 0;
+	}
+	m_limitState = limitState;
+}
+
+void HingeJoint::warmStart() {
+	this->warmStartPoint();
+
+	glm::vec3 impulse = m_perpendicular1 * m_angularImpulse.x + m_perpendicular2 * m_angularImpulse.y + m_axis * m_limitImpulse;
+	this->applyAngularImpulse(m_worldObject1, -impulse);
+	this->applyAngularImpulse(m_worldObject2, impulse);
+}
+
+void HingeJoint::solveVelocities() {
+	// Butée : impulsion de signe imposé
+	if (m_limitState != 0) {
+		float axialSpeed = glm::dot(this->getAngularSpeed(m_worldObject2) - this->getAngularSpeed(m_worldObject1), m_axis);
+		float lambda = -m_axialMass * (axialSpeed + m_limitBias);
+		float oldImpulse = m_limitImpulse;
+		m_limitImpulse = m_limitState < 0 ? max(m_limitImpulse + lambda, 0.0f) : min(m_limitImpulse + lambda, 0.0f);
+
+		glm::vec3 impulse = m_axis * (m_limitImpulse - oldImpulse);
+		this->applyAngularImpulse(m_worldObject1, -impulse);
+		this->applyAngularImpulse(m_worldObject2, impulse);
+	}
+
+	// Pas de rotation relative hors de l'axe
+	glm::vec3 relativeSpeed = this->getAngularSpeed(m_worldObject2) - this->getAngularSpeed(m_worldObject1);
+	glm::vec2 speed(glm::dot(relativeSpeed, m_perpendicular1), glm::dot(relativeSpeed, m_perpendicular2));
+	glm::vec2 lambda = m_angularMass * -(speed + m_angularBias);
+	m_angularImpulse += lambda;
+
+	glm::vec3 impulse = m_perpendicular1 * lambda.x + m_perpendicular2 * lambda.y;
+	this->applyAngularImpulse(m_worldObject1, -impulse);
+	this->applyAngularImpulse(m_worldObject2, impulse);
+
+	this->solvePoint();
+}
+
+HingeJoint::~HingeJoint() {}
+
+
+
+/* --- FIXEDJOINT --- */
+
+
+
+FixedJoint::FixedJoint(WorldObject* worldObject1, glm::vec3 wO1Contact, WorldObject* worldObject2, glm::vec3 wO2Contact)
+    : Joint::Joint(worldObject1, wO1Contact, worldObject2, wO2Contact),
+      m_angularMass(glm::mat3(0)),
+      m_angularBias(glm::vec3(0)),
+      m_angularImpulse(glm::vec3(0)) {
+	m_twist = glm::mat2x3(glm::vec3(0), glm::vec3(0));
+
+	glm::vec4 orientation1 = this->getOrientation(worldObject1);
+	glm::vec4 conjugate1(-orientation1.x, -orientation1.y, -orientation1.z, orientation1.w);
+	m_relativeOrientation = quaternionProduct(conjugate1, this->getOrientation(worldObject2));
+}
+
+JointCache FixedJoint::getCache() const { return {m_pointImpulse, m_angularImpulse, 0, 0}; }
+
+void FixedJoint::setCache(JointCache const& cache) {
+	m_pointImpulse = cache.pointImpulse;
+	m_angularImpulse = cache.angularImpulse;
+}
+
+void FixedJoint::prepare(double deltaTime) {
+	this->preparePoint(deltaTime);
+
+	m_angularMass = inverseOrZero(this->getInverseInertia(m_worldObject1) + this->getInverseInertia(m_worldObject2));
+
+	// qe = q2 . (q1 . q0)-1 : rotation du second objet depuis son orientation cible, 2 . vec(qe) pour une petite rotation
+	glm::vec4 target = quaternionProduct(this->getOrientation(m_worldObject1), m_relativeOrientation);
+	glm::vec4 error = quaternionProduct(this->getOrientation(m_worldObject2), glm::vec4(-target.x, -target.y, -target.z, target.w));
+	if (error.w < 0) {
+		error = -error;
+	}
+	m_angularBias = 2.0f * glm::vec3(error.x, error.y, error.z) * (m_baumgarte / (float)deltaTime);
+}
+
+void FixedJoint::warmStart() {
+	this->warmStartPoint();
+	this->applyAngularImpulse(m_worldObject1, -m_angularImpulse);
+	this->applyAngularImpulse(m_worldObject2, m_angularImpulse);
+}
+
+void FixedJoint::solveVelocities() {
+	glm::vec3 relativeSpeed = this->getAngularSpeed(m_worldObject2) - this->getAngularSpeed(m_worldObject1);
+	glm::vec3 impulse = m_angularMass * -(relativeSpeed + m_angularBias);
+	m_angularImpulse += impulse;
+
+	this->applyAngularImpulse(m_worldObject1, -impulse);
+	this->applyAngularImpulse(m_worldObject2, impulse);
+
+	this->solvePoint();
+}
+
+FixedJoint::~FixedJoint() {}
+
+
+
+/* --- JOINTMOTOR --- */
+
+
+
+JointMotor::JointMotor(HingeJoint* joint, float stiffness, float damping, float maxTorque, unsigned int decimation)
+    : m_joint(joint),
+      m_stiffness(stiffness),
+      m_damping(damping),
+      m_maxTorque(maxTorque),
+      m_decimation(max(decimation, 1u)),
+      m_targetAngle(0),
+      m_targetSpeed(0),
+      m_torque(0),
+      m_phase(0) {}
+
+HingeJoint*     JointMotor::getJoint() { return m_joint; }
+float           JointMotor::getStiffness() const { return m_stiffness; }
+float           JointMotor::getDamping() const { return m_damping; }
+float           JointMotor::getMaxTorque() const { return m_maxTorque; }
+unsigned int    JointMotor::getDecimation() const { return m_decimation; }
+float           JointMotor::getTargetAngle() const { return m_targetAngle; }
+float           JointMotor::getTargetSpeed() const { return m_targetSpeed; }
+float           JointMotor::getTorque() const { return m_torque; }
+JointMotorState JointMotor::getState() const { return {m_targetAngle, m_targetSpeed, m_torque, m_phase}; }
+
+JointMotor& JointMotor::setGains(float stiffness, float damping) {
+	m_stiffness = stiffness;
+	m_damping = damping;
+	return *this;
+}
+
+JointMotor& JointMotor::setMaxTorque(float maxTorque) {
+	m_maxTorque = maxTorque;
+	return *this;
+}
+
+JointMotor& JointMotor::setDecimation(unsigned int decimation) {
+	m_decimation = max(decimation, 1u);
+	m_phase = 0;
+	return *this;
+}
+
+// Une nouvelle cible réveille le squelette : endormi, il ne serait plus actionné
+JointMotor& JointMotor::setTarget(float angle, float speed) {
+	if (angle != m_targetAngle || speed != m_targetSpeed) {
+		for (WorldObject* worldObject : {m_joint->getWorldObject1(), m_joint->getWorldObject2()}) {
+			worldObject->getStore().wake(worldObject->getIndex());
+		}
+	}
+	m_targetAngle = angle;
+	m_targetSpeed = speed;
+	return *this;
+}
+
+void JointMotor::setState(JointMotorState const& state) {
+	m_targetAngle = state.targetAngle;
+	m_targetSpeed = state.targetSpeed;
+	m_torque = state.torque;
+	m_phase = state.phase % m_decimation;
+}
+
+// Le couple est réappliqué à chaque pas, les forces et couples moteurs étant remis à zéro une fois consommés.
+// Un solide bloqué ne reçoit rien : ses forces ne sont jamais consommées.
+// Une articulation endormie n'est pas actionnée, applyJointTorque la réveillerait : un moteur qui tient une pose laisse son
+// squelette s'endormir, et seule une nouvelle cible (setTarget) le réveille. Les solides libres s'en remettent à
+// IslandManager::checkForces, qui ignore un couple inchangé
+void JointMotor::actuate(Articulation* articulation) {
+	if (articulation != nullptr && !articulation->isAwake()) {
 		return;
 	}
+	if (m_phase == 0) {
+		// getAngle est dans [-π, π] : l'écart y est ramené pour tourner du côté le plus court
+		float error = remainder(m_targetAngle - m_joint->getAngle(), 2 * M_PI);
+		float torque = m_stiffness * error + m_damping * (m_targetSpeed - m_joint->getSpeed());
+		m_torque = glm::clamp(torque, -m_maxTorque, m_maxTorque);
+	}
+	m_phase = (m_phase + 1) % m_decimation;
+
+	if (articulation != nullptr) {
+		articulation->applyJointTorque(m_joint, m_torque);
+		return;
+	}
+	glm::vec3    torque = m_joint->getWorldAxis() * m_torque;
+	WorldObject* worldObject1 = m_joint->getWorldObject1();
+	WorldObject* worldObject2 = m_joint->getWorldObject2();
+	if (!worldObject1->getSolid().getLocked()) {
+		worldObject1->applyWrench(glm::mat2x3(glm::vec3(0), -torque), m_joint->getContact1());
+	}
+	if (!worldObject2->getSolid().getLocked()) {
+		worldObject2->applyWrench(glm::mat2x3(glm::vec3(0), torque), m_joint->getContact2());
+	}
 }
 
-BallJoint::~BallJoint() {}
+JointMotor::~JointMotor() {}
@@ -2,15 +2,22 @@
 #define PHYSICS
 
 #include "../maths/utils.hpp"
-#include "../three/main.hpp"
-#include "../lib/glad/glad.h"
+#include "articulation.hpp"
+#include "broadphase.hpp"
+#include "integrator.hpp"
+#include "island.hpp"
+#include "narrowphase.hpp"
+#include "solver.hpp"
 #include <glm/glm.hpp>
 #include <vector>
+#include <chrono>
 #include <cmath>
 
+class JointMotor;
+
 class Clock {
   private:
-	long long                                                   m_deltaTime;
+	long long                                                   m_deltaTime;  // en nanosecondes
 	std::chrono::time_point<std::chrono::high_resolution_clock> m_now;
 
   public:
@@ -50,8 +57,6 @@ class Mass {
 	~Mass();
 };
 
-enum BoundingBoxType { Sphere };
-
 class BoundingBox {
   protected:
 	float           m_restitutionCoef;
@@ -67,124 +72,396 @@ class BoundingBox {
 	glm::vec3       getPosition() const;
 	BoundingBoxType getType() const;
 	virtual float   getRadius() const;
-	virtual Force intersect(BoundingBox const& boundingBox, glm::vec3 hisTranslation, UnitQuaternion hisRotation, glm::vec3 thisTranslation,
-	                        UnitQuaternion thisRotation, glm::vec3 thisSpeed) const = 0;
+	virtual AABB    getAABB(glm::vec3 translation, glm::vec4 orientation) const = 0;  // pose de l'objet dans le repère monde
+	// direction normée, impact à origin + distance . direction ; le type choisit la fonction de ConvexCollider
+	bool            raycast(glm::vec3 translation, glm::vec4 orientation, glm::vec3 origin, glm::vec3 direction, float maxDistance,
+	                        float& distance, glm::vec3& normal) const;
+	virtual ConvexCore getCore(glm::vec3 translation, glm::vec4 orientation) const = 0;  // volume vu par la phase étroite
+	// Réaction de boundingBox sur ce volume, hors d'un Planet ; le couple de types choisit la fonction de ConvexCollider
+	Force intersect(BoundingBox const& boundingBox, glm::vec3 hisTranslation, UnitQuaternion hisRotation, glm::vec3 thisTranslation,
+	                UnitQuaternion thisRotation, glm::vec3 thisSpeed) const;
 
 	~BoundingBox();
 };
 
-// L'ensemble des calculs effectués dans cette classe se feront dans le repère local de l'objet
+// Répartition des masses d'un objet. L'ensemble des calculs effectués dans cette classe se feront dans le repère local de l'objet
 class Solid {
   protected:
 	std::vector<Mass> m_masses;
 	glm::vec3         m_inertiaCenter;
 	glm::mat3         m_inertiaTensor;
 	bool              m_locked;
-	glm::vec3         m_speedVector;
-	glm::vec3         m_angularMomentum;
+
+	// Recalculés à chaque modification des masses
+	float     m_totalMass;
+	float     m_inverseMass;            // 0 pour un solide bloqué ou sans masse
+	glm::mat3 m_inverseInertiaTensor;  // nul pour un solide bloqué ou dont le tenseur n'est pas inversible
 
   public:
 	Solid(std::vector<Mass> masses = std::vector<Mass>(), bool locked = false);
 
 	// getters
-	bool      getLocked() const;
-	float     getTotalMass() const;
-	glm::vec3 getInertiaCenter() const;
-	glm::mat3 getInertiaTensor() const;
-	glm::vec3 getSpeedVector() const;
-	glm::vec3 getAngularMomentum() const;
-	glm::vec3 getAngularSpeed() const;
-	glm::vec3 getSpeedAt(glm::vec3 point) const;
+	bool                     getLocked() const;
+	float                    getTotalMass() const;
+	float                    getInverseMass() const;
+	glm::vec3                getInertiaCenter() const;
+	glm::mat3                getInertiaTensor() const;
+	glm::mat3                getInverseInertiaTensor() const;
+	std::vector<Mass> const& getMasses() const;
+
+	// setters
+	Solid& setLocked(bool locked);
+	Solid& setMasses(std::vector<Mass> const& masses);
+	Solid& addMass(Mass const& mass);
 
 	// memoization
+	void calculateTotalMass();
 	void calculateInertiaCenter();
 	void calculateInertiaTensor();
-
-	// setters
-	Solid& setSpeedVector(glm::vec3 speedVector);
-	Solid& setAngularMomentum(glm::vec3 angularMomentum);
-	Solid& incrementSpeed(glm::vec3 deltaSpeed);
-	Solid& incrementAngularMomentum(glm::vec3 deltaAngularMomentum);
-	Solid& applyLinearImpulse(glm::vec3 impulse);
-	Solid& applyAngularImpulse(glm::vec3 impulse);
+	void calculateInverses();
+	void calculateAll();
 
 	~Solid();
 };
 
+class ThreadPool;
+class WorldObject;
+
+// Ligne du BodyStore dans un instantané du Planet : état dynamique seul, les masses et inerties ne changent pas
+struct BodyState {
+	WorldObject* owner;
+	WorldObject* islandNext;
+	glm::vec3    position;
+	glm::vec4    orientation;
+	glm::vec3    velocity;
+	glm::vec3    angularMomentum;
+	glm::vec3    force;
+	glm::vec3    torque;
+	glm::vec3    restForce;
+	glm::vec3    restTorque;
+	float        sleepTime;
+};
+
+// État dynamique de tous les solides d'un monde, rangé en tableaux contigus (structure of arrays).
+// Chaque WorldObject est une poignée vers une ligne de ces tableaux, l'intégration est une simple boucle sur les tableaux.
+// Les solides éveillés occupent les premières lignes : les solides endormis et immobiles ne sont jamais parcourus.
+class BodyStore {
+  private:
+	std::vector<WorldObject*> m_owners;
+	std::vector<glm::vec3>    m_positions;        // origine du repère local, repère monde
+	std::vector<glm::vec4>    m_orientations;     // quaternions unitaires (x, y, z, w)
+	std::vector<glm::vec3>    m_velocities;       // vitesse du centre d'inertie, repère monde
+	std::vector<glm::vec3>    m_angularMomenta;   // par rapport au centre d'inertie, repère monde
+	std::vector<glm::vec3>    m_forces;           // accumulées jusqu'au prochain pas, repère monde
+	std::vector<glm::vec3>    m_torques;          // par rapport au centre d'inertie, repère monde
+	std::vector<float>        m_inverseMasses;    // 0 pour un solide bloqué
+	std::vector<glm::mat3>    m_inverseInertias;       // repère local, nulle pour un solide bloqué
+	std::vector<glm::mat3>    m_worldInverseInertias;  // R . I0-1 . Rt, recalculée à chaque changement d'orientation
+	std::vector<glm::vec3>    m_inertiaCenters;        // repère local
+	std::vector<float>        m_sleepTimes;            // temps passé sous les seuils de sommeil, en secondes
+	std::vector<glm::vec3>    m_restForces;            // forces reçues au dernier pas éveillé, qui ne suffisent pas à réveiller
+	std::vector<glm::vec3>    m_restTorques;
+	std::vector<WorldObject*> m_islandNext;            // anneau des solides d'une île endormie, nullptr pour un solide éveillé
+	unsigned int              m_nbrAwake;              // les lignes [0, m_nbrAwake) sont éveillées
+	Integrator*               m_integrator;            // non possédé
+
+	void swapRows(unsigned int index1, unsigned int index2);
+
+  public:
+	BodyStore();
+
+	unsigned int size() const;
+	unsigned int getNbrAwake() const;
+	bool         isAwake(unsigned int index) const;
+	unsigned int add(WorldObject* owner);
+	void         remove(unsigned int index);
+	unsigned int moveTo(unsigned int index, BodyStore& store);
+	Integrator&  getIntegrator();
+	BodyStore&   setIntegrator(Integrator& integrator);
+
+	std::vector<WorldObject*>& getOwners();
+	std::vector<glm::vec3>&    getPositions();
+	std::vector<glm::vec4>&    getOrientations();
+	std::vector<glm::vec3>&    getVelocities();
+	std::vector<glm::vec3>&    getAngularMomenta();
+	std::vector<glm::vec3>&    getForces();
+	std::vector<glm::vec3>&    getTorques();
+	std::vector<float>&        getInverseMasses();
+	std::vector<glm::mat3>&    getInverseInertias();
+	std::vector<glm::mat3>&    getWorldInverseInertias();
+	std::vector<glm::vec3>&    getInertiaCenters();
+	std::vector<float>&        getSleepTimes();
+	std::vector<glm::vec3>&    getRestForces();
+	std::vector<glm::vec3>&    getRestTorques();
+
+	void wake(unsigned int index);                         // réveille toute l'île du solide, sans effet sur un solide bloqué
+	void sleep(std::vector<WorldObject*> const& island);   // vitesses annulées, les lignes quittent la partie éveillée
+	void reorder(std::vector<WorldObject*> const& order);  // order[i] passe à la ligne i
+	void save(BodyState* states) const;                    // size() états, dans l'ordre des lignes
+	bool restore(BodyState const* states, unsigned int nbrAwake);  // mêmes solides, lignes remises dans l'ordre enregistré
+	void updateWorldInverseInertia(unsigned int index);
+	void applyForces(unsigned int index, double deltaTime);  // forces et moments accumulés versés dans les vitesses
+	void integrate(unsigned int begin, unsigned int end, double deltaTime);
+	void integrate(double deltaTime);
+	void syncTransforms(unsigned int begin, unsigned int end);
+	void syncTransforms();
+
+	~BodyStore();
+};
+
 // Travail dans le repère monde
+// La position et l'orientation sont portées par un Transform (par exemple un Mesh), la physique ne dépend pas du rendu.
+// L'état dynamique vit dans un BodyStore : celui du Planet auquel l'objet est ajouté, sinon le sien.
 class WorldObject {
   private:
 	std::vector<BoundingBox*> m_boundingBoxes;
 	Solid&                    m_solid;
-	Mesh&                     m_mesh;
+	Transform&                m_transform;
 
-	glm::vec3 m_resultantForce;  // dans le repère monde
-	glm::vec3 m_torque;          // Par rapport au centre de masse, dans le repère monde
+	BodyStore    m_ownStore;  // utilisé tant que l'objet n'appartient à aucun Planet
+	BodyStore*   m_store;
+	unsigned int m_index;
+
+	friend class BodyStore;
 
   public:
-	WorldObject(std::vector<BoundingBox*> boundingBoxes, Solid& solid, Mesh& mesh);
+	WorldObject(std::vector<BoundingBox*> boundingBoxes, Solid& solid, Transform& transform);
+	WorldObject(WorldObject const&) = delete;
+	WorldObject& operator=(WorldObject const&) = delete;
 
 	glm::vec3    getTorque() const;
 	glm::vec3    getResultantForce() const;
 	WorldObject& applyForce(Force const& force);       // force : pt d'application dans le repère local et direction dans le repère monde
 	glm::mat2x3  getWrench(Force const& force) const;  // force de la même nature que précisé précédemment
 	WorldObject& applyWrench(glm::mat2x3 wrench, glm::vec3 point);  // wrench dans le repère monde et point dans le repère local
+	// Sur un solide endormi, la force ne réveille son île au pas suivant que si elle change vraiment (IslandManager)
+
+	// état dynamique, lu et écrit dans le BodyStore
+	glm::vec3      getPosition() const;
+	UnitQuaternion getOrientation() const;
+	glm::vec3      getSpeedVector() const;
+	WorldObject&   setSpeedVector(glm::vec3 speedVector);
+	glm::vec3      getAngularMomentum() const;
+	WorldObject&   setAngularMomentum(glm::vec3 angularMomentum);
+	glm::vec3      getAngularSpeed() const;
+	glm::vec3      getSpeedAt(glm::vec3 point) const;  // point dans le repère local
+	WorldObject&   applyLinearImpulse(glm::vec3 impulse);
+	WorldObject&   applyAngularImpulse(glm::vec3 impulse);
 
 	std::vector<BoundingBox*>& getBoundingBoxes();
 	Solid&                     getSolid();
-	Mesh&                      getMesh();
+	Transform&                 getTransform();
+	BodyStore&                 getStore();
+	unsigned int               getIndex() const;
+	bool                       isAttached() const;  // rangé dans le BodyStore d'un Planet plutôt que dans le sien
+	WorldObject&               attach(BodyStore& store);
+	WorldObject&               detach();
+	WorldObject&               pullTransform();  // à appeler après avoir déplacé le Transform à la main
+	WorldObject&               pullSolid();      // à appeler après avoir modifié les masses du Solid
 	WorldObject&               update(double deltaTime);
 
 	~WorldObject();
 };
 
+// Impulsions accumulées d'une liaison, seul état qu'elle garde d'un pas à l'autre
+struct JointCache {
+	glm::vec3 pointImpulse;
+	glm::vec3 angularImpulse;  // x et y seulement pour un pivot
+	float     limitImpulse;
+	int       limitState;
+};
+
+// Liaison entre deux objets, résolue par impulsions sur les vitesses (impulsions séquentielles, comme les contacts).
+// Les impulsions accumulées sont gardées d'un pas à l'autre et réappliquées avant la résolution (warm starting).
 class Joint {
   protected:
 	WorldObject* m_worldObject1;
-	glm::vec3    m_wO1Contact;
+	glm::vec3    m_wO1Contact;  // point de liaison dans le repère local du premier objet
 	WorldObject* m_worldObject2;
-	glm::vec3    m_wO2Contact;
-	glm::mat2x3  m_twist;
+	glm::vec3    m_wO2Contact;  // le même point dans le repère local du second objet
+	glm::mat2x3  m_twist;       // mouvements relatifs autorisés : rotation puis translation
+
+	// Coïncidence des deux points, commune à toutes les liaisons
+	float     m_baumgarte;  // part de l'erreur de position corrigée à chaque pas
+	glm::vec3 m_arm1;       // du centre d'inertie au point de liaison, repère monde
+	glm::vec3 m_arm2;
+	glm::mat3 m_pointMass;  // inverse de la matrice de masse effective du point
+	glm::vec3 m_pointBias;
+	glm::vec3 m_pointImpulse;
+
+	// Accès aux BodyStore des deux objets, pour lesquels les liaisons écrivent directement vitesses et moments cinétiques
+	glm::vec4 getOrientation(WorldObject* worldObject) const;
+	glm::mat3 getInverseInertia(WorldObject* worldObject) const;
+	glm::vec3 getAngularSpeed(WorldObject* worldObject) const;
+	glm::vec3 getVelocityAt(WorldObject* worldObject, glm::vec3 arm) const;
+	void      applyImpulse(WorldObject* worldObject, glm::vec3 impulse, glm::vec3 arm);
+	void      applyAngularImpulse(WorldObject* worldObject, glm::vec3 impulse);
+
+	void preparePoint(double deltaTime);
+	void warmStartPoint();
+	void solvePoint();
 
   public:
 	Joint(WorldObject* worldObject1, glm::vec3 wO1Contact, WorldObject* worldObject2, glm::vec3 wO2Contact);
 
 	WorldObject* getWorldObject1();
 	WorldObject* getWorldObject2();
+	glm::vec3    getContact1() const;
+	glm::vec3    getContact2() const;
 	glm::mat2x3& getTwist();
-	virtual void applyConstraints(double deltaTime) = 0;
+	glm::vec3    getPointImpulse() const;
+	Joint&       setBaumgarte(float baumgarte);
 
-	~Joint();
+	virtual JointCache getCache() const;
+	virtual void       setCache(JointCache const& cache);
+	virtual void       prepare(double deltaTime);
+	virtual void warmStart();
+	virtual void solveVelocities();
+	void         applyConstraints(double deltaTime, unsigned int iterations = 8);  // résolution seule, hors d'un Planet
+
+	virtual ~Joint();
 };
 
+// Ensemble de solides reliés par des liaisons, résolues par impulsions (coordonnées maximales)
+// ou, en mode articulé, par une Articulation en coordonnées réduites dont le premier solide est la racine
 class Skeleton {
   private:
 	std::vector<WorldObject*> m_worldObjects;
 	std::vector<Joint*>       m_joints;
+	std::vector<JointMotor*>  m_motors;        // non possédés, actionnés au début de chaque pas
+	Articulation*             m_articulation;  // possédée, nullptr hors du mode articulé
 
   public:
 	Skeleton(std::vector<WorldObject*> worldObjects, std::vector<Joint*> joints);
-
-	std::vector<Joint*>& getJoints();
-	void                 update(double deltaTime);
+	Skeleton(Skeleton const&) = delete;
+	Skeleton& operator=(Skeleton const&) = delete;
+
+	std::vector<WorldObject*>& getWorldObjects();
+	std::vector<Joint*>&       getJoints();
+	std::vector<JointMotor*>&  getMotors();
+	Articulation*              getArticulation();
+	Skeleton&                  setArticulated(bool articulated);  // refusé une fois le squelette ajouté à un Planet
+	Skeleton&                  addMotor(JointMotor* motor);       // avant l'ajout à un Planet
+	// Une cible par moteur, dans l'ordre d'ajout ; speeds nul pour des vitesses cibles nulles
+	Skeleton&                  setTargets(const float* angles, const float* speeds = nullptr);
+	void                       actuate();  // couples des moteurs, une fois par pas avant la résolution
+	void                       applyConstraints(double deltaTime, unsigned int iterations = 8);
+	void                       update(double deltaTime);
 
 	~Skeleton();
 };
 
+// Volume trouvé par une requête sur le monde
+struct QueryHit {
+	WorldObject* worldObject;
+	BoundingBox* boundingBox;
+};
+
+struct RaycastHit {
+	WorldObject* worldObject;
+	BoundingBox* boundingBox;
+	glm::vec3    point;
+	glm::vec3    normal;
+	float        distance;
+};
+
+// En-tête d'un instantané du Planet, suivi des tableaux BodyState, ContactManifold, JointCache, ArticulationLinkState,
+// JointMotorState et Contact, rangés par alignement décroissant
+struct PlanetSnapshotHeader {
+	char     magic[4];
+	uint32_t nbrBodies;
+	uint32_t nbrAwake;
+	uint32_t nbrJoints;
+	uint32_t nbrLinks;
+	uint32_t nbrMotors;
+	uint32_t nbrContacts;
+	uint32_t nbrManifolds;
+	float    alpha;
+	uint64_t randomSeed;
+	uint64_t randomState;
+	double   accumulator;
+};
+
+// Le monde physique : il peut être avancé en temps réel (update) ou pas à pas sans fenêtre ni contexte OpenGL (step)
 class Planet {
   private:
-	Clock                  m_clock;
-	float                  m_gravityIntensity;
-	Scene                  m_scene;
-	std::vector<Skeleton*> m_skeletons;
+	Clock                      m_clock;
+	float                      m_gravityIntensity;
+	std::vector<Skeleton*>     m_skeletons;
+	std::vector<Joint*>        m_joints;         // liaisons de tous les squelettes, résolues par lot
+	std::vector<Articulation*> m_articulations;  // squelettes en mode articulé
+	BodyStore                  m_bodies;
+	Integrator*                m_integrator;
+	SweepAndPrune              m_broadPhase;   // paires candidates pour les collisions
+	DynamicTree                m_tree;         // requêtes sur le monde
+	std::vector<unsigned int>  m_treeProxies;  // feuille de l'arbre de chaque proxy de m_broadPhase
+	std::vector<ConvexCore>    m_rayCores;     // volumes des feuilles de l'arbre, figés pour un lot de rayons
+	SphereBatch                m_sphereBatch;
+	std::vector<unsigned int>  m_sphereOfProxy;  // sphère du lot de chaque proxy, NO_SPHERE entre deux pas
+	std::vector<Contact>       m_contacts;       // résultat de la phase étroite au dernier pas
+	ContactSolver              m_contactSolver;
+	unsigned int               m_solverIterations;  // plus d'itérations : contacts plus rigides, pas plus coûteux
+	IslandManager              m_islands;
+	ThreadPool*                m_threadPool;  // non possédé, nul pour résoudre les îles sur le thread appelant
+
+	// Pas de temps fixe : le temps réel écoulé est accumulé puis consommé par pas constants
+	double       m_fixedDeltaTime;
+	unsigned int m_maxSubSteps;  // borne le coût d'une image, le retard au-delà est abandonné
+	double       m_accumulator;
+	float        m_alpha;  // fraction de pas restante, pour interpoler le rendu entre les deux derniers états
+
+	// Forces appliquées pendant l'image, rejouées à chacun de ses pas
+	std::vector<std::pair<WorldObject*, glm::mat2x3>> m_frameWrenches;
+
+	// Mode déterministe : un pas fixe par appel à update, sans horloge, et un générateur à graine pour les environnements
+	bool   m_deterministic;
+	Random m_random;
+
+	void stepIsland(unsigned int index, double deltaTime);
 
   public:
-	Planet(float gravityIntensity = 9.81);
-
-	Scene&  getScene();
-	Planet& add(Skeleton* skeleton);
-	Planet& remove(Skeleton* skeleton);
-	void    update();
+	Planet(float gravityIntensity = 9.81, double fixedDeltaTime = 1.0 / 240, unsigned int maxSubSteps = 8,
+	       IntegratorType integratorType = SemiImplicitEuler, unsigned int solverIterations = 8);
+	Planet(Planet const&) = delete;
+	Planet& operator=(Planet const&) = delete;
+
+	std::vector<Skeleton*>& getSkeletons();
+	BodyStore&              getBodies();
+	Integrator&             getIntegrator();
+	SweepAndPrune&          getBroadPhase();
+	DynamicTree&            getTree();
+	std::vector<Contact>&   getContacts();
+	ContactSolver&          getContactSolver();
+	IslandManager&          getIslands();
+	unsigned int            getSolverIterations() const;
+	Planet&                 setSolverIterations(unsigned int solverIterations);
+	double                  getFixedDeltaTime() const;
+	Planet&                 setFixedDeltaTime(double fixedDeltaTime);
+	unsigned int            getMaxSubSteps() const;
+	Planet&                 setMaxSubSteps(unsigned int maxSubSteps);
+	float                   getAlpha() const;
+	bool                    getDeterministic() const;
+	Planet&                 setDeterministic(bool deterministic, uint64_t seed = 0);  // resème aussi le générateur
+	Random&                 getRandom();
+	uint64_t                hashState();  // empreinte bit à bit des poses et vitesses, dans l'ordre des squelettes
+	ThreadPool*             getThreadPool();
+	Planet&                 setThreadPool(ThreadPool* threadPool);
+	Planet&                 add(Skeleton* skeleton);
+	Planet&                 remove(Skeleton* skeleton);
+	void                    updateBroadPhase(double deltaTime = 0, bool sleeping = false);  // sleeping : solides endormis compris
+	void                    updateNarrowPhase();
+	std::vector<QueryHit>   queryAABB(AABB const& box);
+	std::vector<QueryHit>   querySphere(glm::vec3 center, float radius);
+	bool                    raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, RaycastHit& hit);
+	// Lot de rayons (capteurs) dans des tableaux plats : un rayon manqué reçoit maxDistance, une normale et un objet nuls.
+	// normals et worldObjects peuvent être nuls ; renvoie le nombre d'impacts. Réparti sur le pool de threads s'il y en a un
+	unsigned int            raycast(const glm::vec3* origins, const glm::vec3* directions, unsigned int nbrRays, float maxDistance,
+	                                float* distances, glm::vec3* normals = nullptr, WorldObject** worldObjects = nullptr);
+	void                    step(double deltaTime);
+	unsigned int            update();
+	// Instantané de tout l'état dynamique, copiable tel quel : valable pour ce Planet tant que ses squelettes ne changent pas
+	void save(std::vector<unsigned char>& snapshot);  // réutilise la mémoire du vecteur
+	bool restore(std::vector<unsigned char> const& snapshot);
 
 	~Planet();
 };
@@ -199,23 +476,204 @@ class SphereBoundingBox : public BoundingBox {
   public:
 	SphereBoundingBox(glm::vec3 position = glm::vec3(), float radius = 1, float restitutionCoef = 1, float sliding = 1);
 
-	float getRadius() const;
-	Force intersect(BoundingBox const& boundingBox, glm::vec3 hisTranslation, UnitQuaternion hisRotation, glm::vec3 thisTranslation,
-	                UnitQuaternion thisRotation, glm::vec3 thisSpeed) const;
+	float      getRadius() const;
+	AABB       getAABB(glm::vec3 translation, glm::vec4 orientation) const;
+	ConvexCore getCore(glm::vec3 translation, glm::vec4 orientation) const;
 
 	~SphereBoundingBox();
 };
 
+// Segment de demi-longueur halfHeight le long de l'axe y local de l'objet, grossi de radius (les jambes du robot)
+class CapsuleBoundingBox : public BoundingBox {
+  private:
+	float m_radius;
+	float m_halfHeight;
+
+  public:
+	CapsuleBoundingBox(glm::vec3 position = glm::vec3(), float radius = 0.5, float halfHeight = 0.5, float restitutionCoef = 1,
+	                   float sliding = 1);
+
+	float      getRadius() const;
+	float      getHalfHeight() const;
+	AABB       getAABB(glm::vec3 translation, glm::vec4 orientation) const;
+	ConvexCore getCore(glm::vec3 translation, glm::vec4 orientation) const;
+
+	~CapsuleBoundingBox();
+};
+
+// Boîte de demi-côtés halfExtents, orientée comme l'objet. Pour la phase étroite, c'est une boîte réduite d'une petite marge puis
+// arrondie de cette marge : les contacts peu profonds restent dans le cas direct de GJK, sans passer par EPA
+class BoxBoundingBox : public BoundingBox {
+  private:
+	glm::vec3 m_halfExtents;
+	float     m_margin;
+
+  public:
+	BoxBoundingBox(glm::vec3 position = glm::vec3(), glm::vec3 halfExtents = glm::vec3(0.5), float restitutionCoef = 1, float sliding = 1);
+
+	glm::vec3  getHalfExtents() const;
+	AABB       getAABB(glm::vec3 translation, glm::vec4 orientation) const;
+	ConvexCore getCore(glm::vec3 translation, glm::vec4 orientation) const;
+
+	~BoxBoundingBox();
+};
+
+// Enveloppe convexe de sommets donnés dans le repère local de l'objet, relativement à position. Les points intérieurs sont
+// inutiles mais sans danger ; chaque sommet coûte un produit scalaire par évaluation de la fonction support
+class ConvexHullBoundingBox : public BoundingBox {
+  private:
+	std::vector<glm::vec3> m_vertices;
+
+  public:
+	ConvexHullBoundingBox(glm::vec3 position = glm::vec3(), std::vector<glm::vec3> vertices = std::vector<glm::vec3>(),
+	                      float restitutionCoef = 1, float sliding = 1);
+
+	std::vector<glm::vec3> const& getVertices() const;
+	AABB                          getAABB(glm::vec3 translation, glm::vec4 orientation) const;
+	ConvexCore                    getCore(glm::vec3 translation, glm::vec4 orientation) const;
+
+	~ConvexHullBoundingBox();
+};
+
+// Terrain : la grille d'une HeightMap, placée à position dans le repère de l'objet (un solide bloqué, en général).
+// La HeightMap n'est pas copiée, elle doit vivre aussi longtemps que le volume ; le même HeightMapGeometry en donne le rendu
+class HeightfieldBoundingBox : public BoundingBox {
+  private:
+	HeightMap const& m_heightMap;
+
+  public:
+	HeightfieldBoundingBox(HeightMap const& heightMap, glm::vec3 position = glm::vec3(), float restitutionCoef = 1, float sliding = 1);
+
+	HeightMap const& getHeightMap() const;
+	AABB             getAABB(glm::vec3 translation, glm::vec4 orientation) const;
+	ConvexCore       getCore(glm::vec3 translation, glm::vec4 orientation) const;
+
+	~HeightfieldBoundingBox();
+};
+
 
 // Les liaisons
 
+// Rotule : les deux points coïncident, rotations libres
 class BallJoint : public Joint {
   public:
 	BallJoint(WorldObject* worldObject1, glm::vec3 wO1Contact, WorldObject* worldObject2, glm::vec3 wO2Contact);
 
-	void applyConstraints(double deltaTime);
-
 	~BallJoint();
 };
 
+// Pivot : rotation autour d'un seul axe, éventuellement bornée
+class HingeJoint : public Joint {
+  protected:
+	glm::vec3 m_axis1;       // axe de rotation dans le repère local de chaque objet
+	glm::vec3 m_axis2;
+	glm::vec3 m_reference1;  // perpendiculaires à l'axe, alignées quand l'angle est nul
+	glm::vec3 m_reference2;
+	float     m_lowerLimit;  // en radians
+	float     m_upperLimit;
+	bool      m_limited;
+
+	// Deux lignes angulaires perpendiculaires à l'axe et une ligne de butée
+	glm::vec3 m_perpendicular1;
+	glm::vec3 m_perpendicular2;
+	glm::mat2 m_angularMass;
+	glm::vec2 m_angularBias;
+	glm::vec2 m_angularImpulse;
+	glm::vec3 m_axis;  // axe dans le repère monde au pas courant
+	float     m_axialMass;
+	float     m_limitBias;
+	float     m_limitImpulse;
+	int       m_limitState;  // -1 en butée basse, 1 en butée haute, 0 sinon
+
+  public:
+	// axis dans le repère local du premier objet, l'angle est nul dans la position relative actuelle des objets
+	HingeJoint(WorldObject* worldObject1, glm::vec3 wO1Contact, WorldObject* worldObject2, glm::vec3 wO2Contact, glm::vec3 axis);
+
+	float       getAngle() const;
+	float       getSpeed() const;  // vitesse angulaire du second objet par rapport au premier autour de l'axe
+	glm::vec3   getWorldAxis() const;
+	bool        getLimited() const;
+	float       getLowerLimit() const;
+	float       getUpperLimit() const;
+	HingeJoint& setLimits(float lowerLimit, float upperLimit);
+	HingeJoint& removeLimits();
+
+	JointCache getCache() const;
+	void       setCache(JointCache const& cache);
+	void       prepare(double deltaTime);
+	void       warmStart();
+	void       solveVelocities();
+
+	~HingeJoint();
+};
+
+// Encastrement : aucune rotation ni translation relative, l'orientation relative actuelle est conservée
+class FixedJoint : public Joint {
+  protected:
+	glm::vec4 m_relativeOrientation;  // q1-1 . q2 à la création
+	glm::mat3 m_angularMass;
+	glm::vec3 m_angularBias;
+	glm::vec3 m_angularImpulse;
+
+  public:
+	FixedJoint(WorldObject* worldObject1, glm::vec3 wO1Contact, WorldObject* worldObject2, glm::vec3 wO2Contact);
+
+	JointCache getCache() const;
+	void       setCache(JointCache const& cache);
+	void       prepare(double deltaTime);
+	void       warmStart();
+	void       solveVelocities();
+
+	~FixedJoint();
+};
+
+
+// Les moteurs
+
+// Ce qu'un moteur garde d'un pas à l'autre, pour les instantanés du Planet
+struct JointMotorState {
+	float    targetAngle;
+	float    targetSpeed;
+	float    torque;
+	uint32_t phase;
+};
+
+// Moteur d'un pivot asservi en position et en vitesse (PD), comme les servomoteurs des pattes du robot :
+// tau = stiffness . (angle cible - angle) + damping . (vitesse cible - vitesse), borné à maxTorque.
+// Le couple est calculé dans le pas de physique, puis maintenu pendant decimation pas : la politique, bien plus lente,
+// ne fait que déplacer les cibles. En mode articulé, il est versé dans la coordonnée articulaire du pivot
+class JointMotor {
+  private:
+	HingeJoint*  m_joint;
+	float        m_stiffness;   // N.m/rad
+	float        m_damping;     // N.m.s/rad
+	float        m_maxTorque;   // N.m
+	unsigned int m_decimation;  // pas de physique par calcul du couple
+	float        m_targetAngle;
+	float        m_targetSpeed;
+	float        m_torque;  // du premier objet sur le second autour de l'axe, maintenu entre deux calculs
+	unsigned int m_phase;   // pas écoulés depuis le dernier calcul
+
+  public:
+	JointMotor(HingeJoint* joint, float stiffness, float damping, float maxTorque, unsigned int decimation = 1);
+
+	HingeJoint*     getJoint();
+	float           getStiffness() const;
+	float           getDamping() const;
+	float           getMaxTorque() const;
+	unsigned int    getDecimation() const;
+	float           getTargetAngle() const;
+	float           getTargetSpeed() const;
+	float           getTorque() const;
+	JointMotor&     setGains(float stiffness, float damping);
+	JointMotor&     setMaxTorque(float maxTorque);
+	JointMotor&     setDecimation(unsigned int decimation);
+	JointMotor&     setTarget(float angle, float speed = 0);  // l'écart à l'angle de HingeJoint::getAngle est ramené dans [-pi, pi]
+	JointMotorState getState() const;
+	void            setState(JointMotorState const& state);
+	void            actuate(Articulation* articulation);  // articulation du squelette, nullptr hors du mode articulé
+
+	~JointMotor();
+};
+
 #endif
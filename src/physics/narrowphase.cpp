@@ -0,0 +1,1130 @@
+#include "narrowphase.hpp"
+#include "../maths/utils.hpp"
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Les noyaux vectoriels n'utilisent pas fmadd : sans ce réglage, -march=native laisserait le compilateur contracter les restes
+// scalaires en FMA, et une paire changerait de verdict selon le lot où elle tombe. Les commandes du README passent aussi
+// -ffp-contract=off pour le reste du moteur
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+using namespace std;
+
+
+
+/* --- SPHEREBATCH --- */
+
+
+
+SphereBatch::SphereBatch() {}
+
+void SphereBatch::clear() {
+	m_x.clear();
+	m_y.clear();
+	m_z.clear();
+	m_radii.clear();
+	m_proxies.clear();
+	m_pairs1.clear();
+	m_pairs2.clear();
+}
+
+unsigned int SphereBatch::addSphere(glm::vec3 center, float radius, unsigned int proxy) {
+	m_x.push_back(center.x);
+	m_y.push_back(center.y);
+	m_z.push_back(center.z);
+	m_radii.push_back(radius);
+	m_proxies.push_back(proxy);
+	return m_x.size() - 1;
+}
+
+void SphereBatch::addPair(unsigned int sphere1, unsigned int sphere2) {
+	m_pairs1.push_back(sphere1);
+	m_pairs2.push_back(sphere2);
+}
+
+unsigned int SphereBatch::getNbrSpheres() const { return m_x.size(); }
+unsigned int SphereBatch::getProxy(unsigned int sphere) const { return m_proxies[sphere]; }
+unsigned int SphereBatch::getNbrPairs() const { return m_pairs1.size(); }
+
+unsigned int SphereBatch::collide(vector<Contact>& contacts) const {
+	return SphereBatch::collide(m_x.data(), m_y.data(), m_z.data(), m_radii.data(), m_pairs1.data(), m_pairs2.data(), m_pairs1.size(),
+	                            m_proxies.data(), contacts);
+}
+
+// Détail d'un contact confirmé par le test vectoriel
+static void addContact(const float* x, const float* y, const float* z, const float* radii, unsigned int sphere1, unsigned int sphere2,
+                       const unsigned int* proxies, vector<Contact>& contacts) {
+	glm::vec3 center1(x[sphere1], y[sphere1], z[sphere1]);
+	glm::vec3 center2(x[sphere2], y[sphere2], z[sphere2]);
+	glm::vec3 delta = center2 - center1;
+	float     distance = glm::length(delta);
+
+	// Centres confondus : une normale arbitraire plutôt qu'une division par 0
+	glm::vec3 normal = distance > 1e-6f ? delta / distance : glm::vec3(0, 1, 0);
+
+	Contact contact;
+	contact.proxy1 = proxies ? proxies[sphere1] : sphere1;
+	contact.proxy2 = proxies ? proxies[sphere2] : sphere2;
+	contact.normal = normal;
+	contact.depth = radii[sphere1] + radii[sphere2] - distance;
+	contact.point1 = center1 + normal * radii[sphere1];
+	contact.point2 = center2 - normal * radii[sphere2];
+	contacts.push_back(contact);
+}
+
+unsigned int SphereBatch::collide(const float* x, const float* y, const float* z, const float* radii, const unsigned int* pairs1,
+                                  const unsigned int* pairs2, unsigned int nbrPairs, const unsigned int* proxies,
+                                  vector<Contact>& contacts) {
+	unsigned int nbrContacts = contacts.size();
+	unsigned int i = 0;
+
+#if defined(__AVX2__)
+	// |c2 - c1|² < (r1 + r2)² sur 8 paires, les sphères étant lues par gather
+	for (; i + 8 <= nbrPairs; i += 8) {
+		__m256i index1 = _mm256_loadu_si256((const __m256i*)(pairs1 + i));
+		__m256i index2 = _mm256_loadu_si256((const __m256i*)(pairs2 + i));
+
+		__m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(x, index2, 4), _mm256_i32gather_ps(x, index1, 4));
+		__m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(y, index2, 4), _mm256_i32gather_ps(y, index1, 4));
+		__m256 dz = _mm256_sub_ps(_mm256_i32gather_ps(z, index2, 4), _mm256_i32gather_ps(z, index1, 4));
+		__m256 radius = _mm256_add_ps(_mm256_i32gather_ps(radii, index1, 4), _mm256_i32gather_ps(radii, index2, 4));
+
+		// Sans fmadd : même arrondi que les chemins SSE et scalaire, une paire ne change pas de verdict selon le lot où elle tombe
+		__m256 squaredDistance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		int    mask = _mm256_movemask_ps(_mm256_cmp_ps(squaredDistance, _mm256_mul_ps(radius, radius), _CMP_LT_OQ));
+
+		while (mask) {
+			int lane = __builtin_ctz(mask);
+			addContact(x, y, z, radii, pairs1[i + lane], pairs2[i + lane], proxies, contacts);
+			mask &= mask - 1;
+		}
+	}
+#elif defined(__SSE2__)
+	// Même test sur 4 paires, sans gather : chargement scalaire des sphères
+	for (; i + 4 <= nbrPairs; i += 4) {
+		const unsigned int* a = pairs1 + i;
+		const unsigned int* b = pairs2 + i;
+
+		__m128 dx = _mm_sub_ps(_mm_setr_ps(x[b[0]], x[b[1]], x[b[2]], x[b[3]]), _mm_setr_ps(x[a[0]], x[a[1]], x[a[2]], x[a[3]]));
+		__m128 dy = _mm_sub_ps(_mm_setr_ps(y[b[0]], y[b[1]], y[b[2]], y[b[3]]), _mm_setr_ps(y[a[0]], y[a[1]], y[a[2]], y[a[3]]));
+		__m128 dz = _mm_sub_ps(_mm_setr_ps(z[b[0]], z[b[1]], z[b[2]], z[b[3]]), _mm_setr_ps(z[a[0]], z[a[1]], z[a[2]], z[a[3]]));
+		__m128 radius = _mm_add_ps(_mm_setr_ps(radii[a[0]], radii[a[1]], radii[a[2]], radii[a[3]]),
+		                           _mm_setr_ps(radii[b[0]], radii[b[1]], radii[b[2]], radii[b[3]]));
+
+		__m128 squaredDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		int    mask = _mm_movemask_ps(_mm_cmplt_ps(squaredDistance, _mm_mul_ps(radius, radius)));
+
+		while (mask) {
+			int lane = __builtin_ctz(mask);
+			addContact(x, y, z, radii, a[lane], b[lane], proxies, contacts);
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	// Reste des paires, ou tout le lot sans SIMD
+	for (; i < nbrPairs; i++) {
+		unsigned int a = pairs1[i];
+		unsigned int b = pairs2[i];
+		float        dx = x[b] - x[a];
+		float        dy = y[b] - y[a];
+		float        dz = z[b] - z[a];
+		float        radius = radii[a] + radii[b];
+		if (dx * dx + dy * dy + dz * dz < radius * radius) {
+			addContact(x, y, z, radii, a, b, proxies, contacts);
+		}
+	}
+
+	return contacts.size() - nbrContacts;
+}
+
+SphereBatch::~SphereBatch() {}
+
+
+
+/* --- CONVEXCORE --- */
+
+
+
+glm::vec3 ConvexCore::support(glm::vec3 direction) const {
+	glm::vec3 local = glm::transpose(rotation) * direction;
+	if (vertices != nullptr) {
+		unsigned int best = 0;
+		float        bestProjection = glm::dot(vertices[0], local);
+		for (unsigned int i = 1; i < nbrVertices; i++) {
+			float projection = glm::dot(vertices[i], local);
+			if (projection > bestProjection) {
+				best = i;
+				bestProjection = projection;
+			}
+		}
+		return center + rotation * vertices[best];
+	}
+
+	// Boîte, segment ou point : le coin du côté de la direction sur chaque axe
+	glm::vec3 corner(local.x < 0 ? -halfExtents.x : halfExtents.x, local.y < 0 ? -halfExtents.y : halfExtents.y,
+	                 local.z < 0 ? -halfExtents.z : halfExtents.z);
+	return center + rotation * corner;
+}
+
+unsigned int ConvexCore::getNbrCorners() const {
+	switch (type) {
+		case Capsule:
+			return 2;
+		case Box:
+			return 8;
+		case ConvexHull:
+			return nbrVertices;
+		default:
+			return 0;
+	}
+}
+
+glm::vec3 ConvexCore::getCorner(unsigned int index) const {
+	if (vertices != nullptr) {
+		return center + rotation * vertices[index];
+	}
+	glm::vec3 corner(index & 1 ? -halfExtents.x : halfExtents.x, index & 2 ? -halfExtents.y : halfExtents.y,
+	                 index & 4 ? -halfExtents.z : halfExtents.z);
+	if (type == Capsule) {
+		corner = glm::vec3(0, index == 0 ? halfExtents.y : -halfExtents.y, 0);
+	}
+	return center + rotation * corner;
+}
+
+
+
+/* --- CONVEXCOLLIDER --- */
+
+
+
+// Sommet de la différence de Minkowski noyau1 - noyau2, avec les points des deux noyaux qui l'ont produit
+struct SupportPoint {
+	glm::vec3 point1;
+	glm::vec3 point2;
+	glm::vec3 w;
+};
+
+struct PolytopeFace {
+	unsigned int vertices[3];
+	glm::vec3    normal;    // sortante
+	float        distance;  // de l'origine au plan de la face
+};
+
+const unsigned int GJK_MAX_ITERATIONS = 32;
+const unsigned int EPA_MAX_VERTICES = 64;
+const unsigned int EPA_MAX_FACES = 128;
+const float        EPA_TOLERANCE = 1e-4f;
+const float        CORNER_TOLERANCE = 0.01f;  // écart toléré entre un sommet en contact et la surface de l'autre volume
+const unsigned int HEIGHTFIELD_MAX_CONTACTS = 4;
+
+static SupportPoint getSupport(ConvexCore const& core1, ConvexCore const& core2, glm::vec3 direction) {
+	SupportPoint support;
+	support.point1 = core1.support(direction);
+	support.point2 = core2.support(-direction);
+	support.w = support.point1 - support.point2;
+	return support;
+}
+
+// Point le plus proche de l'origine sur un triangle, en coordonnées barycentriques (Ericson, régions de Voronoï)
+static glm::vec3 closestOnTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+	glm::vec3 ab = b - a;
+	glm::vec3 ac = c - a;
+	float     d1 = glm::dot(ab, -a);
+	float     d2 = glm::dot(ac, -a);
+	if (d1 <= 0 && d2 <= 0) {
+		return glm::vec3(1, 0, 0);
+	}
+
+	float d3 = glm::dot(ab, -b);
+	float d4 = glm::dot(ac, -b);
+	if (d3 >= 0 && d4 <= d3) {
+		return glm::vec3(0, 1, 0);
+	}
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+		float v = d1 / (d1 - d3);
+		return glm::vec3(1 - v, v, 0);
+	}
+
+	float d5 = glm::dot(ab, -c);
+	float d6 = glm::dot(ac, -c);
+	if (d6 >= 0 && d5 <= d6) {
+		return glm::vec3(0, 0, 1);
+	}
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+		float w = d2 / (d2 - d6);
+		return glm::vec3(1 - w, 0, w);
+	}
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+		float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		return glm::vec3(0, 1 - w, w);
+	}
+
+	float denominator = 1 / (va + vb + vc);
+	float v = vb * denominator;
+	float w = vc * denominator;
+	return glm::vec3(1 - v - w, v, w);
+}
+
+// Réduit le simplexe aux sommets de poids non nul, renvoie le point le plus proche de l'origine
+static glm::vec3 reduceSimplex(SupportPoint* simplex, unsigned int& size, float* weights) {
+	glm::vec3    point(0);
+	unsigned int kept = 0;
+	for (unsigned int i = 0; i < size; i++) {
+		if (weights[i] > 0) {
+			point += simplex[i].w * weights[i];
+			simplex[kept] = simplex[i];
+			weights[kept++] = weights[i];
+		}
+	}
+	size = kept;
+	return point;
+}
+
+static glm::vec3 closestOnSimplex(SupportPoint* simplex, unsigned int& size, float* weights) {
+	if (size == 1) {
+		weights[0] = 1;
+		return simplex[0].w;
+	}
+
+	if (size == 2) {
+		glm::vec3 ab = simplex[1].w - simplex[0].w;
+		float     t = glm::clamp(glm::dot(-simplex[0].w, ab) / max(glm::dot(ab, ab), 1e-20f), 0.0f, 1.0f);
+		weights[0] = 1 - t;
+		weights[1] = t;
+		return reduceSimplex(simplex, size, weights);
+	}
+
+	if (size == 3) {
+		glm::vec3 barycentric = closestOnTriangle(simplex[0].w, simplex[1].w, simplex[2].w);
+		weights[0] = barycentric.x;
+		weights[1] = barycentric.y;
+		weights[2] = barycentric.z;
+		return reduceSimplex(simplex, size, weights);
+	}
+
+	// Tétraèdre : l'origine est dedans, ou le plus proche est sur une des faces qu'elle voit
+	const unsigned int faces[4][4] = {{0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0}};
+	float              bestDistance = INFINITY;
+	SupportPoint       best[3];
+	float              bestWeights[3];
+	unsigned int       bestSize = 0;
+	for (unsigned int f = 0; f < 4; f++) {
+		glm::vec3 a = simplex[faces[f][0]].w;
+		glm::vec3 normal = glm::cross(simplex[faces[f][1]].w - a, simplex[faces[f][2]].w - a);
+		float     origin = glm::dot(normal, -a);
+		float     opposite = glm::dot(normal, simplex[faces[f][3]].w - a);
+		if (origin * opposite > 0 && abs(opposite) > 1e-5f * glm::length(normal)) {
+			continue;  // l'origine est du même côté que le quatrième sommet, qui n'est pas dans le plan de la face
+		}
+
+		SupportPoint face[3] = {simplex[faces[f][0]], simplex[faces[f][1]], simplex[faces[f][2]]};
+		float        faceWeights[3];
+		unsigned int faceSize = 3;
+		glm::vec3    point = closestOnSimplex(face, faceSize, faceWeights);
+		if (glm::dot(point, point) < bestDistance) {
+			bestDistance = glm::dot(point, point);
+			bestSize = faceSize;
+			for (unsigned int i = 0; i < faceSize; i++) {
+				best[i] = face[i];
+				bestWeights[i] = faceWeights[i];
+			}
+		}
+	}
+
+	if (bestSize == 0) {
+		return glm::vec3(0);  // taille 4 conservée : recouvrement
+	}
+	size = bestSize;
+	for (unsigned int i = 0; i < size; i++) {
+		simplex[i] = best[i];
+		weights[i] = bestWeights[i];
+	}
+	return reduceSimplex(simplex, size, weights);
+}
+
+// Distance entre deux noyaux : faux si l'origine est dans leur différence de Minkowski, le simplexe servant alors de départ à EPA
+static bool gjk(ConvexCore const& core1, ConvexCore const& core2, SupportPoint* simplex, unsigned int& size, glm::vec3& point1,
+                glm::vec3& point2) {
+	float     weights[4];
+	glm::vec3 v = core1.center - core2.center;
+	if (glm::dot(v, v) < 1e-12f) {
+		v = glm::vec3(1, 0, 0);
+	}
+
+	size = 0;
+	for (unsigned int iteration = 0; iteration < GJK_MAX_ITERATIONS; iteration++) {
+		SupportPoint support = getSupport(core1, core2, -v);
+		float        squaredDistance = glm::dot(v, v);
+		if (size > 0 && squaredDistance - glm::dot(v, support.w) <= 1e-4f * squaredDistance) {
+			break;  // le nouveau sommet ne rapproche plus de l'origine
+		}
+		bool known = false;
+		for (unsigned int i = 0; i < size; i++) {
+			known = known || simplex[i].w == support.w;
+		}
+		if (known) {
+			break;  // sommet déjà dans le simplexe : l'arrondi empêche d'avancer
+		}
+
+		simplex[size++] = support;
+		v = closestOnSimplex(simplex, size, weights);
+		if (size == 4 || glm::dot(v, v) < 1e-10f) {
+			return false;
+		}
+	}
+
+	point1 = glm::vec3(0);
+	point2 = glm::vec3(0);
+	for (unsigned int i = 0; i < size; i++) {
+		point1 += simplex[i].point1 * weights[i];
+		point2 += simplex[i].point2 * weights[i];
+	}
+	return true;
+}
+
+static bool addFace(PolytopeFace* faces, unsigned int& nbrFaces, SupportPoint const* vertices, unsigned int a, unsigned int b,
+                    unsigned int c) {
+	glm::vec3 normal = glm::cross(vertices[b].w - vertices[a].w, vertices[c].w - vertices[a].w);
+	float     length = glm::length(normal);
+	if (nbrFaces == EPA_MAX_FACES || length < 1e-12f) {
+		return false;
+	}
+	PolytopeFace& face = faces[nbrFaces++];
+	face.vertices[0] = a;
+	face.vertices[1] = b;
+	face.vertices[2] = c;
+	face.normal = normal / length;
+	face.distance = glm::dot(face.normal, vertices[a].w);
+	return true;
+}
+
+// Complète le simplexe de GJK en tétraèdre quand les noyaux ne font que se toucher
+static bool completeSimplex(ConvexCore const& core1, ConvexCore const& core2, SupportPoint* simplex, unsigned int& size) {
+	const glm::vec3 axes[6] = {glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0),
+	                           glm::vec3(0, -1, 0), glm::vec3(0, 0, 1),  glm::vec3(0, 0, -1)};
+	if (size == 0) {
+		simplex[size++] = getSupport(core1, core2, axes[0]);
+	}
+	for (unsigned int i = 0; size == 1 && i < 6; i++) {
+		SupportPoint support = getSupport(core1, core2, axes[i]);
+		if (glm::length(support.w - simplex[0].w) > 1e-6f) {
+			simplex[size++] = support;
+		}
+	}
+	if (size == 2) {
+		glm::vec3 segment = simplex[1].w - simplex[0].w;
+		glm::vec3 axis = abs(segment.x) < abs(segment.y) ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+		glm::vec3 side = glm::cross(segment, axis);
+		glm::vec3 directions[4] = {side, -side, glm::cross(segment, side), -glm::cross(segment, side)};
+		for (unsigned int i = 0; size == 2 && i < 4; i++) {
+			SupportPoint support = getSupport(core1, core2, directions[i]);
+			if (glm::length(glm::cross(support.w - simplex[0].w, segment)) > 1e-6f) {
+				simplex[size++] = support;
+			}
+		}
+	}
+	if (size == 3) {
+		glm::vec3 normal = glm::cross(simplex[1].w - simplex[0].w, simplex[2].w - simplex[0].w);
+		for (float sign : {1.0f, -1.0f}) {
+			SupportPoint support = getSupport(core1, core2, normal * sign);
+			if (size == 3 && abs(glm::dot(normal, support.w - simplex[0].w)) > 1e-9f) {
+				simplex[size++] = support;
+			}
+		}
+	}
+	return size == 4;
+}
+
+// EPA : le polytope qui contient l'origine est gonflé vers la frontière de la différence de Minkowski,
+// sa face la plus proche de l'origine donne la normale et la profondeur du recouvrement
+static bool epa(ConvexCore const& core1, ConvexCore const& core2, SupportPoint* simplex, unsigned int size, glm::vec3& normal,
+                float& depth, glm::vec3& point1, glm::vec3& point2) {
+	SupportPoint vertices[EPA_MAX_VERTICES];
+	PolytopeFace faces[EPA_MAX_FACES];
+	unsigned int nbrVertices = size;
+	unsigned int nbrFaces = 0;
+	if (!completeSimplex(core1, core2, simplex, nbrVertices)) {
+		return false;
+	}
+	for (unsigned int i = 0; i < 4; i++) {
+		vertices[i] = simplex[i];
+	}
+
+	// Faces du tétraèdre orientées vers l'extérieur
+	if (glm::dot(glm::cross(vertices[1].w - vertices[0].w, vertices[2].w - vertices[0].w), vertices[3].w - vertices[0].w) > 0) {
+		swap(vertices[1], vertices[2]);
+	}
+	addFace(faces, nbrFaces, vertices, 0, 1, 2);
+	addFace(faces, nbrFaces, vertices, 0, 3, 1);
+	addFace(faces, nbrFaces, vertices, 0, 2, 3);
+	addFace(faces, nbrFaces, vertices, 1, 3, 2);
+	if (nbrFaces < 4) {
+		return false;
+	}
+
+	auto findClosest = [&]() {
+		unsigned int closest = 0;
+		for (unsigned int f = 1; f < nbrFaces; f++) {
+			if (faces[f].distance < faces[closest].distance) {
+				closest = f;
+			}
+		}
+		return closest;
+	};
+
+	while (nbrVertices < EPA_MAX_VERTICES) {
+		PolytopeFace const& closest = faces[findClosest()];
+		SupportPoint        support = getSupport(core1, core2, closest.normal);
+		if (glm::dot(support.w, closest.normal) - closest.distance < EPA_TOLERANCE) {
+			break;
+		}
+
+		// Faces visibles depuis le nouveau sommet retirées, leur bord (horizon) relié au nouveau sommet
+		unsigned int horizon[EPA_MAX_FACES * 3][2];
+		unsigned int nbrEdges = 0;
+		for (unsigned int f = 0; f < nbrFaces;) {
+			if (glm::dot(faces[f].normal, support.w - vertices[faces[f].vertices[0]].w) <= 0) {
+				f++;
+				continue;
+			}
+			for (unsigned int e = 0; e < 3; e++) {
+				unsigned int a = faces[f].vertices[e];
+				unsigned int b = faces[f].vertices[(e + 1) % 3];
+				bool         shared = false;
+				for (unsigned int k = 0; k < nbrEdges; k++) {
+					if (horizon[k][0] == b && horizon[k][1] == a) {
+						horizon[k][0] = horizon[--nbrEdges][0];
+						horizon[k][1] = horizon[nbrEdges][1];
+						shared = true;
+						break;
+					}
+				}
+				if (!shared) {
+					horizon[nbrEdges][0] = a;
+					horizon[nbrEdges++][1] = b;
+				}
+			}
+			faces[f] = faces[--nbrFaces];
+		}
+
+		vertices[nbrVertices] = support;
+		for (unsigned int k = 0; k < nbrEdges; k++) {
+			addFace(faces, nbrFaces, vertices, horizon[k][0], horizon[k][1], nbrVertices);
+		}
+		nbrVertices++;
+		if (nbrFaces == 0) {
+			return false;
+		}
+	}
+
+	// Projection de l'origine sur la face, en coordonnées barycentriques, pour retrouver les points des deux noyaux
+	PolytopeFace const& face = faces[findClosest()];
+	SupportPoint const& a = vertices[face.vertices[0]];
+	SupportPoint const& b = vertices[face.vertices[1]];
+	SupportPoint const& c = vertices[face.vertices[2]];
+	glm::vec3           projection = face.normal * face.distance;
+	glm::vec3           ab = b.w - a.w;
+	glm::vec3           ac = c.w - a.w;
+	glm::vec3           ap = projection - a.w;
+	float               d00 = glm::dot(ab, ab);
+	float               d01 = glm::dot(ab, ac);
+	float               d11 = glm::dot(ac, ac);
+	float               d20 = glm::dot(ap, ab);
+	float               d21 = glm::dot(ap, ac);
+	float               denominator = d00 * d11 - d01 * d01;
+	float               v = denominator != 0 ? (d11 * d20 - d01 * d21) / denominator : 0;
+	float               w = denominator != 0 ? (d00 * d21 - d01 * d20) / denominator : 0;
+	float               u = 1 - v - w;
+
+	normal = face.normal;
+	depth = face.distance;
+	point1 = a.point1 * u + b.point1 * v + c.point1 * w;
+	point2 = a.point2 * u + b.point2 * v + c.point2 * w;
+	return true;
+}
+
+// Contact entre deux points grossis de leurs rayons
+static unsigned int addPointContact(glm::vec3 center1, float radius1, glm::vec3 center2, float radius2, vector<Contact>& contacts) {
+	glm::vec3 delta = center2 - center1;
+	float     distance = glm::length(delta);
+	if (distance >= radius1 + radius2) {
+		return 0;
+	}
+
+	glm::vec3 normal = distance > 1e-6f ? delta / distance : glm::vec3(0, 1, 0);
+	contacts.push_back({0, 0, normal, radius1 + radius2 - distance, center1 + normal * radius1, center2 - normal * radius2});
+	return 1;
+}
+
+static glm::vec3 closestOnSegment(glm::vec3 point, glm::vec3 a, glm::vec3 b) {
+	glm::vec3 ab = b - a;
+	float     t = glm::clamp(glm::dot(point - a, ab) / max(glm::dot(ab, ab), 1e-20f), 0.0f, 1.0f);
+	return a + ab * t;
+}
+
+// Sommets du premier noyau enfoncés dans le second au-delà de la face de contact de normale normal (du premier vers le second).
+// Un seul point de contact laisse une boîte ou une capsule à plat osciller autour de lui : chaque sommet de la face en donne un.
+// Les contacts déjà ajoutés depuis first ne sont pas dupliqués (deux faces superposées proposent les mêmes coins)
+static unsigned int addCornerContacts(ConvexCore const& core1, ConvexCore const& core2, glm::vec3 normal, float depth, bool reversed,
+                                      unsigned int first, vector<Contact>& contacts) {
+	unsigned int count = 0;
+	float        top = glm::dot(core1.support(normal), normal);
+	for (unsigned int i = 0; i < core1.getNbrCorners(); i++) {
+		glm::vec3 corner = core1.getCorner(i);
+		float     penetration = depth - (top - glm::dot(corner, normal));
+		if (penetration <= 0) {
+			continue;
+		}
+
+		// Un sommet en porte-à-faux est sous le plan de contact sans toucher le second volume
+		glm::vec3    surface = corner + normal * core1.radius;
+		ConvexCore   point = {Sphere, surface, glm::mat3(1), glm::vec3(0), nullptr, 0, 0};
+		SupportPoint simplex[4];
+		unsigned int size;
+		glm::vec3    point1;
+		glm::vec3    point2;
+		if (gjk(point, core2, simplex, size, point1, point2) && glm::length(point1 - point2) > core2.radius + CORNER_TOLERANCE) {
+			continue;
+		}
+
+		Contact contact = {0, 0, normal, penetration, surface, surface - normal * penetration};
+		if (reversed) {
+			contact = {0, 0, -normal, penetration, surface - normal * penetration, surface};
+		}
+		bool duplicate = false;
+		for (unsigned int j = first; j < contacts.size() && !duplicate; j++) {
+			duplicate = glm::length(contacts[j].point1 - contact.point1) < CORNER_TOLERANCE;
+		}
+		if (!duplicate) {
+			contacts.push_back(contact);
+			count++;
+		}
+	}
+	return count;
+}
+
+// Ajoute un contact, sauf si un contact ajouté depuis first est à moins de tolerance : le plus profond des deux est gardé
+static void addUniqueContact(Contact const& contact, float tolerance, unsigned int first, vector<Contact>& contacts) {
+	for (unsigned int i = first; i < contacts.size(); i++) {
+		if (glm::length(contacts[i].point1 - contact.point1) < tolerance) {
+			if (contact.depth > contacts[i].depth) {
+				contacts[i] = contact;
+			}
+			return;
+		}
+	}
+	contacts.push_back(contact);
+}
+
+// Contact d'un noyau avec un triangle du terrain, de normale sortante triangleNormal
+static void addTriangleContact(ConvexCore const& core, glm::vec3 const* triangle, glm::vec3 triangleNormal, unsigned int first,
+                               vector<Contact>& contacts) {
+	glm::vec3 point1 = core.center;
+	glm::vec3 point2;
+	bool      separated = true;
+	if (core.type == Sphere) {
+		glm::vec3 barycentric = closestOnTriangle(triangle[0] - core.center, triangle[1] - core.center, triangle[2] - core.center);
+		point2 = triangle[0] * barycentric.x + triangle[1] * barycentric.y + triangle[2] * barycentric.z;
+	} else {
+		ConvexCore   triangleCore = {ConvexHull, glm::vec3(0), glm::mat3(1), glm::vec3(0), triangle, 3, 0};
+		SupportPoint simplex[4];
+		unsigned int size;
+		separated = gjk(core, triangleCore, simplex, size, point1, point2);
+	}
+
+	glm::vec3 delta = point2 - point1;
+	float     distance = glm::length(delta);
+	Contact   contact;
+	if (!separated || distance < 1e-6f || glm::dot(delta, triangleNormal) > 0.99f * distance) {
+		// Noyau qui traverse le triangle ou passe juste sous lui : repoussé selon la normale du triangle, depuis son point le plus bas.
+		// Sous le plan mais pas sous le triangle (derrière une crête), le point le plus proche est sur un bord et le cas général suffit
+		glm::vec3 lowest = core.support(-triangleNormal) - triangleNormal * core.radius;
+		float     depth = glm::dot(triangle[0] - lowest, triangleNormal);
+		if (depth <= 0) {
+			return;
+		}
+		contact = {0, 0, -triangleNormal, depth, lowest, lowest + triangleNormal * depth};
+	} else {
+		if (distance >= core.radius) {
+			return;
+		}
+		glm::vec3 normal = delta / distance;
+		contact = {0, 0, normal, core.radius - distance, point1 + normal * core.radius, point2};
+	}
+
+	// Les triangles voisins d'un sol presque plan touchent le volume au même endroit, par leurs arêtes, avec des normales de biais :
+	// seul le plus profond est gardé. Au fond d'une vallée, les points sont écartés et chaque versant garde le sien
+	addUniqueContact(contact, max(CORNER_TOLERANCE, 0.5f * core.radius), first, contacts);
+}
+
+// Sommet du terrain dans un noyau grossi de son rayon : GJK tant qu'il reste dans le rayon, EPA au-delà
+static void addVertexContact(ConvexCore const& core, glm::vec3 vertex, unsigned int first, vector<Contact>& contacts) {
+	ConvexCore   point = {Sphere, vertex, glm::mat3(1), glm::vec3(0), nullptr, 0, 0};
+	SupportPoint simplex[4];
+	unsigned int size;
+	glm::vec3    point1;
+	glm::vec3    point2;
+	glm::vec3    normal;
+	float        depth;
+	if (gjk(core, point, simplex, size, point1, point2)) {
+		glm::vec3 delta = point2 - point1;
+		float     distance = glm::length(delta);
+		if (distance >= core.radius || distance < 1e-6f) {
+			return;
+		}
+		normal = delta / distance;
+		depth = core.radius - distance;
+	} else if (epa(core, point, simplex, size, normal, depth, point1, point2)) {
+		depth += core.radius;
+	} else {
+		return;
+	}
+	addUniqueContact({0, 0, normal, depth, point1 + normal * core.radius, vertex}, CORNER_TOLERANCE, first, contacts);
+}
+
+// Garde le contact le plus profond, puis à chaque fois celui qui est le plus loin des contacts déjà gardés
+static void reduceContacts(unsigned int first, unsigned int maxContacts, vector<Contact>& contacts) {
+	if (contacts.size() - first <= maxContacts) {
+		return;
+	}
+
+	unsigned int deepest = first;
+	for (unsigned int i = first + 1; i < contacts.size(); i++) {
+		if (contacts[i].depth > contacts[deepest].depth) {
+			deepest = i;
+		}
+	}
+	swap(contacts[first], contacts[deepest]);
+
+	for (unsigned int kept = first + 1; kept < first + maxContacts; kept++) {
+		unsigned int farthest = kept;
+		float        farthestDistance = -1;
+		for (unsigned int i = kept; i < contacts.size(); i++) {
+			float distance = INFINITY;
+			for (unsigned int j = first; j < kept; j++) {
+				glm::vec3 delta = contacts[i].point1 - contacts[j].point1;
+				distance = min(distance, glm::dot(delta, delta));
+			}
+			if (distance > farthestDistance) {
+				farthest = i;
+				farthestDistance = distance;
+			}
+		}
+		swap(contacts[kept], contacts[farthest]);
+	}
+	contacts.resize(first + maxContacts);
+}
+
+static unsigned int noCollision(ConvexCore const&, ConvexCore const&, vector<Contact>&) { return 0; }
+
+// Appelle une fonction écrite pour le couple de types inverse, puis remet les contacts dans l'ordre des volumes
+template <ConvexCollider::CollideFunction function>
+static unsigned int swapped(ConvexCore const& core1, ConvexCore const& core2, vector<Contact>& contacts) {
+	unsigned int first = contacts.size();
+	unsigned int count = function(core2, core1, contacts);
+	for (unsigned int i = first; i < contacts.size(); i++) {
+		contacts[i].normal = -contacts[i].normal;
+		swap(contacts[i].point1, contacts[i].point2);
+	}
+	return count;
+}
+
+static const ConvexCollider::CollideFunction collideFunctions[NBR_BOUNDING_BOX_TYPES][NBR_BOUNDING_BOX_TYPES] = {
+    {ConvexCollider::collideSpheres, ConvexCollider::collideSphereCapsule, ConvexCollider::collideConvex, ConvexCollider::collideConvex,
+     ConvexCollider::collideHeightfield},
+    {swapped<ConvexCollider::collideSphereCapsule>, ConvexCollider::collideCapsules, ConvexCollider::collideConvex,
+     ConvexCollider::collideConvex, ConvexCollider::collideHeightfield},
+    {ConvexCollider::collideConvex, ConvexCollider::collideConvex, ConvexCollider::collideConvex, ConvexCollider::collideConvex,
+     ConvexCollider::collideHeightfield},
+    {ConvexCollider::collideConvex, ConvexCollider::collideConvex, ConvexCollider::collideConvex, ConvexCollider::collideConvex,
+     ConvexCollider::collideHeightfield},
+    {swapped<ConvexCollider::collideHeightfield>, swapped<ConvexCollider::collideHeightfield>, swapped<ConvexCollider::collideHeightfield>,
+     swapped<ConvexCollider::collideHeightfield>, noCollision}};
+
+unsigned int ConvexCollider::collide(ConvexCore const& core1, ConvexCore const& core2, vector<Contact>& contacts) {
+	return collideFunctions[core1.type][core2.type](core1, core2, contacts);
+}
+
+unsigned int ConvexCollider::collideSpheres(ConvexCore const& sphere1, ConvexCore const& sphere2, vector<Contact>& contacts) {
+	return addPointContact(sphere1.center, sphere1.radius, sphere2.center, sphere2.radius, contacts);
+}
+
+// Capsule à plat sur une grande sphère (le sol) : un contact à chaque extrémité plutôt qu'au seul point le plus proche
+unsigned int ConvexCollider::collideSphereCapsule(ConvexCore const& sphere, ConvexCore const& capsule, vector<Contact>& contacts) {
+	glm::vec3 end1 = capsule.getCorner(0);
+	glm::vec3 end2 = capsule.getCorner(1);
+	float     reach = sphere.radius + capsule.radius;
+	if (glm::length(end1 - sphere.center) < reach && glm::length(end2 - sphere.center) < reach) {
+		return addPointContact(sphere.center, sphere.radius, end1, capsule.radius, contacts) +
+		       addPointContact(sphere.center, sphere.radius, end2, capsule.radius, contacts);
+	}
+	glm::vec3 closest = closestOnSegment(sphere.center, end1, end2);
+	return addPointContact(sphere.center, sphere.radius, closest, capsule.radius, contacts);
+}
+
+// Points les plus proches de deux segments (Ericson) ; des segments presque parallèles se touchent sur un intervalle,
+// dont les deux bouts donnent chacun un contact
+unsigned int ConvexCollider::collideCapsules(ConvexCore const& capsule1, ConvexCore const& capsule2, vector<Contact>& contacts) {
+	glm::vec3 p1 = capsule1.getCorner(0);
+	glm::vec3 q1 = capsule1.getCorner(1);
+	glm::vec3 p2 = capsule2.getCorner(0);
+	glm::vec3 q2 = capsule2.getCorner(1);
+	glm::vec3 d1 = q1 - p1;
+	glm::vec3 d2 = q2 - p2;
+	glm::vec3 r = p1 - p2;
+	float     a = glm::dot(d1, d1);
+	float     e = glm::dot(d2, d2);
+	float     f = glm::dot(d2, r);
+
+	glm::vec3 cross = glm::cross(d1, d2);
+	if (a > 1e-12f && e > 1e-12f && glm::dot(cross, cross) < 1e-6f * a * e) {
+		float t1 = glm::clamp(glm::dot(p2 - p1, d1) / a, 0.0f, 1.0f);
+		float t2 = glm::clamp(glm::dot(q2 - p1, d1) / a, 0.0f, 1.0f);
+		if (abs(t2 - t1) * sqrt(a) > 1e-3f) {
+			glm::vec3 point1 = p1 + d1 * t1;
+			glm::vec3 point2 = p1 + d1 * t2;
+			return addPointContact(point1, capsule1.radius, closestOnSegment(point1, p2, q2), capsule2.radius, contacts) +
+			       addPointContact(point2, capsule1.radius, closestOnSegment(point2, p2, q2), capsule2.radius, contacts);
+		}
+	}
+
+	float s = 0;
+	float t = 0;
+	if (a <= 1e-12f && e <= 1e-12f) {
+		// deux points
+	} else if (a <= 1e-12f) {
+		t = glm::clamp(f / e, 0.0f, 1.0f);
+	} else {
+		float c = glm::dot(d1, r);
+		if (e <= 1e-12f) {
+			s = glm::clamp(-c / a, 0.0f, 1.0f);
+		} else {
+			float b = glm::dot(d1, d2);
+			float denominator = a * e - b * b;
+			s = denominator > 0 ? glm::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0;
+			t = (b * s + f) / e;
+			if (t < 0) {
+				t = 0;
+				s = glm::clamp(-c / a, 0.0f, 1.0f);
+			} else if (t > 1) {
+				t = 1;
+				s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+			}
+		}
+	}
+	return addPointContact(p1 + d1 * s, capsule1.radius, p2 + d2 * t, capsule2.radius, contacts);
+}
+
+// GJK sur les noyaux : s'ils sont séparés de moins que la somme des rayons, le contact est direct ; sinon EPA.
+// Les sommets des faces en contact ajoutent ensuite leurs propres points
+unsigned int ConvexCollider::collideConvex(ConvexCore const& core1, ConvexCore const& core2, vector<Contact>& contacts) {
+	SupportPoint simplex[4];
+	unsigned int size;
+	glm::vec3    point1;
+	glm::vec3    point2;
+	glm::vec3    normal;
+	float        depth;
+	if (gjk(core1, core2, simplex, size, point1, point2)) {
+		glm::vec3 delta = point2 - point1;
+		float     distance = glm::length(delta);
+		depth = core1.radius + core2.radius - distance;
+		if (depth <= 0) {
+			return 0;
+		}
+		normal = delta / distance;
+	} else if (epa(core1, core2, simplex, size, normal, depth, point1, point2)) {
+		depth += core1.radius + core2.radius;
+	} else {
+		return 0;
+	}
+
+	unsigned int first = contacts.size();
+	unsigned int count = addCornerContacts(core1, core2, normal, depth, false, first, contacts);
+	count += addCornerContacts(core2, core1, -normal, depth, true, first, contacts);
+	if (count == 0) {
+		contacts.push_back({0, 0, normal, depth, point1 + normal * core1.radius, point2 - normal * core2.radius});
+		count = 1;
+	}
+	return count;
+}
+
+// Tout se passe dans le repère de la grille : les cases sous la boîte du volume y sont trouvées par division, sans parcours.
+// Une boîte ou une enveloppe est posée par ses sommets (chacun sur le triangle qui est sous lui) et par les sommets de la grille
+// qui entrent dans son noyau ; les triangles des cases servent aux sphères et aux capsules, et aux autres volumes quand rien
+// d'autre ne touche (une arête de la boîte sur une crête)
+unsigned int ConvexCollider::collideHeightfield(ConvexCore const& core, ConvexCore const& heightfield, vector<Contact>& contacts) {
+	HeightMap const& heightMap = *heightfield.heightMap;
+	glm::mat3        toLocal = glm::transpose(heightfield.rotation);
+	ConvexCore       local = core;
+	local.center = toLocal * (core.center - heightfield.center);
+	local.rotation = toLocal * core.rotation;
+
+	glm::vec3 low;
+	glm::vec3 high;
+	for (int axis = 0; axis < 3; axis++) {
+		glm::vec3 direction(0);
+		direction[axis] = 1;
+		high[axis] = local.support(direction)[axis] + local.radius;
+		low[axis] = local.support(-direction)[axis] - local.radius;
+	}
+	if (low.y > heightMap.getMaxHeight() || high.x < 0 || high.z < 0 || low.x > heightMap.getWidth() || low.z > heightMap.getDepth()) {
+		return 0;
+	}
+	int minX;
+	int minZ;
+	int maxX;
+	int maxZ;
+	heightMap.getCell(low.x, low.z, minX, minZ);
+	heightMap.getCell(high.x, high.z, maxX, maxZ);
+
+	unsigned int first = contacts.size();
+	glm::vec3    vertices[6];
+	if (local.getNbrCorners() > 2) {
+		for (unsigned int i = 0; i < local.getNbrCorners(); i++) {
+			glm::vec3 corner = local.getCorner(i);
+			if (corner.x < 0 || corner.z < 0 || corner.x > heightMap.getWidth() || corner.z > heightMap.getDepth()) {
+				continue;
+			}
+
+			int cellX;
+			int cellZ;
+			heightMap.getCell(corner.x, corner.z, cellX, cellZ);
+			heightMap.getTriangles(cellX, cellZ, vertices);
+			float            u = corner.x / heightMap.getCellSize() - cellX;
+			float            w = corner.z / heightMap.getCellSize() - cellZ;
+			glm::vec3 const* triangle = vertices + (u + w <= 1 ? 0 : 3);
+			glm::vec3        normal = glm::normalize(glm::cross(triangle[1] - triangle[0], triangle[2] - triangle[0]));
+			float            depth = local.radius - glm::dot(corner - triangle[0], normal);
+			if (depth > 0) {
+				glm::vec3 point = corner - normal * local.radius;
+				addUniqueContact({0, 0, -normal, depth, point, point + normal * depth}, CORNER_TOLERANCE, first, contacts);
+			}
+		}
+
+		// Une bosse plus étroite que le volume passe entre ses sommets
+		for (int z = minZ; z <= maxZ + 1; z++) {
+			for (int x = minX; x <= maxX + 1; x++) {
+				glm::vec3 vertex = heightMap.getVertex(x, z);
+				if (vertex.y >= low.y) {
+					addVertexContact(local, vertex, first, contacts);
+				}
+			}
+		}
+	}
+
+	if (contacts.size() == first) {
+		for (int cellZ = minZ; cellZ <= maxZ; cellZ++) {
+			for (int cellX = minX; cellX <= maxX; cellX++) {
+				heightMap.getTriangles(cellX, cellZ, vertices);
+				for (unsigned int t = 0; t < 6; t += 3) {
+					if (low.y > max(vertices[t].y, max(vertices[t + 1].y, vertices[t + 2].y))) {
+						continue;
+					}
+					glm::vec3 normal = glm::normalize(glm::cross(vertices[t + 1] - vertices[t], vertices[t + 2] - vertices[t]));
+					addTriangleContact(local, vertices + t, normal, first, contacts);
+				}
+			}
+		}
+	}
+	reduceContacts(first, HEIGHTFIELD_MAX_CONTACTS, contacts);
+
+	for (unsigned int i = first; i < contacts.size(); i++) {
+		contacts[i].normal = heightfield.rotation * contacts[i].normal;
+		contacts[i].point1 = heightfield.center + heightfield.rotation * contacts[i].point1;
+		contacts[i].point2 = heightfield.center + heightfield.rotation * contacts[i].point2;
+	}
+	return contacts.size() - first;
+}
+
+bool ConvexCollider::closestPoints(ConvexCore const& core1, ConvexCore const& core2, glm::vec3& point1, glm::vec3& point2) {
+	SupportPoint simplex[4];
+	unsigned int size;
+	return gjk(core1, core2, simplex, size, point1, point2);
+}
+
+// Chaque pas avance de la distance qui sépare encore le rayon du volume : jamais au-delà de la surface
+bool ConvexCollider::raycastConvex(ConvexCore const& core, glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance,
+                                   glm::vec3& normal) {
+	ConvexCore point = {Sphere, origin, glm::mat3(1), glm::vec3(0), nullptr, 0, 0};
+	float      t = 0;
+	normal = -direction;  // origine dans le volume
+	for (unsigned int iteration = 0; iteration < GJK_MAX_ITERATIONS; iteration++) {
+		point.center = origin + direction * t;
+		glm::vec3 point1;
+		glm::vec3 point2;
+		if (!ConvexCollider::closestPoints(point, core, point1, point2)) {
+			distance = t;  // surface du noyau atteinte, la normale est celle du pas précédent
+			return true;
+		}
+
+		glm::vec3 delta = point1 - point2;
+		float     gap = glm::length(delta) - core.radius;
+		if (gap < 1e-4f) {
+			distance = t;
+			if (t > 0) {
+				normal = delta / glm::length(delta);
+			}
+			return true;
+		}
+		normal = delta / glm::length(delta);
+		if (glm::dot(delta, direction) >= 0) {
+			return false;  // le rayon s'éloigne du volume
+		}
+		t += gap;
+		if (t > maxDistance) {
+			return false;
+		}
+	}
+	return false;
+}
+
+bool ConvexCollider::raycastSphere(ConvexCore const& sphere, glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance,
+                                   glm::vec3& normal) {
+	glm::vec3 toOrigin = origin - sphere.center;
+
+	// |o + t.d - c|² = r² avec |d| = 1 : t² + 2b.t + c = 0
+	float b = glm::dot(toOrigin, direction);
+	float c = glm::dot(toOrigin, toOrigin) - sphere.radius * sphere.radius;
+	if (c > 0 && b > 0) {  // origine hors de la sphère et rayon qui s'en éloigne
+		return false;
+	}
+	float discriminant = b * b - c;
+	if (discriminant < 0) {
+		return false;
+	}
+
+	distance = max(-b - sqrt(discriminant), 0.0f);  // 0 si l'origine est dans la sphère
+	if (distance > maxDistance) {
+		return false;
+	}
+	normal = distance > 0 ? glm::normalize(origin + direction * distance - sphere.center) : -direction;
+	return true;
+}
+
+// Cylindre infini autour de l'axe, limité au segment, puis les deux demi-sphères
+bool ConvexCollider::raycastCapsule(ConvexCore const& capsule, glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance,
+                                    glm::vec3& normal) {
+	glm::vec3 end1 = capsule.getCorner(0);
+	glm::vec3 end2 = capsule.getCorner(1);
+	glm::vec3 segment = end2 - end1;
+	float     squaredLength = glm::dot(segment, segment);
+	float     radius = capsule.radius;
+
+	if (glm::length(origin - closestOnSegment(origin, end1, end2)) <= radius) {
+		distance = 0;
+		normal = -direction;
+		return true;
+	}
+
+	float     best = INFINITY;
+	glm::vec3 toOrigin = origin - end1;
+	float     axisDirection = glm::dot(segment, direction);
+	float     axisOrigin = glm::dot(segment, toOrigin);
+	float     a = squaredLength - axisDirection * axisDirection;
+	if (a > 1e-8f) {
+		float b = squaredLength * glm::dot(direction, toOrigin) - axisOrigin * axisDirection;
+		float c = squaredLength * glm::dot(toOrigin, toOrigin) - axisOrigin * axisOrigin - radius * radius * squaredLength;
+		float discriminant = b * b - a * c;
+		if (discriminant >= 0) {
+			float t = (-b - sqrt(discriminant)) / a;
+			float height = axisOrigin + t * axisDirection;
+			if (t >= 0 && height > 0 && height < squaredLength) {
+				best = t;
+			}
+		}
+	}
+	for (glm::vec3 end : {end1, end2}) {
+		glm::vec3 toEnd = origin - end;
+		float     b = glm::dot(toEnd, direction);
+		float     discriminant = b * b - glm::dot(toEnd, toEnd) + radius * radius;
+		if (discriminant >= 0 && -b - sqrt(discriminant) >= 0) {
+			best = min(best, -b - sqrt(discriminant));
+		}
+	}
+
+	if (best > maxDistance) {
+		return false;
+	}
+	distance = best;
+	glm::vec3 point = origin + direction * distance;
+	normal = glm::normalize(point - closestOnSegment(point, end1, end2));
+	return true;
+}
+
+// Méthode des dalles dans le repère de la boîte, sans les arêtes arrondies : noyau et rayon redonnent les demi-côtés
+bool ConvexCollider::raycastBox(ConvexCore const& box, glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance,
+                                glm::vec3& normal) {
+	glm::vec3 halfExtents = box.halfExtents + glm::vec3(box.radius);
+	glm::vec3 localOrigin = (origin - box.center) * box.rotation;
+	glm::vec3 localDirection = direction * box.rotation;
+
+	float enter = 0;
+	float exit = maxDistance;
+	int   enterAxis = -1;
+	for (int axis = 0; axis < 3; axis++) {
+		if (abs(localDirection[axis]) < 1e-12f) {
+			if (abs(localOrigin[axis]) > halfExtents[axis]) {
+				return false;
+			}
+			continue;
+		}
+		float t1 = (-halfExtents[axis] - localOrigin[axis]) / localDirection[axis];
+		float t2 = (halfExtents[axis] - localOrigin[axis]) / localDirection[axis];
+		if (t1 > t2) {
+			swap(t1, t2);
+		}
+		if (t1 > enter) {
+			enter = t1;
+			enterAxis = axis;
+		}
+		exit = min(exit, t2);
+		if (enter > exit) {
+			return false;
+		}
+	}
+
+	distance = enter;
+	if (enterAxis < 0) {
+		normal = -direction;  // origine dans la boîte
+	} else {
+		normal = box.rotation[enterAxis] * (localDirection[enterAxis] > 0 ? -1.0f : 1.0f);
+	}
+	return true;
+}
+
+bool ConvexCollider::raycastHeightfield(ConvexCore const& heightfield, glm::vec3 origin, glm::vec3 direction, float maxDistance,
+                                        float& distance, glm::vec3& normal) {
+	glm::vec3 localNormal;
+	if (!heightfield.heightMap->raycast((origin - heightfield.center) * heightfield.rotation, direction * heightfield.rotation, maxDistance,
+	                                    distance, localNormal)) {
+		return false;
+	}
+	normal = heightfield.rotation * localNormal;
+	return true;
+}
+
+static const ConvexCollider::RaycastFunction raycastFunctions[NBR_BOUNDING_BOX_TYPES] = {
+    ConvexCollider::raycastSphere, ConvexCollider::raycastCapsule, ConvexCollider::raycastBox, ConvexCollider::raycastConvex,
+    ConvexCollider::raycastHeightfield};
+
+bool ConvexCollider::raycast(ConvexCore const& core, glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance,
+                             glm::vec3& normal) {
+	return raycastFunctions[core.type](core, origin, direction, maxDistance, distance, normal);
+}
@@ -0,0 +1,113 @@
+#ifndef PHYSICS_NARROWPHASE
+#define PHYSICS_NARROWPHASE
+
+#include <glm/glm.hpp>
+#include <vector>
+
+class HeightMap;
+
+// Contact entre deux volumes dans le repère monde, la normale va du premier vers le second
+struct Contact {
+	unsigned int proxy1;
+	unsigned int proxy2;
+	glm::vec3    normal;
+	float        depth;   // interpénétration, positive
+	glm::vec3    point1;  // point le plus profond du premier volume dans le second
+	glm::vec3    point2;  // point le plus profond du second volume dans le premier
+};
+
+enum BoundingBoxType { Sphere, Capsule, Box, ConvexHull, Heightfield };
+
+const unsigned int NBR_BOUNDING_BOX_TYPES = 5;
+
+// Volume convexe placé dans le repère monde, tel que le voit la phase étroite : un noyau (point, segment, boîte ou nuage de
+// sommets) grossi d'un rayon. Sphères et capsules restent ainsi exactes, sans facettes, et GJK ne travaille que sur des polyèdres
+struct ConvexCore {
+	BoundingBoxType  type;
+	glm::vec3        center;       // repère monde
+	glm::mat3        rotation;     // du repère local du volume vers le repère monde
+	glm::vec3        halfExtents;  // nuls pour un point, (0, h, 0) pour un segment
+	const glm::vec3* vertices;     // enveloppe convexe, repère local, nullptr pour les autres noyaux
+	unsigned int     nbrVertices;
+	float            radius;
+	const HeightMap* heightMap = nullptr;  // terrain : la grille, placée par center et rotation ; pas de noyau convexe
+
+	glm::vec3    support(glm::vec3 direction) const;  // point du noyau le plus loin dans la direction, repère monde
+	unsigned int getNbrCorners() const;               // sommets du noyau : 0 pour un point, 2 pour un segment, 8 pour une boîte
+	glm::vec3    getCorner(unsigned int index) const;
+};
+
+// Phase étroite entre volumes convexes quelconques : une fonction par couple de types, choisie dans une table.
+// Sphère-sphère, sphère-capsule et capsule-capsule ont des chemins rapides, les autres couples passent par GJK
+// (distance entre les noyaux) puis EPA quand les noyaux eux-mêmes se recouvrent.
+// Un terrain n'est comparé qu'aux triangles des cases sous l'autre volume, ou sous les sommets d'une boîte ou d'une enveloppe.
+// Les contacts ajoutés ont des proxies nuls, renseignés par l'appelant ; les fonctions renvoient le nombre de contacts ajoutés.
+class ConvexCollider {
+  public:
+	typedef unsigned int (*CollideFunction)(ConvexCore const& core1, ConvexCore const& core2, std::vector<Contact>& contacts);
+	typedef bool (*RaycastFunction)(ConvexCore const& core, glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance,
+	                                glm::vec3& normal);
+
+	static unsigned int collide(ConvexCore const& core1, ConvexCore const& core2, std::vector<Contact>& contacts);
+	static unsigned int collideSpheres(ConvexCore const& sphere1, ConvexCore const& sphere2, std::vector<Contact>& contacts);
+	static unsigned int collideSphereCapsule(ConvexCore const& sphere, ConvexCore const& capsule, std::vector<Contact>& contacts);
+	static unsigned int collideCapsules(ConvexCore const& capsule1, ConvexCore const& capsule2, std::vector<Contact>& contacts);
+	static unsigned int collideConvex(ConvexCore const& core1, ConvexCore const& core2, std::vector<Contact>& contacts);
+	static unsigned int collideHeightfield(ConvexCore const& core, ConvexCore const& heightfield, std::vector<Contact>& contacts);
+
+	// Points les plus proches des deux noyaux (GJK), faux s'ils se recouvrent
+	static bool closestPoints(ConvexCore const& core1, ConvexCore const& core2, glm::vec3& point1, glm::vec3& point2);
+
+	// Premier impact d'un rayon sur le volume, direction normée, impact à origin + distance . direction.
+	// Comme pour les collisions, le type choisit la fonction dans une table : aucun appel virtuel par rayon
+	static bool raycast(ConvexCore const& core, glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance,
+	                    glm::vec3& normal);
+	static bool raycastSphere(ConvexCore const& sphere, glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance,
+	                          glm::vec3& normal);
+	static bool raycastCapsule(ConvexCore const& capsule, glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance,
+	                           glm::vec3& normal);
+	static bool raycastBox(ConvexCore const& box, glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance,
+	                       glm::vec3& normal);
+	static bool raycastHeightfield(ConvexCore const& heightfield, glm::vec3 origin, glm::vec3 direction, float maxDistance,
+	                               float& distance, glm::vec3& normal);
+	// Avance conservative le long du rayon, pour les volumes sans lancer de rayon analytique
+	static bool raycastConvex(ConvexCore const& core, glm::vec3 origin, glm::vec3 direction, float maxDistance, float& distance,
+	                          glm::vec3& normal);
+};
+
+const unsigned int NO_SPHERE = 0xffffffff;  // proxy sans sphère dans le lot
+
+// Phase étroite par lots entre sphères : centres et rayons rangés en structure of arrays,
+// paires testées 8 par 8 (AVX2) ou 4 par 4 (SSE) selon les options de compilation.
+// Seules les paires en contact sont détaillées, la plupart des paires de la phase large étant séparées.
+class SphereBatch {
+  private:
+	std::vector<float>        m_x;
+	std::vector<float>        m_y;
+	std::vector<float>        m_z;
+	std::vector<float>        m_radii;
+	std::vector<unsigned int> m_proxies;  // proxy de la phase large de chaque sphère
+	std::vector<unsigned int> m_pairs1;   // indices de sphères
+	std::vector<unsigned int> m_pairs2;
+
+  public:
+	SphereBatch();
+
+	void         clear();
+	unsigned int addSphere(glm::vec3 center, float radius, unsigned int proxy);
+	void         addPair(unsigned int sphere1, unsigned int sphere2);
+	unsigned int getNbrSpheres() const;
+	unsigned int getProxy(unsigned int sphere) const;
+	unsigned int getNbrPairs() const;
+	unsigned int collide(std::vector<Contact>& contacts) const;  // ajoute les contacts trouvés, renvoie leur nombre
+
+	// Noyau sur tableaux bruts, dont la seule allocation est l'ajout des contacts trouvés.
+	// Les contacts reçoivent les indices de sphères si proxies est nul
+	static unsigned int collide(const float* x, const float* y, const float* z, const float* radii, const unsigned int* pairs1,
+	                            const unsigned int* pairs2, unsigned int nbrPairs, const unsigned int* proxies,
+	                            std::vector<Contact>& contacts);
+
+	~SphereBatch();
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+
+/* --- THREADPOOL --- */
+
+
+
+ThreadPool::ThreadPool(unsigned int nbrThreads)
+    : m_workers(vector<thread>()),
+      m_ranges(new WorkRange[max(nbrThreads, 1u)]),
+      m_task(nullptr),
+      m_busyWorkers(0),
+      m_generation(0),
+      m_stop(false),
+      m_exception(nullptr) {
+	for (unsigned int i = 0; i < max(nbrThreads, 1u); i++) {
+		m_ranges[i].range = 0;
+	}
+
+	// Le thread appelant compte pour un
+	for (unsigned int i = 1; i < nbrThreads; i++) {
+		m_workers.push_back(thread(&ThreadPool::work, this, i));
+	}
+}
+
+unsigned int ThreadPool::getNbrThreads() const { return m_workers.size() + 1; }
+
+static uint64_t packRange(unsigned int begin, unsigned int end) { return ((uint64_t)end << 32) | begin; }
+
+// Une tâche prise au début de sa propre tranche
+bool ThreadPool::popTask(unsigned int thread, unsigned int& task) {
+	uint64_t range = m_ranges[thread].range.load();
+	while (true) {
+		unsigned int begin = range & 0xffffffff;
+		unsigned int end = range >> 32;
+		if (begin >= end) {
+			return false;
+		}
+		if (m_ranges[thread].range.compare_exchange_weak(range, packRange(begin + 1, end))) {
+			task = begin;
+			return true;
+		}
+	}
+}
+
+// Les autres threads sont visités dans le même ordre depuis le suivant : la moitié haute de la première tranche non vide
+// devient la tranche du voleur
+bool ThreadPool::stealTasks(unsigned int thread) {
+	unsigned int nbrThreads = this->getNbrThreads();
+	for (unsigned int i = 1; i < nbrThreads; i++) {
+		WorkRange& victim = m_ranges[(thread + i) % nbrThreads];
+		uint64_t   range = victim.range.load();
+		while (true) {
+			unsigned int begin = range & 0xffffffff;
+			unsigned int end = range >> 32;
+			if (begin >= end) {
+				break;
+			}
+			unsigned int middle = begin + (end - begin) / 2;
+			if (victim.range.compare_exchange_weak(range, packRange(begin, middle))) {
+				m_ranges[thread].range = packRange(middle, end);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Les tâches ne créant pas de tâches, un thread qui ne trouve plus rien à voler a terminé.
+// Une exception ne doit pas quitter le thread : l'appelant attendrait sans fin un travailleur disparu
+void ThreadPool::runTasks(unsigned int thread) {
+	unsigned int task;
+	do {
+		while (this->popTask(thread, task)) {
+			try {
+				(*m_task)(task);
+			} catch (...) {
+				unique_lock<mutex> lock(m_mutex);
+				if (m_exception == nullptr) {
+					m_exception = current_exception();
+				}
+			}
+		}
+	} while (this->stealTasks(thread));
+}
+
+void ThreadPool::work(unsigned int thread) {
+	unsigned int generation = 0;
+	while (true) {
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_wakeUp.wait(lock, [&] { return m_stop || m_generation != generation; });
+			if (m_stop) {
+				return;
+			}
+			generation = m_generation;
+		}
+
+		this->runTasks(thread);
+
+		unique_lock<mutex> lock(m_mutex);
+		if (--m_busyWorkers == 0) {
+			m_finished.notify_one();
+		}
+	}
+}
+
+// Exécute task(0) ... task(count - 1) sur tous les threads et attend la fin de toutes les tâches
+void ThreadPool::parallelFor(unsigned int count, function<void(unsigned int)> task) {
+	if (m_workers.empty() || count <= 1) {
+		for (unsigned int i = 0; i < count; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	{
+		unique_lock<mutex> lock(m_mutex);
+		unsigned int       nbrThreads = this->getNbrThreads();
+		for (unsigned int i = 0; i < nbrThreads; i++) {
+			m_ranges[i].range = packRange((uint64_t)count * i / nbrThreads, (uint64_t)count * (i + 1) / nbrThreads);
+		}
+		m_task = &task;
+		m_busyWorkers = m_workers.size();
+		m_generation++;
+	}
+	m_wakeUp.notify_all();
+
+	this->runTasks(0);
+
+	unique_lock<mutex> lock(m_mutex);
+	m_finished.wait(lock, [&] { return m_busyWorkers == 0; });
+	m_task = nullptr;
+
+	// Toutes les tâches ont été tentées, task n'est plus utilisée par aucun thread
+	exception_ptr exception = m_exception;
+	m_exception = nullptr;
+	lock.unlock();
+	if (exception != nullptr) {
+		rethrow_exception(exception);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		unique_lock<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wakeUp.notify_all();
+	for (thread& worker : m_workers) {
+		worker.join();
+	}
+	delete[] m_ranges;
+}
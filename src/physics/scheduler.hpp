@@ -0,0 +1,50 @@
+#ifndef PHYSICS_SCHEDULER
+#define PHYSICS_SCHEDULER
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tranche d'indices [début, fin) d'un thread, les deux bornes dans un seul mot pour être modifiées ensemble :
+// le propriétaire avance le début, un voleur prend la seconde moitié en abaissant la fin
+struct alignas(64) WorkRange {
+	std::atomic<uint64_t> range;  // fin << 32 | début
+};
+
+// Groupe de threads réutilisés d'un pas à l'autre : le thread appelant participe aussi au travail.
+// Vol de tâches : chaque thread reçoit une tranche contiguë des indices et la consomme par le début,
+// un thread sans travail vole la moitié de la tranche restante d'un autre. Les tâches étant indépendantes,
+// le résultat ne dépend ni du nombre de threads ni de l'ordre d'exécution.
+class ThreadPool {
+  private:
+	std::vector<std::thread>           m_workers;
+	WorkRange*                         m_ranges;  // une par thread, l'appelant en premier
+	std::mutex                         m_mutex;
+	std::condition_variable            m_wakeUp;
+	std::condition_variable            m_finished;
+	std::function<void(unsigned int)>* m_task;
+	unsigned int                       m_busyWorkers;
+	unsigned int                       m_generation;
+	bool                               m_stop;
+	std::exception_ptr                 m_exception;  // première exception levée par une tâche, relancée par parallelFor
+
+	void work(unsigned int thread);
+	void runTasks(unsigned int thread);
+	bool popTask(unsigned int thread, unsigned int& task);
+	bool stealTasks(unsigned int thread);
+
+  public:
+	ThreadPool(unsigned int nbrThreads = std::thread::hardware_concurrency());
+
+	unsigned int getNbrThreads() const;
+	void         parallelFor(unsigned int count, std::function<void(unsigned int)> task);  // relance l'exception d'une tâche
+
+	~ThreadPool();
+};
+
+#endif
@@ -0,0 +1,282 @@
+#include "solver.hpp"
+#include "main.hpp"
+#include "broadphase.hpp"
+#include "narrowphase.hpp"
+#include "../maths/utils.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+
+
+/* --- CONTACTSOLVER --- */
+
+
+
+ContactSolver::ContactSolver(float baumgarte, float slop, float restitutionThreshold, float matchDistance)
+    : m_manifolds(vector<ContactManifold>()),
+      m_newManifolds(vector<ContactManifold>()),
+      m_order(vector<unsigned int>()),
+      m_baumgarte(baumgarte),
+      m_slop(slop),
+      m_restitutionThreshold(restitutionThreshold),
+      m_matchDistance(matchDistance) {}
+
+vector<ContactManifold>& ContactSolver::getManifolds() { return m_manifolds; }
+float                    ContactSolver::getBaumgarte() const { return m_baumgarte; }
+float                    ContactSolver::getSlop() const { return m_slop; }
+
+ContactSolver& ContactSolver::setBaumgarte(float baumgarte) {
+	m_baumgarte = baumgarte;
+	return *this;
+}
+
+ContactSolver& ContactSolver::setSlop(float slop) {
+	m_slop = slop;
+	return *this;
+}
+
+// Ordre des manifolds : par premier puis second proxy
+static bool isBefore(ContactManifold const& manifold, unsigned int proxy1, unsigned int proxy2) {
+	return manifold.proxy1 != proxy1 ? manifold.proxy1 < proxy1 : manifold.proxy2 < proxy2;
+}
+
+static glm::vec3 getWorldInertiaCenter(BodyStore& store, unsigned int body) {
+	return store.getPositions()[body] + quaternionRotate(store.getOrientations()[body], store.getInertiaCenters()[body]);
+}
+
+// Base orthonormée du plan tangent, ne dépendant que de la normale : les impulsions de frottement restent comparables d'un pas à l'autre
+static void computeTangents(glm::vec3 normal, glm::vec3& tangent1, glm::vec3& tangent2) {
+	if (abs(normal.x) >= 0.57735f) {
+		tangent1 = glm::normalize(glm::vec3(normal.y, -normal.x, 0));
+	} else {
+		tangent1 = glm::normalize(glm::vec3(0, normal.z, -normal.y));
+	}
+	tangent2 = glm::cross(normal, tangent1);
+}
+
+// Vitesse d'un point du solide repéré par son bras depuis le centre d'inertie
+static glm::vec3 getVelocityAt(BodyStore& store, unsigned int body, glm::vec3 arm) {
+	glm::vec3 angularSpeed = store.getWorldInverseInertias()[body] * store.getAngularMomenta()[body];
+	return store.getVelocities()[body] + glm::cross(angularSpeed, arm);
+}
+
+// Un solide bloqué peut être touché par plusieurs îles résolues en parallèle : il n'est jamais écrit
+static void applyImpulse(BodyStore& store, unsigned int body, glm::vec3 impulse, glm::vec3 arm) {
+	if (store.getInverseMasses()[body] > 0) {
+		store.getVelocities()[body] += impulse * store.getInverseMasses()[body];
+		store.getAngularMomenta()[body] += glm::cross(arm, impulse);  // dL = r ^ P
+	}
+}
+
+// 1 / (1/m1 + 1/m2 + ((I1-1 (r1 ^ d)) ^ r1 + (I2-1 (r2 ^ d)) ^ r2) . d)
+static float getEffectiveMass(BodyStore& store, unsigned int body1, unsigned int body2, glm::vec3 arm1, glm::vec3 arm2,
+                              glm::vec3 direction) {
+	glm::vec3 angular1 = glm::cross(store.getWorldInverseInertias()[body1] * glm::cross(arm1, direction), arm1);
+	glm::vec3 angular2 = glm::cross(store.getWorldInverseInertias()[body2] * glm::cross(arm2, direction), arm2);
+	float     inverseMass = store.getInverseMasses()[body1] + store.getInverseMasses()[body2] + glm::dot(angular1 + angular2, direction);
+	return inverseMass > 0 ? 1 / inverseMass : 0;
+}
+
+// Regroupe les contacts de la phase étroite par paire et reprend les impulsions des points déjà connus.
+// L'ordre et les nouveaux manifolds sont construits dans des tableaux membres dont la capacité sert d'un pas à l'autre ;
+// départager par indice rend sort aussi reproductible que stable_sort, sans son tampon temporaire
+void ContactSolver::update(vector<Contact> const& contacts, SweepAndPrune& broadPhase, BodyStore& store) {
+	m_order.resize(contacts.size());
+	for (unsigned int i = 0; i < m_order.size(); i++) {
+		m_order[i] = i;
+	}
+	sort(m_order.begin(), m_order.end(), [&](unsigned int a, unsigned int b) {
+		Contact const& contact1 = contacts[a];
+		Contact const& contact2 = contacts[b];
+		if (contact1.proxy1 != contact2.proxy1) {
+			return contact1.proxy1 < contact2.proxy1;
+		}
+		if (contact1.proxy2 != contact2.proxy2) {
+			return contact1.proxy2 < contact2.proxy2;
+		}
+		if (contact1.depth != contact2.depth) {
+			return contact1.depth > contact2.depth;  // les plus profonds d'abord
+		}
+		return a < b;
+	});
+
+	vector<BroadPhaseProxy>& proxies = broadPhase.getProxies();
+	unsigned int             old = 0;
+
+	m_newManifolds.clear();
+
+	for (unsigned int i = 0; i < m_order.size();) {
+		Contact const& first = contacts[m_order[i]];
+
+		// Ancien manifold de la même paire, les deux listes étant triées
+		while (old < m_manifolds.size() && isBefore(m_manifolds[old], first.proxy1, first.proxy2)) {
+			old++;
+		}
+		ContactManifold const* previous = nullptr;
+		if (old < m_manifolds.size() && m_manifolds[old].proxy1 == first.proxy1 && m_manifolds[old].proxy2 == first.proxy2) {
+			previous = &m_manifolds[old];
+		}
+
+		BroadPhaseProxy const& proxy1 = proxies[first.proxy1];
+		BroadPhaseProxy const& proxy2 = proxies[first.proxy2];
+
+		ContactManifold manifold;
+		manifold.proxy1 = first.proxy1;
+		manifold.proxy2 = first.proxy2;
+		manifold.worldObject1 = proxy1.worldObject;
+		manifold.worldObject2 = proxy2.worldObject;
+		manifold.body1 = proxy1.worldObject->getIndex();
+		manifold.body2 = proxy2.worldObject->getIndex();
+		manifold.friction = sqrt(proxy1.boundingBox->getSliding() * proxy2.boundingBox->getSliding());
+		manifold.restitution = max(proxy1.boundingBox->getRestitutionCoef(), proxy2.boundingBox->getRestitutionCoef());
+		manifold.nbrPoints = 0;
+
+		for (; i < m_order.size() && contacts[m_order[i]].proxy1 == first.proxy1 && contacts[m_order[i]].proxy2 == first.proxy2; i++) {
+			if (manifold.nbrPoints == MAX_MANIFOLD_POINTS) {
+				continue;
+			}
+			Contact const& contact = contacts[m_order[i]];
+			ContactPoint&  point = manifold.points[manifold.nbrPoints++];
+
+			glm::vec4 orientation1 = store.getOrientations()[manifold.body1];
+			glm::vec4 orientation2 = store.getOrientations()[manifold.body2];
+			glm::vec4 conjugate1(-orientation1.x, -orientation1.y, -orientation1.z, orientation1.w);
+			glm::vec4 conjugate2(-orientation2.x, -orientation2.y, -orientation2.z, orientation2.w);
+
+			point.localPoint1 = quaternionRotate(conjugate1, contact.point1 - store.getPositions()[manifold.body1]);
+			point.localPoint2 = quaternionRotate(conjugate2, contact.point2 - store.getPositions()[manifold.body2]);
+			point.normal = contact.normal;
+			point.depth = contact.depth;
+			point.normalImpulse = 0;
+			point.tangentImpulse1 = 0;
+			point.tangentImpulse2 = 0;
+
+			if (previous) {
+				for (unsigned int j = 0; j < previous->nbrPoints; j++) {
+					if (glm::length(previous->points[j].localPoint1 - point.localPoint1) < m_matchDistance) {
+						point.normalImpulse = previous->points[j].normalImpulse;
+						point.tangentImpulse1 = previous->points[j].tangentImpulse1;
+						point.tangentImpulse2 = previous->points[j].tangentImpulse2;
+						break;
+					}
+				}
+			}
+		}
+
+		m_newManifolds.push_back(manifold);
+	}
+
+	m_manifolds.swap(m_newManifolds);
+}
+
+ContactManifold& ContactSolver::getManifold(unsigned int const* manifolds, unsigned int i) {
+	return manifolds ? m_manifolds[manifolds[i]] : m_manifolds[i];
+}
+
+void ContactSolver::prepare(BodyStore& store, double deltaTime, unsigned int const* manifolds, unsigned int begin, unsigned int end) {
+	float dt = (float)deltaTime;
+	end = manifolds ? end : min<unsigned int>(end, m_manifolds.size());
+
+	// Les forces extérieures des objets en contact passent dans leurs vitesses avant la résolution,
+	// sinon le solveur ne verrait pas, par exemple, le poids qui appuie sur le sol
+	for (unsigned int m = begin; m < end; m++) {
+		ContactManifold& manifold = this->getManifold(manifolds, m);
+		store.applyForces(manifold.body1, deltaTime);
+		store.applyForces(manifold.body2, deltaTime);
+	}
+
+	for (unsigned int m = begin; m < end; m++) {
+		ContactManifold& manifold = this->getManifold(manifolds, m);
+		unsigned int body1 = manifold.body1;
+		unsigned int body2 = manifold.body2;
+		glm::vec3    center1 = getWorldInertiaCenter(store, body1);
+		glm::vec3    center2 = getWorldInertiaCenter(store, body2);
+
+		for (unsigned int i = 0; i < manifold.nbrPoints; i++) {
+			ContactPoint& point = manifold.points[i];
+			glm::vec3     point1 = store.getPositions()[body1] + quaternionRotate(store.getOrientations()[body1], point.localPoint1);
+			glm::vec3     point2 = store.getPositions()[body2] + quaternionRotate(store.getOrientations()[body2], point.localPoint2);
+			glm::vec3     middle = (point1 + point2) / 2.0f;
+
+			point.arm1 = middle - center1;
+			point.arm2 = middle - center2;
+			computeTangents(point.normal, point.tangent1, point.tangent2);
+			point.normalMass = getEffectiveMass(store, body1, body2, point.arm1, point.arm2, point.normal);
+			point.tangentMass1 = getEffectiveMass(store, body1, body2, point.arm1, point.arm2, point.tangent1);
+			point.tangentMass2 = getEffectiveMass(store, body1, body2, point.arm1, point.arm2, point.tangent2);
+
+			// Baumgarte : une fraction de l'interpénétration est rattrapée à chaque pas
+			point.bias = m_baumgarte / dt * max(point.depth - m_slop, 0.0f);
+
+			float normalSpeed = glm::dot(getVelocityAt(store, body2, point.arm2) - getVelocityAt(store, body1, point.arm1), point.normal);
+			if (normalSpeed < -m_restitutionThreshold) {
+				point.bias = max(point.bias, -manifold.restitution * normalSpeed);
+			}
+		}
+	}
+}
+
+// Réapplique les impulsions du pas précédent : le solveur part d'une solution presque juste et converge en peu d'itérations
+void ContactSolver::warmStart(BodyStore& store, unsigned int const* manifolds, unsigned int begin, unsigned int end) {
+	end = manifolds ? end : min<unsigned int>(end, m_manifolds.size());
+	for (unsigned int m = begin; m < end; m++) {
+		ContactManifold& manifold = this->getManifold(manifolds, m);
+		for (unsigned int i = 0; i < manifold.nbrPoints; i++) {
+			ContactPoint& point = manifold.points[i];
+			glm::vec3     impulse = point.normal * point.normalImpulse;
+			impulse += point.tangent1 * point.tangentImpulse1 + point.tangent2 * point.tangentImpulse2;
+			applyImpulse(store, manifold.body1, -impulse, point.arm1);
+			applyImpulse(store, manifold.body2, impulse, point.arm2);
+		}
+	}
+}
+
+// Une itération de Gauss-Seidel projeté : chaque impulsion accumulée est bornée (contact >= 0, frottement dans le cône de Coulomb)
+void ContactSolver::solveVelocities(BodyStore& store, unsigned int const* manifolds, unsigned int begin, unsigned int end) {
+	end = manifolds ? end : min<unsigned int>(end, m_manifolds.size());
+	for (unsigned int m = begin; m < end; m++) {
+		ContactManifold& manifold = this->getManifold(manifolds, m);
+		unsigned int     body1 = manifold.body1;
+		unsigned int     body2 = manifold.body2;
+
+		for (unsigned int i = 0; i < manifold.nbrPoints; i++) {
+			ContactPoint& point = manifold.points[i];
+
+			// Frottement, borné par l'impulsion normale courante
+			float maxFriction = manifold.friction * point.normalImpulse;
+			for (unsigned int axis = 0; axis < 2; axis++) {
+				glm::vec3 tangent = axis == 0 ? point.tangent1 : point.tangent2;
+				float&    accumulated = axis == 0 ? point.tangentImpulse1 : point.tangentImpulse2;
+				float     mass = axis == 0 ? point.tangentMass1 : point.tangentMass2;
+
+				glm::vec3 relativeSpeed = getVelocityAt(store, body2, point.arm2) - getVelocityAt(store, body1, point.arm1);
+				float     lambda = -mass * glm::dot(relativeSpeed, tangent);
+				float     newImpulse = glm::clamp(accumulated + lambda, -maxFriction, maxFriction);
+				glm::vec3 impulse = tangent * (newImpulse - accumulated);
+				accumulated = newImpulse;
+
+				applyImpulse(store, body1, -impulse, point.arm1);
+				applyImpulse(store, body2, impulse, point.arm2);
+			}
+
+			// Contact : les objets ne peuvent que se repousser
+			glm::vec3 relativeSpeed = getVelocityAt(store, body2, point.arm2) - getVelocityAt(store, body1, point.arm1);
+			float     lambda = point.normalMass * (point.bias - glm::dot(relativeSpeed, point.normal));
+			float     newImpulse = max(point.normalImpulse + lambda, 0.0f);
+			glm::vec3 impulse = point.normal * (newImpulse - point.normalImpulse);
+			point.normalImpulse = newImpulse;
+
+			applyImpulse(store, body1, -impulse, point.arm1);
+			applyImpulse(store, body2, impulse, point.arm2);
+		}
+	}
+}
+
+void ContactSolver::clear() { m_manifolds.clear(); }
+
+ContactSolver::~ContactSolver() {}
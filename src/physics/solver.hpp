@@ -0,0 +1,84 @@
+#ifndef PHYSICS_SOLVER
+#define PHYSICS_SOLVER
+
+#include "narrowphase.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+class BodyStore;
+class BoundingBox;
+class SweepAndPrune;
+class WorldObject;
+
+const unsigned int MAX_MANIFOLD_POINTS = 4;
+
+// Point de contact persistant : les impulsions accumulées servent de point de départ au pas suivant (warm starting)
+struct ContactPoint {
+	glm::vec3 localPoint1;  // repère local du premier objet, pour retrouver le point d'un pas à l'autre
+	glm::vec3 localPoint2;
+	glm::vec3 normal;       // du premier vers le second objet
+	float     depth;
+	float     normalImpulse;
+	float     tangentImpulse1;
+	float     tangentImpulse2;
+
+	// Recalculés à chaque pas par ContactSolver::prepare
+	glm::vec3 arm1;  // du centre d'inertie au point de contact, repère monde
+	glm::vec3 arm2;
+	glm::vec3 tangent1;
+	glm::vec3 tangent2;
+	float     normalMass;
+	float     tangentMass1;
+	float     tangentMass2;
+	float     bias;  // vitesse de séparation visée : correction de l'interpénétration et rebond
+};
+
+// Ensemble des points de contact entre deux volumes
+struct ContactManifold {
+	unsigned int proxy1;
+	unsigned int proxy2;
+	WorldObject* worldObject1;
+	WorldObject* worldObject2;
+	unsigned int body1;  // indices dans le BodyStore au pas courant
+	unsigned int body2;
+	float        friction;
+	float        restitution;
+	ContactPoint points[MAX_MANIFOLD_POINTS];
+	unsigned int nbrPoints;
+};
+
+// Solveur de contacts par impulsions séquentielles (Gauss-Seidel projeté) avec frottement de Coulomb.
+// Le Planet appelle prepare, warmStart puis solveVelocities autant de fois que d'itérations voulues.
+class ContactSolver {
+  private:
+	std::vector<ContactManifold> m_manifolds;             // triés par paire de proxies
+	std::vector<ContactManifold> m_newManifolds;          // construits par update, échangés avec m_manifolds
+	std::vector<unsigned int>    m_order;                 // contacts triés par paire, gardé d'un pas à l'autre
+	float                        m_baumgarte;             // part de l'interpénétration corrigée à chaque pas
+	float                        m_slop;                  // interpénétration tolérée, évite les tremblements
+	float                        m_restitutionThreshold;  // vitesse d'impact en dessous de laquelle on ne rebondit pas
+	float                        m_matchDistance;         // distance sous laquelle un nouveau point prolonge un ancien
+
+	ContactManifold& getManifold(unsigned int const* manifolds, unsigned int i);
+
+  public:
+	ContactSolver(float baumgarte = 0.2, float slop = 0.005, float restitutionThreshold = 1, float matchDistance = 0.05);
+
+	std::vector<ContactManifold>& getManifolds();
+	float                         getBaumgarte() const;
+	ContactSolver&                setBaumgarte(float baumgarte);
+	float                         getSlop() const;
+	ContactSolver&                setSlop(float slop);
+
+	void update(std::vector<Contact> const& contacts, SweepAndPrune& broadPhase, BodyStore& store);  // contacts triés par paire
+	// Manifolds manifolds[begin, end) (une île), ou manifolds d'indices [begin, end) si manifolds est nul
+	void prepare(BodyStore& store, double deltaTime, unsigned int const* manifolds = nullptr, unsigned int begin = 0,
+	             unsigned int end = 0xffffffff);
+	void warmStart(BodyStore& store, unsigned int const* manifolds = nullptr, unsigned int begin = 0, unsigned int end = 0xffffffff);
+	void solveVelocities(BodyStore& store, unsigned int const* manifolds = nullptr, unsigned int begin = 0, unsigned int end = 0xffffffff);
+	void clear();
+
+	~ContactSolver();
+};
+
+#endif
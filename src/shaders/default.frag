@@ -1,18 +1,26 @@
 #version 330 core
 
-#define MAX_LIGHT 16
+#define MAX_LIGHT 128
 
 in vec3  trueCoord;
 in vec3  normal;
 out vec4 FragColor;
 
-uniform vec3  lightPositions[MAX_LIGHT];
-uniform float lightIntensities[MAX_LIGHT];
-uniform vec3  lightColors[MAX_LIGHT];
-uniform float lightAmbients[MAX_LIGHT];
+struct Light {
+	vec4 positionAmbient;  // xyz : position, w : 1 si lumière ambiante
+	vec4 colorIntensity;   // rgb : couleur, a : intensité
+};
 
-uniform vec3 cameraPos;
-uniform uint nbrLights;
+layout(std140) uniform Camera {
+	mat4 view;
+	mat4 projection;
+	vec4 cameraPos;
+};
+
+layout(std140) uniform Lights {
+	uint  nbrLights;
+	Light lights[MAX_LIGHT];
+};
 
 uniform vec4  objectColor;
 uniform float objectMetalness;
@@ -28,7 +36,7 @@ void main() {
 	float intensity = 0;
 	vec3  lightColor = vec3(0, 0, 0);
 
-	vec3 cameraRay = normalize(trueCoord - cameraPos);
+	vec3 cameraRay = normalize(trueCoord - cameraPos.xyz);
 
 	bool behind;
 	if (dot(cameraRay, normal) > 0) {
@@ -40,14 +48,18 @@ void main() {
 	int   i;
 	float diffusedLight;
 	for (i = 0; i < int(nbrLights); i++) {
+		vec3  lightPosition = lights[i].positionAmbient.xyz;
+		vec3  thisLightColor = lights[i].colorIntensity.rgb;
+		float lightIntensity = lights[i].colorIntensity.a;
+
 		if (!behind) {
-			lightColor += lightColors[i] * lightIntensities[i];
+			lightColor += thisLightColor * lightIntensity;
 		}
 
-		if (lightAmbients[i] > 0) {
-			intensity += lightIntensities[i] / objectMetalness;
+		if (lights[i].positionAmbient.w > 0) {
+			intensity += lightIntensity / objectMetalness;
 		} else {
-			vec3 incidentRay = trueCoord - lightPositions[i];
+			vec3 incidentRay = trueCoord - lightPosition;
 			float distance = length(incidentRay);
 			incidentRay = normalize(incidentRay);
 			vec3 reflectedRay = reflect(incidentRay, normal);
@@ -55,7 +67,7 @@ void main() {
 			diffusedLight = max(dot(normal, -incidentRay), 0.);
 			if (diffusedLight > 0 && !behind) {
 				float reflectedLight = pow(max(dot(cameraRay, -reflectedRay), 0.), 5. * objectMetalness);
-				intensity += (diffusedLight / objectMetalness + reflectedLight * objectMetalness) * lightIntensities[i] * 0.4 / distance;
+				intensity += (diffusedLight / objectMetalness + reflectedLight * objectMetalness) * lightIntensity * 0.4 / distance;
 			}
 		}
 	}
@@ -2,14 +2,17 @@
 
 layout(location = 0) in vec3 coordinates;
 layout(location = 1) in vec3 normalVector;
+layout(location = 2) in mat4 model;     // par instance
+layout(location = 6) in mat4 rotation;  // par instance
 
 out vec3 trueCoord;
 out vec3 normal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform mat4 rotation;
+layout(std140) uniform Camera {
+	mat4 view;
+	mat4 projection;
+	vec4 cameraPos;
+};
 
 uniform int screenWidth;
 uniform int screenHeight;
@@ -1,8 +1,6 @@
 #define WIDTH 3100
 #define HEIGHT 1800
 
-#define MAX_LIGHT 16
-
 #include "main.hpp"
 #include "../opengl/main.hpp"
 #include "../maths/utils.hpp"
@@ -18,6 +16,8 @@
 #include <string>
 #include <fstream>
 #include <algorithm>
+#include <cstring>
+#include <cstddef>
 
 using namespace std;
 
@@ -28,15 +28,71 @@ using namespace std;
 
 
 
+static unsigned int nextGeometryId = 0;
+
 Geometry::Geometry(unsigned int vertexCount, GLfloat* vertices, unsigned int faceCount, GLuint* faces, GLfloat* normalVectors)
-    : m_vertexCount(vertexCount), m_vertices(vertices), m_faceCount(faceCount), m_faces(faces), m_normalVectors(normalVectors) {}
+    : m_vertexCount(vertexCount),
+      m_vertices(vertices),
+      m_faceCount(faceCount),
+      m_faces(faces),
+      m_normalVectors(normalVectors),
+      m_id(nextGeometryId++),
+      m_version(0) {}
 
 unsigned int Geometry::vertexCount() const { return m_vertexCount; }
 GLfloat*     Geometry::getVertices() const { return m_vertices; }
 unsigned int Geometry::faceCount() const { return m_faceCount; }
 GLuint*      Geometry::getFaces() const { return m_faces; }
 GLfloat*&    Geometry::getNormalVectors() { return m_normalVectors; }
+unsigned int Geometry::getId() const { return m_id; }
+unsigned int Geometry::getVersion() const { return m_version; }
+
+// À appeler après toute modification des sommets, faces ou normales pour forcer un nouvel envoi au GPU
+Geometry& Geometry::markDirty() {
+	m_version++;
+	m_verticesData.clear();
+	m_facesData.clear();
+	return *this;
+}
+
+// Les sommets sont dupliqués par face pour que chacun porte la normale de sa face
+vector<GLfloat> const& Geometry::getVerticesData() {
+	if (!m_verticesData.empty() || m_faceCount == 0) {
+		return m_verticesData;
+	}
+
+	m_verticesData.resize(m_faceCount * 18);  // 3 sommets * (position + normale)
+	unsigned int index = 0;
+
+	for (unsigned int i = 0; i < m_faceCount; i++) {
+		for (unsigned int j = 0; j < 3; j++) {
+			unsigned int vertexIndex = m_faces[i * 3 + j];
+			m_verticesData[index] = m_vertices[vertexIndex * 3];          // x
+			m_verticesData[index + 1] = m_vertices[vertexIndex * 3 + 1];  // y
+			m_verticesData[index + 2] = m_vertices[vertexIndex * 3 + 2];  // z
+
+			m_verticesData[index + 3] = m_normalVectors[i * 3];      // nx
+			m_verticesData[index + 4] = m_normalVectors[i * 3 + 1];  // ny
+			m_verticesData[index + 5] = m_normalVectors[i * 3 + 2];  // nz
+
+			index += 6;
+		}
+	}
+
+	return m_verticesData;
+}
 
+// Une variante d'indices par primitive : les matériaux qui dessinent de la même manière la partagent
+vector<GLuint> const& Geometry::getFacesData(Material const& material) {
+	vector<GLuint>& facesData = m_facesData[material.getPrimitive()];
+	if (facesData.empty()) {
+		material.fillFacesData(facesData, m_faceCount);
+	}
+	return facesData;
+}
+
+// Les buffers GPU de la géométrie ne sont pas libérés ici : le Renderer s'en charge à la première image qui ne la dessine plus,
+// et son identifiant ne sera jamais repris par une autre géométrie
 Geometry::~Geometry() {}
 
 
@@ -62,18 +118,18 @@ Material& Material::setMetalness(float metalness) {
 	return *this;
 }
 
-void Material::finalRender(unsigned int faceCount) const {
-	glDrawElements(GL_TRIANGLES, this->alterFaceCount(faceCount), GL_UNSIGNED_INT, 0);
+GLenum Material::getPrimitive() const { return GL_TRIANGLES; }
+
+void Material::finalRender(unsigned int faceCount, unsigned int instanceCount) const {
+	glDrawElementsInstanced(GL_TRIANGLES, this->alterFaceCount(faceCount), GL_UNSIGNED_INT, 0, instanceCount);
 }
 
-GLuint* Material::getFacesData(unsigned int faceCount) const {
-	GLuint* facesData = new GLuint[this->alterFaceCount(faceCount)];
+void Material::fillFacesData(vector<GLuint>& facesData, unsigned int faceCount) const {
+	facesData.resize(this->alterFaceCount(faceCount));
 
 	for (unsigned int i = 0; i < faceCount * 3; i++) {
 		facesData[i] = i;
 	}
-
-	return facesData;
 }
 
 unsigned int Material::alterFaceCount(unsigned int faceCount) const {
@@ -89,103 +145,104 @@ Material::~Material() {}
 
 
 
-Mesh::Mesh(Geometry& geometry, Material& material)
-    : m_geometry(geometry), m_material(material), m_rotation(UnitQuaternion()), m_translation(glm::vec3(0, 0, 0)), m_scale(1.0f) {}
+Mesh::Mesh(Geometry& geometry, Material& material) : Transform::Transform(), m_geometry(geometry), m_material(material) {}
 
-Geometry&       Mesh::getGeometry() { return m_geometry; }
-Material&       Mesh::getMaterial() { return m_material; }
-UnitQuaternion& Mesh::getRotation() { return m_rotation; }
-glm::vec3&      Mesh::getTranslation() { return m_translation; }
-glm::vec3&      Mesh::getScale() { return m_scale; }
+Geometry& Mesh::getGeometry() { return m_geometry; }
+Material& Mesh::getMaterial() { return m_material; }
 
-Mesh& Mesh::setRotation(UnitQuaternion& rotation) {
-	m_rotation = rotation;
-	return *this;
+unsigned int Mesh::faceCount() const { return m_material.alterFaceCount(m_geometry.faceCount()); }
+
+// alpha permet d'interpoler entre les deux derniers pas de la physique (voir Planet::getAlpha)
+glm::mat4 Mesh::getModelMatrix(float alpha) const {
+	UnitQuaternion rotation = this->getInterpolatedRotation(alpha);
+	glm::mat4      model = glm::mat4(1.0f);
+	model = glm::translate(model, this->getInterpolatedTranslation(alpha));
+	model = glm::rotate(model, rotation.getAngle(), rotation.getAxis());
+	model = glm::scale(model, m_scale);
+	return model;
 }
 
-Mesh& Mesh::setTranslation(glm::vec3& translation) {
-	m_translation = translation;
-	return *this;
+glm::mat4 Mesh::getRotationMatrix(float alpha) const {
+	UnitQuaternion rotation = this->getInterpolatedRotation(alpha);
+	return glm::rotate(glm::mat4(1.0f), rotation.getAngle(), rotation.getAxis());
 }
 
-GLfloat* Mesh::getVerticesData() const {
-	unsigned int nbrVectors = 2;  // Vertices + normales
-	GLfloat*     data = new GLfloat[m_geometry.faceCount() * 9 * nbrVectors];
+Mesh::~Mesh() {}
 
-	GLfloat* vertices = m_geometry.getVertices();
-	GLfloat* normalVectors = m_geometry.getNormalVectors();
-	GLuint*  faces = m_geometry.getFaces();
 
-	unsigned int index = 0;
 
-	for (unsigned int i = 0; i < m_geometry.faceCount(); i++) {
-		for (unsigned int j = 0; j < 3; j++) {
-			unsigned int vertexIndex = faces[i * 3 + j];
-			data[index] = vertices[vertexIndex * 3];          // x
-			data[index + 1] = vertices[vertexIndex * 3 + 1];  // y
-			data[index + 2] = vertices[vertexIndex * 3 + 2];  // z
+/* --- GEOMETRYBUFFER --- */
 
-			unsigned int normalIndex = i;
-			data[index + 3] = normalVectors[normalIndex * 3];      // nx
-			data[index + 4] = normalVectors[normalIndex * 3 + 1];  // ny
-			data[index + 5] = normalVectors[normalIndex * 3 + 2];  // nz
 
-			index += 6;
-		}
-	}
 
-	return data;
+GeometryBuffer::GeometryBuffer()
+    : m_VAO(),
+      m_VBO(),
+      m_EBO(),
+      m_instanceVBO(),
+      m_uploaded(false),
+      m_geometryId(0),
+      m_version(0),
+      m_faceCount(0),
+      m_instances(vector<glm::mat4>()) {}
+
+bool GeometryBuffer::isUpToDate(Geometry const& geometry) const {
+	return m_uploaded && m_geometryId == geometry.getId() && m_version == geometry.getVersion();
 }
 
-unsigned int Mesh::faceCount() const { return m_material.alterFaceCount(m_geometry.faceCount()); }
+void GeometryBuffer::upload(Mesh& mesh) {
+	Geometry&              geometry = mesh.getGeometry();
+	vector<GLfloat> const& verticesData = geometry.getVerticesData();
+	vector<GLuint> const&  facesData = geometry.getFacesData(mesh.getMaterial());
 
+	m_VAO.bind();
+	m_VBO.bind(verticesData.size(), verticesData.data());
+	m_EBO.bind(facesData.size(), facesData.data());
 
-Mesh& Mesh::translate(glm::vec3 translation) {
-	m_translation += translation;
-	return *this;
-}
+	// Les attributs sont mémorisés par le VAO, inutile de les redéfinir lors d'un nouvel envoi
+	if (!m_uploaded) {
+		m_EBO.addAttribute(0, 3, 0, 6);
+		m_EBO.addAttribute(1, 3, 3, 6);
 
-Mesh& Mesh::translate(float dx, float dy, float dz) {
-	this->translate(glm::vec3(dx, dy, dz));
-	return *this;
-}
+		// Matrices par instance : une mat4 occupe 4 attributs consécutifs (model : 2 à 5, rotation : 6 à 9)
+		m_instanceVBO.bind();
+		for (GLuint i = 0; i < 8; i++) {
+			m_EBO.addAttribute(2 + i, 4, i * 4, 32, GL_FLOAT, GL_FALSE, 1);
+		}
+	}
 
-Mesh& Mesh::rotateSelf(UnitQuaternion rotation, glm::vec3 point) {
-	m_rotation *= rotation;
-	m_translation += rotation.rotate(point) - point;
-	return *this;
-}
+	m_VAO.unBind();
+	m_VBO.unBind();
 
-Mesh& Mesh::rotateSelf(float angle, glm::vec3(axis), glm::vec3 point) {
-	this->rotateSelf(UnitQuaternion(angle, axis), point);
-	return *this;
+	m_uploaded = true;
+	m_geometryId = geometry.getId();
+	m_version = geometry.getVersion();
+	m_faceCount = geometry.faceCount();
 }
 
-Mesh& Mesh::rotateScene(UnitQuaternion rotation, glm::vec3 point) {
-	if (rotation.squaredLength() > 0.9) {
-		m_rotation = rotation * m_rotation;
-		m_translation += rotation.rotate(point) - point;
-	}
-	return *this;
-}
+unsigned int GeometryBuffer::getFaceCount() const { return m_faceCount; }
 
-Mesh& Mesh::rotateScene(float angle, glm::vec3(axis), glm::vec3 point) {
-	this->rotateScene(UnitQuaternion(angle, axis), point);
-	return *this;
+void GeometryBuffer::addInstance(Mesh const& mesh, float alpha) {
+	m_instances.push_back(mesh.getModelMatrix(alpha));
+	m_instances.push_back(mesh.getRotationMatrix(alpha));
 }
 
-glm::vec3 Mesh::transform(glm::vec3 point) const {
-	glm::vec3 newPoint = (m_rotation * point * m_rotation.getConjugate()).getVector() + m_translation;
-	return newPoint;
-}
+unsigned int GeometryBuffer::instanceCount() const { return m_instances.size() / 2; }
+
+void GeometryBuffer::bind() { m_VAO.bind(); }
 
-glm::vec3 Mesh::invertTransform(glm::vec3 point) const {
-	glm::vec3 newPoint = point - m_translation;
-	newPoint = (m_rotation.getConjugate() * newPoint * m_rotation).getVector();
-	return newPoint;
+// Le buffer est réalloué à chaque image pour ne pas attendre que le GPU ait fini de lire la précédente
+void GeometryBuffer::uploadInstances() {
+	m_instanceVBO.bind(m_instances.size() * 16, glm::value_ptr(m_instances[0]), GL_STREAM_DRAW);
+	m_instanceVBO.unBind();
 }
 
-Mesh::~Mesh() {}
+// La capacité est conservée : pas d'allocation d'une image à l'autre
+void GeometryBuffer::clearInstances() { m_instances.clear(); }
+
+void GeometryBuffer::unBind() { m_VAO.unBind(); }
+
+GeometryBuffer::~GeometryBuffer() {}
 
 
 
@@ -211,13 +268,22 @@ Light::~Light() {}
 
 
 
-Scene::Scene(glm::vec3 backgroundColor) : m_meshes(vector<Mesh*>()), m_lights(vector<Light*>()), m_backgroundColor(backgroundColor) {}
-Scene::Scene(float r, float g, float b) : m_meshes(vector<Mesh*>()), m_lights(vector<Light*>()), m_backgroundColor(glm::vec3(r, g, b)) {}
+Scene::Scene(glm::vec3 backgroundColor)
+    : m_meshes(vector<Mesh*>()), m_lights(vector<Light*>()), m_backgroundColor(backgroundColor), m_lightsVersion(0) {}
+Scene::Scene(float r, float g, float b)
+    : m_meshes(vector<Mesh*>()), m_lights(vector<Light*>()), m_backgroundColor(glm::vec3(r, g, b)), m_lightsVersion(0) {}
 
 vector<Mesh*>&  Scene::getMeshes() { return m_meshes; }
 glm::vec3&      Scene::getBackGroundColor() { return m_backgroundColor; }
 unsigned int    Scene::getNbrLights() const { return m_lights.size(); }
 vector<Light*>& Scene::getLights() { return m_lights; }
+unsigned int    Scene::getLightsVersion() const { return m_lightsVersion; }
+
+// À appeler après avoir modifié une lumière déjà ajoutée (position, intensité, couleur)
+Scene& Scene::markLightsDirty() {
+	m_lightsVersion++;
+	return *this;
+}
 
 Scene& Scene::setBackGroundColor(glm::vec3 backgroundColor) {
 	m_backgroundColor = backgroundColor;
@@ -247,6 +313,7 @@ Scene& Scene::remove(Mesh* mesh) {
 Scene& Scene::add(Light* light) {
 	if (std::find(m_lights.begin(), m_lights.end(), light) == m_lights.end()) {
 		m_lights.push_back(light);
+		m_lightsVersion++;
 	}
 	return *this;
 }
@@ -255,6 +322,7 @@ Scene& Scene::remove(Light* light) {
 	auto it = find(m_lights.begin(), m_lights.end(), light);
 	if (it != m_lights.end()) {
 		m_lights.erase(it);
+		m_lightsVersion++;
 	}
 	return *this;
 }
@@ -380,49 +448,95 @@ Camera::~Camera() {}
 
 
 Renderer::Renderer(Camera& camera, Scene& scene)
-    : m_camera(camera), m_scene(scene), m_shader(Shader("src/shaders/default.vert", "src/shaders/default.frag")) {
+    : m_camera(camera),
+      m_scene(scene),
+      m_shader(Shader("src/shaders/default.vert", "src/shaders/default.frag")),
+      m_cameraUBO(sizeof(CameraBlock), CAMERA_BINDING),
+      m_lightsUBO(sizeof(LightsBlock), LIGHTS_BINDING),
+      m_cameraBlock(),
+      m_lightsBlock(),
+      m_blocksUploaded(false),
+      m_lightsVersion(0) {
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LESS);
+
+	m_shader.bindUniformBlock("Camera", CAMERA_BINDING);
+	m_shader.bindUniformBlock("Lights", LIGHTS_BINDING);
+
+	m_screenWidthUniform = m_shader.getUniform<int>("screenWidth");
+	m_screenHeightUniform = m_shader.getUniform<int>("screenHeight");
+	m_objectColorUniform = m_shader.getUniform<glm::vec4>("objectColor");
+	m_objectMetalnessUniform = m_shader.getUniform<float>("objectMetalness");
+	m_shader.resetLookupCount();
+
+	// Les dimensions de l'écran ne changent pas : le programme les conserve
+	m_shader.use();
+	m_screenWidthUniform.set(WIDTH);
+	m_screenHeightUniform.set(HEIGHT);
 }
 
-void Renderer::initializeUniforms() {
-	m_shader.addUniform("screenWidth", WIDTH);
-	m_shader.addUniform("screenHeight", HEIGHT);
-	m_shader.addUniform("cameraPos", m_camera.getPosition());
+Shader& Renderer::getShader() { return m_shader; }
+
+void Renderer::updateUniformBlocks() {
+	// Caméra : quelques octets comparés à chaque image, envoyés seulement s'ils diffèrent
+	CameraBlock cameraBlock;
+	cameraBlock.view = glm::lookAt(m_camera.getPosition(), m_camera.getPosition() + m_camera.getDirection(), glm::vec3(0, 0, 1));
+	cameraBlock.projection = glm::perspective((float)glm::radians((float)m_camera.getFov()), (float)(WIDTH / HEIGHT), 0.1f, 100.0f);
+	cameraBlock.position = glm::vec4(m_camera.getPosition(), 1);
+
+	if (!m_blocksUploaded || memcmp(&cameraBlock, &m_cameraBlock, sizeof(CameraBlock)) != 0) {
+		m_cameraBlock = cameraBlock;
+		m_cameraUBO.update(0, sizeof(CameraBlock), &m_cameraBlock);
+	}
+
+	// Lumières : reconstruites uniquement lorsque la scène signale un changement
+	if (m_blocksUploaded && m_lightsVersion == m_scene.getLightsVersion()) {
+		return;
+	}
 
-	glm::mat4 view = glm::lookAt(m_camera.getPosition(), m_camera.getPosition() + m_camera.getDirection(), glm::vec3(0, 0, 1));
-	glm::mat4 projection = glm::perspective((float)glm::radians((float)m_camera.getFov()), (float)(WIDTH / HEIGHT), 0.1f, 100.0f);
-	m_shader.addUniform("view", view);
-	m_shader.addUniform("projection", projection);
+	vector<Light*>& lights = m_scene.getLights();
+	unsigned int    nbrLights = min((unsigned int)lights.size(), (unsigned int)MAX_LIGHT);
+	if (lights.size() > MAX_LIGHT) {
+		cerr << "Warning: only the first " << MAX_LIGHT << " lights of the scene are rendered" << endl;
+	}
 
+	m_lightsBlock.nbrLights = nbrLights;
+	for (unsigned int i = 0; i < nbrLights; i++) {
+		m_lightsBlock.lights[i].positionAmbient = glm::vec4(lights[i]->getPosition(), lights[i]->getAmbient() ? 1 : 0);
+		m_lightsBlock.lights[i].colorIntensity = glm::vec4(lights[i]->getColor(), lights[i]->getIntensity());
+	}
 
-	// Envoyer les lumières
-	m_shader.addUniform("nbrLights", m_scene.getNbrLights());
+	// Seules les lumières utilisées sont envoyées
+	unsigned int size = offsetof(LightsBlock, lights) + nbrLights * sizeof(LightBlock);
+	m_lightsUBO.update(0, size, &m_lightsBlock);
 
-	vector<Light*> lights = m_scene.getLights();
-	glm::vec3      positions[MAX_LIGHT];
-	GLfloat        intensities[MAX_LIGHT];
-	glm::vec3      colors[MAX_LIGHT];
-	float          ambients[MAX_LIGHT];
+	m_lightsVersion = m_scene.getLightsVersion();
+	m_blocksUploaded = true;
+}
+
+GeometryBuffer& Renderer::getBuffer(Mesh& mesh) {
+	pair<unsigned int, Material*> key(mesh.getGeometry().getId(), &mesh.getMaterial());
 
-	for (unsigned int i = 0; i < lights.size(); i++) {
-		positions[i] = lights[i]->getPosition();
-		intensities[i] = lights[i]->getIntensity();
-		colors[i] = lights[i]->getColor();
-		ambients[i] = lights[i]->getAmbient() ? 1 : 0;
+	auto it = m_buffers.find(key);
+	if (it == m_buffers.end()) {
+		it = m_buffers.emplace(key, new GeometryBuffer()).first;
 	}
 
-	for (unsigned int i = lights.size(); i < MAX_LIGHT; i++) {
-		positions[i] = glm::vec3(0, 0, 0);
-		intensities[i] = 0;
-		colors[i] = glm::vec3(1, 1, 1);
-		ambients[i] = false;
+	GeometryBuffer* buffer = it->second;
+	if (!buffer->isUpToDate(mesh.getGeometry())) {
+		buffer->upload(mesh);
 	}
 
-	m_shader.addUniform("lightPositions", positions, MAX_LIGHT);
-	m_shader.addUniform("lightIntensities", intensities, MAX_LIGHT);
-	m_shader.addUniform("lightColors", colors, MAX_LIGHT);
-	m_shader.addUniform("lightAmbients", ambients, MAX_LIGHT);
+	return *buffer;
+}
+
+// Libère tout de suite les buffers GPU, sans attendre une image qui ne dessine plus leurs géométries
+Renderer& Renderer::clearBuffers() {
+	for (auto& [key, buffer] : m_buffers) {
+		delete buffer;
+	}
+	m_buffers.clear();
+	return *this;
 }
 
 void Renderer::clearScreen() {
@@ -433,57 +547,42 @@ void Renderer::clearScreen() {
 
 
 // Script de rendu
-void Renderer::render() {
+// alpha : fraction de pas de physique écoulée depuis le dernier état simulé (1 : pas d'interpolation)
+void Renderer::render(float alpha) {
 	m_shader.use();
-	this->initializeUniforms();
+	this->updateUniformBlocks();
 	this->clearScreen();
 
+	// Regroupement des meshes par couple Geometry / Material
 	for (Mesh* mesh : m_scene.getMeshes()) {
-		// Récupérer les données nécessaires
-		Geometry& geometry = mesh->getGeometry();
-		Material& material = mesh->getMaterial();
-		GLfloat*  verticesData = mesh->getVerticesData();
-		GLuint*   facesData = material.getFacesData(geometry.faceCount());
-		glm::vec4 color = material.getMainColor();
-
-		// Envoi des uniform personnalisées à l'objet traité
-		glm::mat4 model = glm::mat4(1.0f);
-		model = glm::translate(model, mesh->getTranslation());
-		model = glm::rotate(model, mesh->getRotation().getAngle(), mesh->getRotation().getAxis());
-		model = glm::scale(model, mesh->getScale());
-		m_shader.addUniform("model", model);
-		glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), mesh->getRotation().getAngle(), mesh->getRotation().getAxis());
-		m_shader.addUniform("rotation", rotation);
-		m_shader.addUniform("objectColor", material.getMainColor());
-		m_shader.addUniform("objectMetalness", material.getMetalness());
-
-		// Création des objets OpenGL
-		VAO VAO;
-		VBO VBO;
-		EBO EBO;
-
-		unsigned int faceCount = mesh->faceCount();
-		VAO.bind();
-		VBO.bind(faceCount * 6, verticesData);
-		EBO.bind(faceCount, facesData);
-
-		EBO.addAttribute(0, 3, 0, 6);
-		EBO.addAttribute(1, 3, 3, 6);
+		this->getBuffer(*mesh).addInstance(*mesh, alpha);
+	}
 
-		// Rendu
-		material.finalRender(geometry.faceCount());
+	// Un appel de rendu par groupe. Un groupe qu'aucun mesh n'a dessiné à cette image est libéré avec ses buffers GPU :
+	// sa géométrie ou son matériau peut avoir été détruit
+	for (auto it = m_buffers.begin(); it != m_buffers.end();) {
+		GeometryBuffer* buffer = it->second;
+		unsigned int    instanceCount = buffer->instanceCount();
+		if (instanceCount == 0) {
+			delete buffer;
+			it = m_buffers.erase(it);
+			continue;
+		}
 
-		// Supprimer les données allouées
-		VAO.unBind();
-		VBO.unBind();
-		EBO.unBind();
+		Material* material = it->first.second;
+		m_objectColorUniform.set(material->getMainColor());
+		m_objectMetalnessUniform.set(material->getMetalness());
 
-		delete[] verticesData;
-		delete[] facesData;
+		buffer->bind();
+		buffer->uploadInstances();
+		material->finalRender(buffer->getFaceCount(), instanceCount);
+		buffer->unBind();
+		buffer->clearInstances();
+		it++;
 	}
 }
 
-Renderer::~Renderer() {}
+Renderer::~Renderer() { this->clearBuffers(); }
 
 
 
@@ -782,6 +881,63 @@ SphereGeometry::~SphereGeometry() {}
 
 
 
+/* --- HEIGHTMAPGEOMETRY --- */
+
+
+
+HeightMapGeometry::HeightMapGeometry(HeightMap const& heightMap) : Geometry::Geometry(0, nullptr, 0, nullptr, nullptr) {
+	this->update(heightMap);
+}
+
+// Deux triangles par case, dans l'ordre de HeightMap::getTriangles, chacun avec la normale de sa face
+HeightMapGeometry& HeightMapGeometry::update(HeightMap const& heightMap) {
+	unsigned int nbrX = heightMap.getNbrX();
+	unsigned int nbrZ = heightMap.getNbrZ();
+	m_gridVertices.resize(nbrX * nbrZ * 3);
+	for (unsigned int z = 0; z < nbrZ; z++) {
+		for (unsigned int x = 0; x < nbrX; x++) {
+			glm::vec3 vertex = heightMap.getVertex(x, z);
+			m_gridVertices[(z * nbrX + x) * 3] = vertex.x;
+			m_gridVertices[(z * nbrX + x) * 3 + 1] = vertex.y;
+			m_gridVertices[(z * nbrX + x) * 3 + 2] = vertex.z;
+		}
+	}
+
+	m_gridFaces.clear();
+	m_gridNormals.clear();
+	glm::vec3 vertices[6];
+	for (unsigned int z = 0; z + 1 < nbrZ; z++) {
+		for (unsigned int x = 0; x + 1 < nbrX; x++) {
+			GLuint a = z * nbrX + x;
+			GLuint b = a + 1;
+			GLuint c = a + nbrX;
+			GLuint d = c + 1;
+			GLuint faces[6] = {a, c, b, b, c, d};
+			m_gridFaces.insert(m_gridFaces.end(), faces, faces + 6);
+
+			heightMap.getTriangles(x, z, vertices);
+			for (unsigned int t = 0; t < 6; t += 3) {
+				glm::vec3 normal = glm::normalize(glm::cross(vertices[t + 1] - vertices[t], vertices[t + 2] - vertices[t]));
+				m_gridNormals.push_back(normal.x);
+				m_gridNormals.push_back(normal.y);
+				m_gridNormals.push_back(normal.z);
+			}
+		}
+	}
+
+	m_vertexCount = nbrX * nbrZ;
+	m_vertices = m_gridVertices.data();
+	m_faceCount = m_gridFaces.size() / 3;
+	m_faces = m_gridFaces.data();
+	m_normalVectors = m_gridNormals.data();
+	this->markDirty();
+	return *this;
+}
+
+HeightMapGeometry::~HeightMapGeometry() {}
+
+
+
 /* --- BASICMATERIAL --- */
 
 
@@ -800,12 +956,14 @@ LinesMaterial::LinesMaterial(glm::vec4 color, float metalness) : Material::Mater
 
 LinesMaterial::LinesMaterial(float r, float g, float b, float metalness) : Material::Material(r, g, b, 1, metalness) {}
 
-void LinesMaterial::finalRender(unsigned int faceCount) const {
-	glDrawElements(GL_LINES, this->alterFaceCount(faceCount), GL_UNSIGNED_INT, 0);
+GLenum LinesMaterial::getPrimitive() const { return GL_LINES; }
+
+void LinesMaterial::finalRender(unsigned int faceCount, unsigned int instanceCount) const {
+	glDrawElementsInstanced(GL_LINES, this->alterFaceCount(faceCount), GL_UNSIGNED_INT, 0, instanceCount);
 }
 
-GLuint* LinesMaterial::getFacesData(unsigned int faceCount) const {
-	GLuint* facesData = new GLuint[this->alterFaceCount(faceCount)];
+void LinesMaterial::fillFacesData(vector<GLuint>& facesData, unsigned int faceCount) const {
+	facesData.resize(this->alterFaceCount(faceCount));
 
 	for (unsigned int i = 0; i < faceCount; i++) {
 		facesData[i * 6 + 0] = i * 3;
@@ -815,8 +973,6 @@ GLuint* LinesMaterial::getFacesData(unsigned int faceCount) const {
 		facesData[i * 6 + 4] = i * 3 + 2;
 		facesData[i * 6 + 5] = i * 3;
 	}
-
-	return facesData;
 }
 
 unsigned int LinesMaterial::alterFaceCount(unsigned int faceCount) const { return faceCount * 6; }
@@ -847,8 +1003,10 @@ PointsMaterial::PointsMaterial(glm::vec4 color, float metalness) : Material::Mat
 
 PointsMaterial::PointsMaterial(float r, float g, float b, float metalness) : Material::Material(r, g, b, 1, metalness) {}
 
-void PointsMaterial::finalRender(unsigned int faceCount) const {
-	glDrawElements(GL_POINTS, this->alterFaceCount(faceCount), GL_UNSIGNED_INT, 0);
+GLenum PointsMaterial::getPrimitive() const { return GL_POINTS; }
+
+void PointsMaterial::finalRender(unsigned int faceCount, unsigned int instanceCount) const {
+	glDrawElementsInstanced(GL_POINTS, this->alterFaceCount(faceCount), GL_UNSIGNED_INT, 0, instanceCount);
 }
 
 PointsMaterial::~PointsMaterial() {}
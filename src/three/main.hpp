@@ -1,6 +1,11 @@
 #ifndef THREE_MAIN
 #define THREE_MAIN
 
+#define MAX_LIGHT 128  // doit rester identique à celui de src/shaders/default.frag
+
+#define CAMERA_BINDING 0  // points de liaison des blocs d'uniforms, communs à tous les programmes
+#define LIGHTS_BINDING 1
+
 #include "../maths/utils.hpp"
 #include "../opengl/main.hpp"
 #include "../lib/glad/glad.h"
@@ -9,8 +14,12 @@
 #include <GLFW/glfw3.h>
 #include <vector>
 #include <string>
+#include <map>
+#include <utility>
 #include <cmath>
 
+class Material;
+
 class Geometry {
   protected:
 	unsigned int m_vertexCount;
@@ -18,15 +27,29 @@ class Geometry {
 	unsigned int m_faceCount;
 	GLuint*      m_faces;
 	GLfloat*     m_normalVectors;
+	unsigned int m_id;       // unique, contrairement à l'adresse qu'une nouvelle géométrie peut reprendre
+	unsigned int m_version;  // incrémentée à chaque modification, pour invalider les buffers GPU
+
+	// Données entrelacées (position + normale) et indices par primitive, construits une seule fois à la demande
+	std::vector<GLfloat>                  m_verticesData;
+	std::map<GLenum, std::vector<GLuint>> m_facesData;
 
   public:
 	Geometry(unsigned int vertexCount, GLfloat* vertices, unsigned int faceCount, GLuint* faces, GLfloat* normalVectors);
+	Geometry(Geometry const&) = delete;
+	Geometry& operator=(Geometry const&) = delete;
 
 	unsigned int vertexCount() const;
 	GLfloat*     getVertices() const;
 	unsigned int faceCount() const;
 	GLuint*      getFaces() const;
 	GLfloat*&    getNormalVectors();
+	unsigned int getId() const;
+	unsigned int getVersion() const;
+	Geometry&    markDirty();
+
+	std::vector<GLfloat> const& getVerticesData();
+	std::vector<GLuint> const&  getFacesData(Material const& material);
 
 	~Geometry();
 };
@@ -46,46 +69,63 @@ class Material {
 	Material&            setMainColor(glm::vec4 color);
 	float                getMetalness() const;
 	Material&            setMetalness(float metalness);
-	virtual void         finalRender(unsigned int faceCount) const;
-	virtual GLuint*      getFacesData(unsigned int faceCount) const;
+	virtual GLenum       getPrimitive() const;
+	virtual void         finalRender(unsigned int faceCount, unsigned int instanceCount = 1) const;
+	virtual void         fillFacesData(std::vector<GLuint>& facesData, unsigned int faceCount) const;
 	virtual unsigned int alterFaceCount(unsigned int faceCount) const;
 
 	~Material();
 };
 
 
-class Mesh {
+class Mesh : public Transform {
   protected:
-	Geometry&      m_geometry;
-	Material&      m_material;
-	UnitQuaternion m_rotation;
-	glm::vec3      m_translation;
-	glm::vec3      m_scale;
+	Geometry& m_geometry;
+	Material& m_material;
 
   public:
 	Mesh(Geometry& geometry, Material& material);
 
-	Geometry&       getGeometry();
-	Material&       getMaterial();
-	UnitQuaternion& getRotation();
-	Mesh&           setRotation(UnitQuaternion& rotation);
-	glm::vec3&      getTranslation();
-	Mesh&           setTranslation(glm::vec3& translation);
-	glm::vec3&      getScale();
-	GLfloat*        getVerticesData() const;
-	unsigned int    faceCount() const;
-	Mesh&           translate(glm::vec3 translation);
-	Mesh&           translate(float dx, float dy, float dz);
-	Mesh&           rotateSelf(UnitQuaternion rotation, glm::vec3 point = glm::vec3(0));
-	Mesh&           rotateSelf(float angle, glm::vec3(axis), glm::vec3 point = glm::vec3(0));
-	Mesh&           rotateScene(UnitQuaternion rotation, glm::vec3 point = glm::vec3(0));
-	Mesh&           rotateScene(float angle, glm::vec3(axis), glm::vec3 point = glm::vec3(0));
-	glm::vec3       transform(glm::vec3 point) const;
-	glm::vec3       invertTransform(glm::vec3 point) const;
+	Geometry&    getGeometry();
+	Material&    getMaterial();
+	unsigned int faceCount() const;
+	glm::mat4    getModelMatrix(float alpha = 1) const;
+	glm::mat4    getRotationMatrix(float alpha = 1) const;
 
 	~Mesh();
 };
 
+// Buffers GPU d'un couple Geometry / Material, envoyés une seule fois puis réutilisés à chaque image.
+// Tous les meshes du couple sont dessinés en un seul appel instancié.
+// Le Renderer libère les buffers d'un couple dès qu'une image ne le dessine plus.
+class GeometryBuffer {
+  protected:
+	VAO                    m_VAO;
+	VBO                    m_VBO;
+	EBO                    m_EBO;
+	VBO                    m_instanceVBO;
+	bool                   m_uploaded;
+	unsigned int           m_geometryId;
+	unsigned int           m_version;
+	unsigned int           m_faceCount;  // nombre de faces envoyées
+	std::vector<glm::mat4> m_instances;  // (model, rotation) pour chaque instance, vidé après chaque rendu
+
+  public:
+	GeometryBuffer();
+
+	bool         isUpToDate(Geometry const& geometry) const;
+	void         upload(Mesh& mesh);
+	unsigned int getFaceCount() const;
+	void         addInstance(Mesh const& mesh, float alpha = 1);
+	unsigned int instanceCount() const;
+	void         bind();
+	void         uploadInstances();
+	void         clearInstances();
+	void         unBind();
+
+	~GeometryBuffer();
+};
+
 class Light {
   protected:
 	glm::vec3 m_position;
@@ -111,6 +151,7 @@ class Scene {
 	std::vector<Mesh*>  m_meshes;
 	std::vector<Light*> m_lights;
 	glm::vec3           m_backgroundColor;
+	unsigned int        m_lightsVersion;  // incrémentée à chaque changement des lumières
 
   public:
 	Scene(glm::vec3 backgroundColor = glm::vec3(0.07f, 0.13f, 0.17f));
@@ -120,6 +161,8 @@ class Scene {
 	glm::vec3&           getBackGroundColor();
 	unsigned int         getNbrLights() const;
 	std::vector<Light*>& getLights();
+	unsigned int         getLightsVersion() const;
+	Scene&               markLightsDirty();
 	Scene&               setBackGroundColor(glm::vec3 backgroundColor);
 	Scene&               setBackGroundColor(float r, float g, float b);
 	Scene&               add(Mesh* mesh);
@@ -161,18 +204,54 @@ class Camera {
 
 
 
+// Contenu des blocs d'uniforms, disposé selon les règles std140
+struct CameraBlock {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 position;
+};
+
+struct LightBlock {
+	glm::vec4 positionAmbient;  // xyz : position, w : 1 si lumière ambiante
+	glm::vec4 colorIntensity;   // rgb : couleur, a : intensité
+};
+
+struct LightsBlock {
+	GLuint     nbrLights;
+	GLuint     padding[3];
+	LightBlock lights[MAX_LIGHT];
+};
+
 class Renderer {
   protected:
-	Camera& m_camera;
-	Scene&  m_scene;
-	Shader  m_shader;
+	Camera&                                                    m_camera;
+	Scene&                                                     m_scene;
+	Shader                                                     m_shader;
+	std::map<std::pair<unsigned int, Material*>, GeometryBuffer*> m_buffers;  // par identifiant de Geometry et Material
+
+	// Caméra et lumières dans des UBO, renvoyés uniquement lorsqu'ils changent
+	UBO          m_cameraUBO;
+	UBO          m_lightsUBO;
+	CameraBlock  m_cameraBlock;
+	LightsBlock  m_lightsBlock;
+	bool         m_blocksUploaded;
+	unsigned int m_lightsVersion;
+
+	// Uniforms résolues une seule fois à la construction
+	Uniform<int>       m_screenWidthUniform;
+	Uniform<int>       m_screenHeightUniform;
+	Uniform<glm::vec4> m_objectColorUniform;
+	Uniform<float>     m_objectMetalnessUniform;
 
   public:
 	Renderer(Camera& camera, Scene& scene);
 
-	void initializeUniforms();
-	void clearScreen();
-	void render();
+	Shader&         getShader();
+	void            updateUniformBlocks();
+	void            clearScreen();
+	GeometryBuffer& getBuffer(Mesh& mesh);
+	Renderer&       clearBuffers();
+	void            render(float alpha = 1);
 
 	~Renderer();
 };
@@ -210,6 +289,20 @@ class SphereGeometry : public Geometry {
 	~SphereGeometry();
 };
 
+// Maillage d'une HeightMap, avec les mêmes triangles que la phase étroite. Sommets et normales sont propres à chaque instance ;
+// update les recalcule après une modification des hauteurs (nouveau terrain d'un curriculum) et marque la géométrie à renvoyer
+class HeightMapGeometry : public Geometry {
+  private:
+	std::vector<GLfloat> m_gridVertices;
+	std::vector<GLuint>  m_gridFaces;
+	std::vector<GLfloat> m_gridNormals;
+
+  public:
+	HeightMapGeometry(HeightMap const& heightMap);
+	HeightMapGeometry& update(HeightMap const& heightMap);
+	~HeightMapGeometry();
+};
+
 
 // Materials
 
@@ -225,8 +318,9 @@ class LinesMaterial : public Material {
 	LinesMaterial(glm::vec4 color = glm::vec4(1), float metalness = 1);
 	LinesMaterial(float r, float g, float b, float metalness = 1);
 
-	void         finalRender(unsigned int faceCount) const;
-	GLuint*      getFacesData(unsigned int faceCount) const;
+	GLenum       getPrimitive() const;
+	void         finalRender(unsigned int faceCount, unsigned int instanceCount = 1) const;
+	void         fillFacesData(std::vector<GLuint>& facesData, unsigned int faceCount) const;
 	unsigned int alterFaceCount(unsigned int faceCount) const;
 
 	~LinesMaterial();
@@ -244,7 +338,8 @@ class PointsMaterial : public Material {
 	PointsMaterial(glm::vec4 color = glm::vec4(1), float metalness = 1);
 	PointsMaterial(float r, float g, float b, float metalness = 1);
 
-	void finalRender(unsigned int faceCount) const;
+	GLenum getPrimitive() const;
+	void   finalRender(unsigned int faceCount, unsigned int instanceCount = 1) const;
 
 	~PointsMaterial();
 };
@@ -0,0 +1,161 @@
+#include "main.hpp"
+#include "../maths/utils.hpp"
+#include "../physics/main.hpp"
+#include "../physics/scheduler.hpp"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+
+
+/* --- ENVIRONMENT --- */
+
+
+
+Environment::Environment(float gravityIntensity) : m_planet(gravityIntensity) {}
+
+Planet& Environment::getPlanet() { return m_planet; }
+
+Environment::~Environment() {}
+
+
+
+/* --- VECPLANET --- */
+
+
+
+VecPlanet::VecPlanet(unsigned int nbrEnvironments, function<Environment*(unsigned int)> factory, double deltaTime, unsigned int frameSkip,
+                     unsigned int nbrThreads)
+    : m_environments(vector<Environment*>()),
+      m_threadPool(min(max(nbrThreads, 1u), max(nbrEnvironments, 1u))),
+      m_deltaTime(deltaTime),
+      m_frameSkip(max(frameSkip, 1u)),
+      m_observationSize(0),
+      m_actionSize(0) {
+	for (unsigned int i = 0; i < nbrEnvironments; i++) {
+		m_environments.push_back(factory(i));
+	}
+
+	if (!m_environments.empty()) {
+		m_observationSize = m_environments[0]->getObservationSize();
+		m_actionSize = m_environments[0]->getActionSize();
+	}
+
+	m_observations = vector<float>(nbrEnvironments * m_observationSize, 0);
+	m_rewards = vector<float>(nbrEnvironments, 0);
+	m_dones = vector<unsigned char>(nbrEnvironments, 0);
+}
+
+unsigned int         VecPlanet::getNbrEnvironments() const { return m_environments.size(); }
+unsigned int         VecPlanet::getObservationSize() const { return m_observationSize; }
+unsigned int         VecPlanet::getActionSize() const { return m_actionSize; }
+Environment&         VecPlanet::getEnvironment(unsigned int index) { return *m_environments[index]; }
+const float*         VecPlanet::getObservations() const { return m_observations.data(); }
+const float*         VecPlanet::getRewards() const { return m_rewards.data(); }
+const unsigned char* VecPlanet::getDones() const { return m_dones.data(); }
+
+void VecPlanet::reset() {
+	m_threadPool.parallelFor(m_environments.size(), [&](unsigned int i) {
+		m_environments[i]->reset();
+		m_environments[i]->observe(&m_observations[i * m_observationSize]);
+		m_rewards[i] = 0;
+		m_dones[i] = 0;
+	});
+}
+
+// Chaque environnement n'écrit que dans sa propre tranche des buffers : aucune synchronisation nécessaire
+void VecPlanet::stepEnvironment(unsigned int index, const float* actions) {
+	Environment* environment = m_environments[index];
+
+	for (unsigned int i = 0; i < m_frameSkip; i++) {
+		environment->applyAction(&actions[index * m_actionSize]);
+		environment->getPlanet().step(m_deltaTime);
+	}
+
+	m_rewards[index] = environment->getReward();
+	m_dones[index] = environment->isDone() ? 1 : 0;
+
+	// Un épisode terminé est relancé aussitôt, l'observation renvoyée est alors celle du nouvel épisode
+	if (m_dones[index]) {
+		environment->reset();
+	}
+	environment->observe(&m_observations[index * m_observationSize]);
+}
+
+void VecPlanet::step(const float* actions) {
+	m_threadPool.parallelFor(m_environments.size(), [&](unsigned int i) { this->stepEnvironment(i, actions); });
+}
+
+VecPlanet::~VecPlanet() {
+	for (Environment* environment : m_environments) {
+		delete environment;
+	}
+}
+
+
+
+/* --- STICKSENVIRONMENT --- */
+
+
+
+static vector<Mass> stickMasses() {
+	return {Mass(1, glm::vec3(-0.5, 0.5, 0)), Mass(1, glm::vec3(0.5, 0.5, 0)), Mass(1, glm::vec3(0, -0.5, 0))};
+}
+
+SticksEnvironment::SticksEnvironment(unsigned int maxSteps)
+    : Environment::Environment(),
+      m_stick1(),
+      m_stick2(),
+      m_solid1(stickMasses()),
+      m_solid2(stickMasses()),
+      m_worldObject1({}, m_solid1, m_stick1),
+      m_worldObject2({}, m_solid2, m_stick2),
+      m_joint(&m_worldObject1, glm::vec3(0, 3, 0), &m_worldObject2, glm::vec3(0, -3, 0)),
+      m_skeleton({&m_worldObject1, &m_worldObject2}, {&m_joint}),
+      m_stepCount(0),
+      m_maxSteps(maxSteps) {
+	m_planet.add(&m_skeleton);
+	this->reset();
+}
+
+unsigned int SticksEnvironment::getObservationSize() const { return 12; }
+unsigned int SticksEnvironment::getActionSize() const { return 6; }
+
+void SticksEnvironment::reset() {
+	m_stick1.setTranslation(glm::vec3(-3, -6.01, 1)).setRotation(UnitQuaternion());
+	m_stick2.setTranslation(glm::vec3(0)).setRotation(UnitQuaternion());
+	m_worldObject1.pullTransform().setSpeedVector(glm::vec3(0)).setAngularMomentum(glm::vec3(0));
+	m_worldObject2.pullTransform().setSpeedVector(glm::vec3(0)).setAngularMomentum(glm::vec3(0));
+	m_stepCount = 0;
+}
+
+// action : direction de la force appliquée au bas du premier bâton puis au haut du second
+void SticksEnvironment::applyAction(const float* action) {
+	m_worldObject1.applyForce(Force(glm::vec3(0, -3, 0), glm::vec3(action[0], action[1], action[2])));
+	m_worldObject2.applyForce(Force(glm::vec3(0, 3, 0), glm::vec3(action[3], action[4], action[5])));
+	m_stepCount++;
+}
+
+// observation : position puis vitesse de chaque bâton
+void SticksEnvironment::observe(float* observation) {
+	glm::vec3 values[4] = {m_stick1.getTranslation(), m_worldObject1.getSpeedVector(), m_stick2.getTranslation(),
+	                       m_worldObject2.getSpeedVector()};
+	for (unsigned int i = 0; i < 4; i++) {
+		observation[i * 3] = values[i].x;
+		observation[i * 3 + 1] = values[i].y;
+		observation[i * 3 + 2] = values[i].z;
+	}
+}
+
+// Récompense la hauteur atteinte par le second bâton, y étant la verticale comme partout dans le moteur
+float SticksEnvironment::getReward() { return m_stick2.getTranslation().y; }
+
+bool SticksEnvironment::isDone() {
+	return m_stepCount >= m_maxSteps || glm::length(m_stick1.getTranslation()) > 100 || glm::length(m_stick2.getTranslation()) > 100;
+}
+
+SticksEnvironment::~SticksEnvironment() {}
@@ -0,0 +1,95 @@
+#ifndef TRAINING_MAIN
+#define TRAINING_MAIN
+
+#include "../maths/utils.hpp"
+#include "../physics/main.hpp"
+#include "../physics/scheduler.hpp"
+
+#include <glm/glm.hpp>
+#include <functional>
+#include <vector>
+
+// Un environnement d'apprentissage : son propre monde physique, une action en entrée, une observation et une récompense en sortie
+class Environment {
+  protected:
+	Planet m_planet;
+
+  public:
+	Environment(float gravityIntensity = 9.81);
+
+	Planet&              getPlanet();
+	virtual unsigned int getObservationSize() const = 0;
+	virtual unsigned int getActionSize() const = 0;
+	virtual void         reset() = 0;
+	virtual void         applyAction(const float* action) = 0;  // appelée avant chaque pas de physique
+	virtual void         observe(float* observation) = 0;
+	virtual float        getReward() = 0;
+	virtual bool         isDone() = 0;
+
+	virtual ~Environment();
+};
+
+// N environnements indépendants avancés ensemble, avec des entrées et sorties contiguës
+class VecPlanet {
+  private:
+	std::vector<Environment*>  m_environments;
+	ThreadPool                 m_threadPool;
+	double                     m_deltaTime;
+	unsigned int               m_frameSkip;  // nombre de pas de physique par action, les moteurs gardent leurs cibles entre deux
+	unsigned int               m_observationSize;
+	unsigned int               m_actionSize;
+	std::vector<float>         m_observations;  // nbrEnvironments * observationSize
+	std::vector<float>         m_rewards;       // nbrEnvironments
+	std::vector<unsigned char> m_dones;         // nbrEnvironments, 1 si l'épisode vient de se terminer
+
+	void stepEnvironment(unsigned int index, const float* actions);
+
+  public:
+	VecPlanet(unsigned int nbrEnvironments, std::function<Environment*(unsigned int)> factory, double deltaTime = 1.0 / 240,
+	          unsigned int frameSkip = 1, unsigned int nbrThreads = std::thread::hardware_concurrency());
+
+	unsigned int         getNbrEnvironments() const;
+	unsigned int         getObservationSize() const;
+	unsigned int         getActionSize() const;
+	Environment&         getEnvironment(unsigned int index);
+	const float*         getObservations() const;
+	const float*         getRewards() const;
+	const unsigned char* getDones() const;
+	void                 reset();
+	void                 step(const float* actions);  // actions : nbrEnvironments * actionSize
+
+	~VecPlanet();
+};
+
+
+// Environnements
+
+// Les deux bâtons reliés de firstPhysicsScene, poussés par une force sur chacun
+class SticksEnvironment : public Environment {
+  private:
+	Transform    m_stick1;
+	Transform    m_stick2;
+	Solid        m_solid1;
+	Solid        m_solid2;
+	WorldObject  m_worldObject1;
+	WorldObject  m_worldObject2;
+	BallJoint    m_joint;
+	Skeleton     m_skeleton;
+	unsigned int m_stepCount;
+	unsigned int m_maxSteps;
+
+  public:
+	SticksEnvironment(unsigned int maxSteps = 1000);
+
+	unsigned int getObservationSize() const;
+	unsigned int getActionSize() const;
+	void         reset();
+	void         applyAction(const float* action);
+	void         observe(float* observation);
+	float        getReward();
+	bool         isDone();
+
+	~SticksEnvironment();
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "recorder.hpp"
+#include "main.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+
+
+
+static const char         recordMagic[4] = {'E', 'M', 'P', 'R'};
+static const unsigned int recordVersion = 1;
+
+
+
+/* --- RECORDER --- */
+
+
+
+Recorder::Recorder(string const& path, Environment& environment, uint64_t seed, double deltaTime)
+    : m_file(path, ios::binary), m_environment(environment), m_deltaTime(deltaTime), m_nbrSteps(0) {
+	if (!m_file) {
+		cerr << "Error: Could not open record file " << path << endl;
+		return;
+	}
+
+	RecordHeader header;
+	memcpy(header.magic, recordMagic, 4);
+	header.version = recordVersion;
+	header.actionSize = environment.getActionSize();
+	header.padding = 0;
+	header.seed = seed;
+	header.deltaTime = deltaTime;
+	m_file.write((const char*)&header, sizeof(header));
+
+	environment.getPlanet().setDeterministic(true, seed);
+	environment.reset();
+}
+
+bool         Recorder::isOpen() const { return m_file.is_open() && m_file.good(); }
+unsigned int Recorder::getNbrSteps() const { return m_nbrSteps; }
+
+// Même enchaînement que VecPlanet::stepEnvironment, l'empreinte étant prise avant un éventuel reset
+void Recorder::step(const float* action) {
+	m_environment.applyAction(action);
+	m_environment.getPlanet().step(m_deltaTime);
+	uint64_t hash = m_environment.getPlanet().hashState();
+
+	if (this->isOpen()) {
+		m_file.write((const char*)action, sizeof(float) * m_environment.getActionSize());
+		m_file.write((const char*)&hash, sizeof(hash));
+		m_nbrSteps++;
+	}
+
+	if (m_environment.isDone()) {
+		m_environment.reset();
+	}
+}
+
+Recorder::~Recorder() {}
+
+
+
+/* --- REPLAYER --- */
+
+
+
+Replayer::Replayer(string const& path) : m_file(path, ios::binary), m_header(), m_valid(false), m_action(vector<float>()), m_hash(0) {
+	if (!m_file) {
+		cerr << "Error: Could not open record file " << path << endl;
+		return;
+	}
+
+	m_file.read((char*)&m_header, sizeof(m_header));
+	if (!m_file || memcmp(m_header.magic, recordMagic, 4) != 0 || m_header.version != recordVersion) {
+		cerr << "Error: " << path << " is not a record file" << endl;
+		return;
+	}
+
+	m_valid = true;
+	m_action = vector<float>(m_header.actionSize, 0);
+}
+
+bool     Replayer::isOpen() const { return m_valid; }
+uint64_t Replayer::getSeed() const { return m_header.seed; }
+double   Replayer::getDeltaTime() const { return m_header.deltaTime; }
+
+bool Replayer::next() {
+	if (m_file.peek() == ifstream::traits_type::eof()) {
+		return false;
+	}
+	m_file.read((char*)m_action.data(), sizeof(float) * m_action.size());
+	m_file.read((char*)&m_hash, sizeof(m_hash));
+	if (!m_file) {
+		cerr << "Error: Record file is truncated" << endl;
+		m_valid = false;
+	}
+	return m_valid;
+}
+
+int Replayer::replay(Environment& environment) {
+	if (!m_valid) {
+		return REPLAY_ERROR;
+	}
+	if (environment.getActionSize() != m_header.actionSize) {
+		cerr << "Error: Record made with actions of size " << m_header.actionSize << ", environment expects " << environment.getActionSize()
+		     << endl;
+		return REPLAY_ERROR;
+	}
+
+	environment.getPlanet().setDeterministic(true, m_header.seed);
+	environment.reset();
+
+	for (int step = 0; this->next(); step++) {
+		environment.applyAction(m_action.data());
+		environment.getPlanet().step(m_header.deltaTime);
+		if (environment.getPlanet().hashState() != m_hash) {
+			cerr << "Replay diverged at step " << step << endl;
+			return step;
+		}
+
+		if (environment.isDone()) {
+			environment.reset();
+		}
+	}
+	return m_valid ? REPLAY_IDENTICAL : REPLAY_ERROR;
+}
+
+Replayer::~Replayer() {}
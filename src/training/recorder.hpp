@@ -0,0 +1,67 @@
+#ifndef TRAINING_RECORDER
+#define TRAINING_RECORDER
+
+#include "main.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Fichier binaire d'un épisode : un en-tête (magie "EMPR", version, taille des actions, graine, pas de temps),
+// puis pour chaque pas l'action appliquée et l'empreinte de l'état qui en a résulté
+struct RecordHeader {
+	char     magic[4];
+	uint32_t version;
+	uint32_t actionSize;
+	uint32_t padding;
+	uint64_t seed;
+	double   deltaTime;
+};
+
+// Enregistre les actions appliquées à un environnement, pas par pas.
+// L'environnement est passé en mode déterministe avec la graine donnée puis réinitialisé : il doit sortir de sa construction,
+// les caches des solveurs (impulsions des liaisons et des contacts) d'un épisode précédent n'étant pas remis à zéro par reset
+class Recorder {
+  private:
+	std::ofstream m_file;
+	Environment&  m_environment;
+	double        m_deltaTime;
+	unsigned int  m_nbrSteps;
+
+  public:
+	Recorder(std::string const& path, Environment& environment, uint64_t seed = 0, double deltaTime = 1.0 / 240);
+
+	bool         isOpen() const;
+	unsigned int getNbrSteps() const;
+	void         step(const float* action);  // applique l'action, avance d'un pas puis enregistre ; reset en fin d'épisode
+
+	~Recorder();
+};
+
+const int REPLAY_IDENTICAL = -1;  // tous les pas reproduits
+const int REPLAY_ERROR = -2;      // fichier illisible, tronqué ou fait pour un autre environnement
+
+// Rejoue un enregistrement sur un environnement identique et vérifie l'empreinte de l'état après chaque pas
+class Replayer {
+  private:
+	std::ifstream      m_file;
+	RecordHeader       m_header;
+	bool               m_valid;
+	std::vector<float> m_action;
+	uint64_t           m_hash;
+
+	bool next();  // lit le pas suivant, faux en fin de fichier ou sur un pas tronqué (m_valid passe alors à faux)
+
+  public:
+	Replayer(std::string const& path);
+
+	bool     isOpen() const;
+	uint64_t getSeed() const;
+	double   getDeltaTime() const;
+	int      replay(Environment& environment);  // premier pas divergent, REPLAY_IDENTICAL ou REPLAY_ERROR
+
+	~Replayer();
+};
+
+#endif